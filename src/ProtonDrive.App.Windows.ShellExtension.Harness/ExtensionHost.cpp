@@ -0,0 +1,66 @@
+#include "pch.h"
+#include "ExtensionHost.h"
+
+using namespace std;
+using namespace ATL;
+
+// ContextMenuHandler coclass in WindowsShellExtension.idl
+constexpr CLSID CLSID_CONTEXT_MENU_HANDLER = { 0x434cac7a, 0xcb48, 0x4832, { 0x8f, 0x85, 0x83, 0xad, 0xe7, 0xe5, 0x2d, 0xac } };
+
+_Success_(return == true) bool ExtensionHost::TryLoad(_In_ const filesystem::path& extensionPath)
+{
+    const auto module = LoadLibraryEx(extensionPath.c_str(), nullptr, LOAD_LIBRARY_SEARCH_DLL_LOAD_DIR | LOAD_LIBRARY_SEARCH_DEFAULT_DIRS);
+    if (module == nullptr)
+    {
+        return false;
+    }
+
+    const auto getClassObject = reinterpret_cast<LPFNGETCLASSOBJECT>(GetProcAddress(module, "DllGetClassObject"));
+    if (getClassObject == nullptr)
+    {
+        return false;
+    }
+
+    return SUCCEEDED(getClassObject(CLSID_CONTEXT_MENU_HANDLER, IID_PPV_ARGS(&m_contextMenuHandlerFactory)));
+}
+
+HRESULT ExtensionHost::CreateContextMenuHandler(_Out_ CComPtr<IContextMenu>& contextMenu) const
+{
+    contextMenu.Release();
+
+    if (!m_contextMenuHandlerFactory)
+    {
+        return E_UNEXPECTED;
+    }
+
+    return m_contextMenuHandlerFactory->CreateInstance(nullptr, IID_PPV_ARGS(&contextMenu));
+}
+
+HRESULT CreateSelectionDataObject(_In_ const vector<wstring>& paths, _Out_ CComPtr<IDataObject>& dataObject)
+{
+    dataObject.Release();
+
+    vector<CComHeapPtr<ITEMIDLIST_ABSOLUTE>> itemIdLists(paths.size());
+    vector<PCIDLIST_ABSOLUTE> itemIdListPointers;
+    itemIdListPointers.reserve(paths.size());
+
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        const auto result = SHParseDisplayName(paths[i].c_str(), nullptr, &itemIdLists[i], 0, nullptr);
+        if (FAILED(result))
+        {
+            return result;
+        }
+
+        itemIdListPointers.push_back(itemIdLists[i]);
+    }
+
+    CComPtr<IShellItemArray> shellItems;
+    const auto result = SHCreateShellItemArrayFromIDLists(static_cast<UINT>(itemIdListPointers.size()), itemIdListPointers.data(), &shellItems);
+    if (FAILED(result))
+    {
+        return result;
+    }
+
+    return shellItems->BindToHandler(nullptr, BHID_DataObject, IID_PPV_ARGS(&dataObject));
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "pch.h"
+
+/// Loads the shell extension without registering it and drives its context menu handler the way Explorer does.
+/// The extension is never unloaded, as it may keep threads running.
+class ExtensionHost
+{
+public:
+    _Success_(return == true) bool TryLoad(_In_ const std::filesystem::path& extensionPath);
+
+    /// Creates a new handler, Explorer creates one for every context menu
+    [[nodiscard]] HRESULT CreateContextMenuHandler(_Out_ ATL::CComPtr<IContextMenu>& contextMenu) const;
+
+private:
+    ATL::CComPtr<IClassFactory> m_contextMenuHandlerFactory;
+};
+
+/// Creates the data object Explorer passes to IShellExtInit::Initialize for the selected items
+[[nodiscard]] HRESULT CreateSelectionDataObject(_In_ const std::vector<std::wstring>& paths, _Out_ ATL::CComPtr<IDataObject>& dataObject);
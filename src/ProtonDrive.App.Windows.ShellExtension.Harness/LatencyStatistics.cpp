@@ -0,0 +1,42 @@
+#include "pch.h"
+#include "LatencyStatistics.h"
+
+using namespace std;
+
+LatencyStatistics GetLatencyStatistics(_In_ vector<uint64_t> samples)
+{
+    if (samples.empty())
+    {
+        return {};
+    }
+
+    ranges::sort(samples);
+
+    const auto getPercentile = [&samples](const size_t percent)
+    {
+        const auto rank = (samples.size() * percent + 99) / 100;
+        return samples[(std::max)(rank, size_t { 1 }) - 1];
+    };
+
+    return { samples.size(), getPercentile(50), getPercentile(95), getPercentile(99), samples.back() };
+}
+
+Stopwatch::Stopwatch()
+{
+    QueryPerformanceCounter(&m_startTime);
+}
+
+uint64_t Stopwatch::GetElapsedMicroseconds() const
+{
+    LARGE_INTEGER endTime;
+    QueryPerformanceCounter(&endTime);
+
+    static const auto frequency = []
+    {
+        LARGE_INTEGER value;
+        QueryPerformanceFrequency(&value);
+        return value.QuadPart;
+    }();
+
+    return static_cast<uint64_t>(endTime.QuadPart - m_startTime.QuadPart) * 1'000'000 / static_cast<uint64_t>(frequency);
+}
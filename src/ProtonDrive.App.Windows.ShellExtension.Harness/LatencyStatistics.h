@@ -0,0 +1,27 @@
+#pragma once
+
+#include "pch.h"
+
+struct LatencyStatistics
+{
+    size_t count = 0;
+    uint64_t p50 = 0;
+    uint64_t p95 = 0;
+    uint64_t p99 = 0;
+    uint64_t max = 0;
+};
+
+/// Nearest-rank percentiles of the samples, in the unit of the samples
+[[nodiscard]] LatencyStatistics GetLatencyStatistics(_In_ std::vector<uint64_t> samples);
+
+/// Measures the time elapsed since its construction
+class Stopwatch
+{
+public:
+    Stopwatch();
+
+    [[nodiscard]] uint64_t GetElapsedMicroseconds() const;
+
+private:
+    LARGE_INTEGER m_startTime;
+};
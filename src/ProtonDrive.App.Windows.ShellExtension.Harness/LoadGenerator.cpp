@@ -0,0 +1,193 @@
+#include "pch.h"
+#include "LoadGenerator.h"
+
+#include "IpcContracts.h"
+#include "LatencyStatistics.h"
+#include "Replay.h"
+#include "StandInServer.h"
+
+using namespace std;
+using namespace ATL;
+
+constexpr auto SYNC_ROOT_PATHS_QUERY = "SyncRootPathsQuery";
+constexpr auto REMOTE_IDS_QUERY = "RemoteIdsQuery";
+
+enum struct QueryOutcome
+{
+    Succeeded,
+    PipeBusy,
+    NoServer,
+    Failed,
+    Count,
+};
+
+struct ClientResults
+{
+    map<string, vector<uint64_t>> latencies;
+    map<string, array<uint64_t, static_cast<size_t>(QueryOutcome::Count)>> outcomes;
+};
+
+QueryOutcome SendQuery(_In_ const string& messageType, _In_ const wstring& remoteIdsQueryPath)
+{
+    _ATLTRY
+    {
+        SetLastError(ERROR_SUCCESS);
+
+        bool succeeded;
+        if (messageType == SYNC_ROOT_PATHS_QUERY)
+        {
+            vector<wstring> syncRootPaths;
+            succeeded = TrySendIpcMessage(
+                SyncRootPathsQueryRequest({ SyncRootType::CloudFiles, SyncRootType::HostDeviceFolder, SyncRootType::ForeignDevice }),
+                syncRootPaths);
+        }
+        else
+        {
+            optional<RemoteIdsQueryResponse> remoteIds;
+            succeeded = TrySendIpcMessage(RemoteIdsQueryRequest(remoteIdsQueryPath), remoteIds);
+        }
+
+        if (succeeded)
+        {
+            return QueryOutcome::Succeeded;
+        }
+
+        // The client gives up connecting after a few attempts while all pipe instances are busy
+        switch (GetLastError())
+        {
+        case ERROR_PIPE_BUSY:
+        case ERROR_SEM_TIMEOUT:
+            return QueryOutcome::PipeBusy;
+
+        case ERROR_FILE_NOT_FOUND:
+            return QueryOutcome::NoServer;
+
+        default:
+            return QueryOutcome::Failed;
+        }
+    }
+    _ATLCATCHALL()
+    {
+        return QueryOutcome::Failed;
+    }
+}
+
+void RunClient(_In_ const LoadGeneratorOptions& options, _In_ const size_t clientIndex, _In_ const ULONGLONG endTime, _Out_ ClientResults& results)
+{
+    const auto mixLength = options.syncRootPathsQueryWeight + options.remoteIdsQueryWeight;
+
+    // Clients send at evenly spaced times regardless of how long responses take, so that a slow server does not lower the load
+    const auto interval = options.requestsPerSecond > 0
+        ? chrono::duration<double>(static_cast<double>(options.numberOfClients) / options.requestsPerSecond)
+        : chrono::duration<double>::zero();
+
+    const auto startTime = chrono::steady_clock::now();
+
+    for (size_t requestIndex = 0; GetTickCount64() < endTime; ++requestIndex)
+    {
+        if (interval > chrono::duration<double>::zero())
+        {
+            this_thread::sleep_until(startTime + chrono::duration_cast<chrono::steady_clock::duration>(interval * static_cast<double>(requestIndex)));
+        }
+
+        const auto& messageType = (clientIndex + requestIndex) % mixLength < options.syncRootPathsQueryWeight ? SYNC_ROOT_PATHS_QUERY : REMOTE_IDS_QUERY;
+
+        const Stopwatch stopwatch;
+        const auto outcome = SendQuery(messageType, options.remoteIdsQueryPath);
+        const auto elapsedMicroseconds = stopwatch.GetElapsedMicroseconds();
+
+        ++results.outcomes[messageType][static_cast<size_t>(outcome)];
+
+        if (outcome == QueryOutcome::Succeeded)
+        {
+            results.latencies[messageType].push_back(elapsedMicroseconds);
+        }
+    }
+}
+
+int GenerateLoad(_In_ const LoadGeneratorOptions& options)
+{
+    if (options.numberOfClients == 0 || options.syncRootPathsQueryWeight + options.remoteIdsQueryWeight == 0)
+    {
+        cerr << "At least one client and one query type are required" << endl;
+        return 2;
+    }
+
+    StandInServer server({ { static_cast<int>(SyncRootType::CloudFiles), filesystem::path(options.remoteIdsQueryPath).parent_path().native() } }, {});
+    if (options.useStandInServer && !server.TryStart())
+    {
+        cerr << "The pipe of the app is already served, close the app or run without --stand-in" << endl;
+        return 2;
+    }
+
+    vector<ClientResults> results(options.numberOfClients);
+    vector<thread> clients;
+    clients.reserve(options.numberOfClients);
+
+    const Stopwatch stopwatch;
+    const auto endTime = GetTickCount64() + options.durationMilliseconds;
+
+    for (size_t i = 0; i < options.numberOfClients; ++i)
+    {
+        clients.emplace_back(RunClient, cref(options), i, endTime, ref(results[i]));
+    }
+
+    for (auto& client : clients)
+    {
+        client.join();
+    }
+
+    const auto elapsedSeconds = static_cast<double>(stopwatch.GetElapsedMicroseconds()) / 1'000'000;
+
+    server.Stop();
+
+    map<string, vector<uint64_t>> latencies;
+    map<string, array<uint64_t, static_cast<size_t>(QueryOutcome::Count)>> outcomes;
+    for (auto& clientResults : results)
+    {
+        for (auto& [messageType, samples] : clientResults.latencies)
+        {
+            latencies[messageType].insert(latencies[messageType].end(), samples.begin(), samples.end());
+        }
+
+        for (const auto& [messageType, counts] : clientResults.outcomes)
+        {
+            auto& totalCounts = outcomes[messageType];
+            for (size_t i = 0; i < counts.size(); ++i)
+            {
+                totalCounts[i] += counts[i];
+            }
+        }
+    }
+
+    uint64_t numberOfSucceeded = 0;
+    uint64_t numberOfQueries = 0;
+
+    cout << format("{} clients for {:.1f} s", options.numberOfClients, elapsedSeconds) << endl;
+    cout << format("{:<32}{:>10}{:>10}{:>10}{:>10}{:>10}{:>10}", "Query", "Sent", "Answered", "Busy", "No server", "Failed", "Busy %") << endl;
+
+    for (const auto& [messageType, counts] : outcomes)
+    {
+        const auto numberOfSent = counts[0] + counts[1] + counts[2] + counts[3];
+        const auto numberOfPipeBusy = counts[static_cast<size_t>(QueryOutcome::PipeBusy)];
+
+        cout << format(
+            "{:<32}{:>10}{:>10}{:>10}{:>10}{:>10}{:>10.2f}",
+            messageType,
+            numberOfSent,
+            counts[static_cast<size_t>(QueryOutcome::Succeeded)],
+            numberOfPipeBusy,
+            counts[static_cast<size_t>(QueryOutcome::NoServer)],
+            counts[static_cast<size_t>(QueryOutcome::Failed)],
+            numberOfSent > 0 ? 100.0 * static_cast<double>(numberOfPipeBusy) / static_cast<double>(numberOfSent) : 0.0) << endl;
+
+        numberOfSucceeded += counts[static_cast<size_t>(QueryOutcome::Succeeded)];
+        numberOfQueries += numberOfSent;
+    }
+
+    cout << format("Throughput: {:.0f} answered queries/s of {:.0f} sent/s", numberOfSucceeded / elapsedSeconds, numberOfQueries / elapsedSeconds) << endl;
+
+    (void)PrintLatencies(latencies, {});
+
+    return 0;
+}
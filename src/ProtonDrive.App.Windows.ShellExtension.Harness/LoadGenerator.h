@@ -0,0 +1,28 @@
+#pragma once
+
+#include "pch.h"
+
+struct LoadGeneratorOptions
+{
+    size_t numberOfClients = 8;
+
+    /// Target rate of all clients together, zero to send as fast as the server answers
+    double requestsPerSecond = 0;
+
+    DWORD durationMilliseconds = 10000;
+
+    /// Relative number of each query type in the mix
+    size_t syncRootPathsQueryWeight = 3;
+    size_t remoteIdsQueryWeight = 1;
+
+    /// Path asked for in remote ID queries
+    std::wstring remoteIdsQueryPath;
+
+    /// Serves the pipe with the stand-in server instead of expecting the app to run
+    bool useStandInServer = false;
+};
+
+/// Sends sync root path and remote ID queries from concurrent clients using the IPC client code of the shell extension,
+/// and prints the throughput, the connection failures because all pipe instances are busy, and the latency distribution.
+/// Returns the process exit code.
+[[nodiscard]] int GenerateLoad(_In_ const LoadGeneratorOptions& options);
@@ -0,0 +1,95 @@
+#include "pch.h"
+#include "Replay.h"
+
+#include "LatencyStatistics.h"
+
+using namespace std;
+using namespace ATL;
+
+constexpr UINT FIRST_MENU_COMMAND_ID = 1;
+constexpr UINT LAST_MENU_COMMAND_ID = 0x7fff;
+
+int Replay(_In_ const ExtensionHost& extensionHost, _In_ Trace trace, _In_ const filesystem::path& workingFolder)
+{
+    MaterializeTrace(trace, workingFolder);
+
+    CComPtr<IDataObject> dataObject;
+    ATLENSURE_SUCCEEDED(CreateSelectionDataObject(trace.selectedPaths, dataObject));
+
+    StandInServer server(trace.syncRoots, trace.responseDelays);
+    if (trace.isAppRunning && !server.TryStart())
+    {
+        cerr << "The pipe of the app is already served, close the app before replaying traces" << endl;
+        return 2;
+    }
+
+    map<string, vector<uint64_t>> samplesByPhase;
+    auto& initializeSamples = samplesByPhase["Initialize"];
+    auto& queryContextMenuSamples = samplesByPhase["QueryContextMenu"];
+    auto numberOfMenuItems = 0U;
+
+    for (size_t iteration = 0; iteration < trace.numberOfIterations; ++iteration)
+    {
+        CComPtr<IContextMenu> contextMenu;
+        ATLENSURE_SUCCEEDED(extensionHost.CreateContextMenuHandler(contextMenu));
+
+        CComQIPtr<IShellExtInit> shellExtensionInitialization(contextMenu);
+        ATLENSURE(shellExtensionInitialization);
+
+        {
+            const Stopwatch stopwatch;
+            ATLENSURE_SUCCEEDED(shellExtensionInitialization->Initialize(nullptr, dataObject, nullptr));
+            initializeSamples.push_back(stopwatch.GetElapsedMicroseconds());
+        }
+
+        const auto menuHandle = CreatePopupMenu();
+        ATLENSURE(menuHandle != nullptr);
+
+        {
+            const Stopwatch stopwatch;
+            const auto result = contextMenu->QueryContextMenu(menuHandle, 0, FIRST_MENU_COMMAND_ID, LAST_MENU_COMMAND_ID, CMF_NORMAL);
+            queryContextMenuSamples.push_back(stopwatch.GetElapsedMicroseconds());
+
+            numberOfMenuItems = SUCCEEDED(result) ? HRESULT_CODE(result) : 0;
+        }
+
+        DestroyMenu(menuHandle);
+    }
+
+    server.Stop();
+
+    cout << format("{}: {} items selected, {} iterations, {} menu items shown", trace.name, trace.selectedPaths.size(), trace.numberOfIterations, numberOfMenuItems) << endl;
+
+    const auto isWithinBudget = PrintLatencies(samplesByPhase, trace.p99Budgets);
+
+    for (const auto& [messageType, numberOfMessages] : server.GetNumberOfMessages())
+    {
+        cout << format("{:<32}{:>10} messages", messageType, numberOfMessages) << endl;
+    }
+
+    return isWithinBudget ? 0 : 1;
+}
+
+_Success_(return == true) bool PrintLatencies(_In_ const map<string, vector<uint64_t>>& samplesByPhase, _In_ const map<string, uint64_t>& p99Budgets)
+{
+    auto isWithinBudget = true;
+
+    cout << format("{:<32}{:>10}{:>10}{:>10}{:>10}{:>10}  (microseconds)", "Phase", "Count", "p50", "p95", "p99", "Max") << endl;
+
+    for (const auto& [phase, samples] : samplesByPhase)
+    {
+        const auto statistics = GetLatencyStatistics(samples);
+
+        cout << format("{:<32}{:>10}{:>10}{:>10}{:>10}{:>10}", phase, statistics.count, statistics.p50, statistics.p95, statistics.p99, statistics.max);
+
+        if (const auto budget = p99Budgets.find(phase); budget != p99Budgets.end() && statistics.p99 > budget->second)
+        {
+            cout << format("  over the p99 budget of {}", budget->second);
+            isWithinBudget = false;
+        }
+
+        cout << endl;
+    }
+
+    return isWithinBudget;
+}
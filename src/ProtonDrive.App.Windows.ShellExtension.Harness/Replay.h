@@ -0,0 +1,14 @@
+#pragma once
+
+#include "pch.h"
+#include "ExtensionHost.h"
+#include "Trace.h"
+
+/// Shows the context menu for the selection of the trace as many times as the trace says, against the stand-in server,
+/// and prints the latency percentiles of each phase. Returns the process exit code, non-zero if a phase is over budget.
+[[nodiscard]] int Replay(_In_ const ExtensionHost& extensionHost, _In_ Trace trace, _In_ const std::filesystem::path& workingFolder);
+
+/// Prints the percentiles of the samples of each phase, and returns false if a phase is over its budget
+_Success_(return == true) bool PrintLatencies(
+    _In_ const std::map<std::string, std::vector<uint64_t>>& samplesByPhase,
+    _In_ const std::map<std::string, uint64_t>& p99Budgets);
@@ -0,0 +1,200 @@
+#include "pch.h"
+#include "Soak.h"
+
+using namespace std;
+using namespace ATL;
+
+constexpr UINT FIRST_MENU_COMMAND_ID = 1;
+constexpr UINT LAST_MENU_COMMAND_ID = 0x7fff;
+
+// Sends a command the stand-in server does not answer, without showing any window or changing any file
+constexpr wstring_view INVOKED_VERB = L"shareByProtonDriveUrl";
+
+// Caches fill and the threads of the extension start during the first cycles
+constexpr size_t NUMBER_OF_WARM_UP_CYCLES = 1000;
+constexpr size_t NUMBER_OF_SAMPLES = 10;
+
+// A single block retained per cycle exceeds both limits. The slack absorbs the heap committing memory in pages
+// and the blocks of the messages in flight when sampling.
+constexpr double MAXIMUM_RETAINED_BYTES_PER_CYCLE = 1;
+constexpr double MAXIMUM_RETAINED_BLOCKS_PER_CYCLE = 0.01;
+constexpr uint64_t RETAINED_BYTES_SLACK = 256 * 1024;
+constexpr uint64_t RETAINED_BLOCKS_SLACK = 100;
+
+struct MemorySample
+{
+    size_t cycle = 0;
+    uint64_t privateBytes = 0;
+    uint64_t numberOfHeapBlocks = 0;
+};
+
+[[nodiscard]] uint64_t GetPrivateBytes()
+{
+    PROCESS_MEMORY_COUNTERS_EX counters;
+    if (!K32GetProcessMemoryInfo(GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&counters), sizeof(counters)))
+    {
+        AtlThrowLastWin32();
+    }
+
+    return counters.PrivateUsage;
+}
+
+/// The C runtime of the extension allocates from the process heap
+[[nodiscard]] uint64_t GetNumberOfHeapBlocks()
+{
+    const auto heapHandle = GetProcessHeap();
+    if (!HeapLock(heapHandle))
+    {
+        AtlThrowLastWin32();
+    }
+
+    uint64_t numberOfBlocks = 0;
+
+    PROCESS_HEAP_ENTRY entry = {};
+    while (HeapWalk(heapHandle, &entry))
+    {
+        if ((entry.wFlags & PROCESS_HEAP_ENTRY_BUSY) != 0)
+        {
+            ++numberOfBlocks;
+        }
+    }
+
+    HeapUnlock(heapHandle);
+
+    return numberOfBlocks;
+}
+
+[[nodiscard]] MemorySample TakeMemorySample(_In_ const size_t cycle)
+{
+    return { cycle, GetPrivateBytes(), GetNumberOfHeapBlocks() };
+}
+
+/// Returns whether the verb was offered and invoked
+_Success_(return == true) bool RunCycle(_In_ const ExtensionHost& extensionHost, _In_ IDataObject* dataObject)
+{
+    CComPtr<IContextMenu> contextMenu;
+    ATLENSURE_SUCCEEDED(extensionHost.CreateContextMenuHandler(contextMenu));
+
+    CComQIPtr<IShellExtInit> shellExtensionInitialization(contextMenu);
+    ATLENSURE(shellExtensionInitialization);
+
+    ATLENSURE_SUCCEEDED(shellExtensionInitialization->Initialize(nullptr, dataObject, nullptr));
+
+    const auto menuHandle = CreatePopupMenu();
+    ATLENSURE(menuHandle != nullptr);
+
+    const auto result = contextMenu->QueryContextMenu(menuHandle, 0, FIRST_MENU_COMMAND_ID, LAST_MENU_COMMAND_ID, CMF_NORMAL);
+    const auto numberOfCommandIds = SUCCEEDED(result) ? HRESULT_CODE(result) : 0U;
+
+    auto isInvoked = false;
+
+    // Explorer looks the command up by verb, as when invoking it from the keyboard
+    for (UINT offset = 0; offset < numberOfCommandIds && !isInvoked; ++offset)
+    {
+        wchar_t verb[64] = { 0 };
+        if (FAILED(contextMenu->GetCommandString(offset, GCS_VERBW, nullptr, reinterpret_cast<LPSTR>(verb), ARRAYSIZE(verb)))
+            || verb != INVOKED_VERB)
+        {
+            continue;
+        }
+
+        CMINVOKECOMMANDINFO invokeCommandInfo = { sizeof(invokeCommandInfo) };
+        invokeCommandInfo.lpVerb = MAKEINTRESOURCEA(offset);
+        invokeCommandInfo.nShow = SW_SHOWNORMAL;
+
+        isInvoked = SUCCEEDED(contextMenu->InvokeCommand(&invokeCommandInfo));
+    }
+
+    DestroyMenu(menuHandle);
+
+    return isInvoked;
+}
+
+int Soak(_In_ const ExtensionHost& extensionHost, _In_ Trace trace, _In_ const filesystem::path& workingFolder, _In_ const size_t numberOfCycles)
+{
+    if (numberOfCycles < NUMBER_OF_WARM_UP_CYCLES + NUMBER_OF_SAMPLES)
+    {
+        cerr << format("Soaking takes at least {} cycles", NUMBER_OF_WARM_UP_CYCLES + NUMBER_OF_SAMPLES) << endl;
+        return 2;
+    }
+
+    MaterializeTrace(trace, workingFolder);
+
+    CComPtr<IDataObject> dataObject;
+    ATLENSURE_SUCCEEDED(CreateSelectionDataObject(trace.selectedPaths, dataObject));
+
+    StandInServer server(trace.syncRoots, trace.responseDelays);
+    if (trace.isAppRunning && !server.TryStart())
+    {
+        cerr << "The pipe of the app is already served, close the app before soaking" << endl;
+        return 2;
+    }
+
+    const auto samplingInterval = (numberOfCycles - NUMBER_OF_WARM_UP_CYCLES) / NUMBER_OF_SAMPLES;
+
+    vector<MemorySample> samples;
+    samples.reserve(NUMBER_OF_SAMPLES + 1);
+    size_t numberOfInvocations = 0;
+
+    for (size_t cycle = 0; cycle < numberOfCycles; ++cycle)
+    {
+        if (cycle >= NUMBER_OF_WARM_UP_CYCLES && (cycle - NUMBER_OF_WARM_UP_CYCLES) % samplingInterval == 0)
+        {
+            samples.push_back(TakeMemorySample(cycle));
+        }
+
+        if (RunCycle(extensionHost, dataObject))
+        {
+            ++numberOfInvocations;
+        }
+    }
+
+    samples.push_back(TakeMemorySample(numberOfCycles));
+
+    server.Stop();
+
+    cout << format("{}: {} items selected, {} cycles, {} commands invoked", trace.name, trace.selectedPaths.size(), numberOfCycles, numberOfInvocations) << endl;
+
+    if (numberOfInvocations == 0)
+    {
+        cerr << "The selection of the trace is not offered the command the soak invokes" << endl;
+        return 2;
+    }
+
+    cout << format("{:>12}{:>16}{:>16}", "Cycle", "Private bytes", "Heap blocks") << endl;
+
+    for (const auto& sample : samples)
+    {
+        cout << format("{:>12}{:>16}{:>16}", sample.cycle, sample.privateBytes, sample.numberOfHeapBlocks) << endl;
+    }
+
+    const auto& first = samples.front();
+    const auto& last = samples.back();
+    const auto numberOfMeasuredCycles = static_cast<double>(last.cycle - first.cycle);
+
+    const auto retainedBytes = static_cast<double>(last.privateBytes) - static_cast<double>(first.privateBytes);
+    const auto retainedBlocks = static_cast<double>(last.numberOfHeapBlocks) - static_cast<double>(first.numberOfHeapBlocks);
+
+    cout << format("Retained per cycle: {:.3f} bytes, {:.5f} heap blocks", retainedBytes / numberOfMeasuredCycles, retainedBlocks / numberOfMeasuredCycles) << endl;
+
+    auto isWithinBudget = true;
+
+    if (retainedBytes > MAXIMUM_RETAINED_BYTES_PER_CYCLE * numberOfMeasuredCycles + RETAINED_BYTES_SLACK)
+    {
+        cout << format("Private bytes grow by over {} bytes per cycle", MAXIMUM_RETAINED_BYTES_PER_CYCLE) << endl;
+        isWithinBudget = false;
+    }
+
+    if (retainedBlocks > MAXIMUM_RETAINED_BLOCKS_PER_CYCLE * numberOfMeasuredCycles + RETAINED_BLOCKS_SLACK)
+    {
+        cout << format("Heap blocks grow by over {} blocks per cycle", MAXIMUM_RETAINED_BLOCKS_PER_CYCLE) << endl;
+        isWithinBudget = false;
+    }
+
+    for (const auto& [messageType, numberOfMessages] : server.GetNumberOfMessages())
+    {
+        cout << format("{:<32}{:>10} messages", messageType, numberOfMessages) << endl;
+    }
+
+    return isWithinBudget ? 0 : 1;
+}
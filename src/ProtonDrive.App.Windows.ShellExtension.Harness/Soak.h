@@ -0,0 +1,10 @@
+#pragma once
+
+#include "pch.h"
+#include "ExtensionHost.h"
+#include "Trace.h"
+
+/// Runs the given number of Initialize/QueryContextMenu/InvokeCommand cycles for the selection of the trace, against
+/// the stand-in server, the way Explorer does over days. Samples the private bytes and the live heap blocks of the process
+/// after a warm-up, and returns the process exit code, non-zero if either grows with the number of cycles.
+[[nodiscard]] int Soak(_In_ const ExtensionHost& extensionHost, _In_ Trace trace, _In_ const std::filesystem::path& workingFolder, _In_ size_t numberOfCycles);
@@ -0,0 +1,215 @@
+#include "pch.h"
+#include "StandInServer.h"
+
+#include "ipc.h"
+#include "unicode.h"
+
+using namespace std;
+using namespace nlohmann;
+
+constexpr int CLOUD_FILES_SYNC_ROOT_TYPE = 1;
+
+_Success_(return == true) bool TryReadMessage(_In_ const HANDLE pipeHandle, _Out_ string& message)
+{
+    message.clear();
+
+    char buffer[4096];
+    while (true)
+    {
+        DWORD numberOfBytesRead = 0;
+        const auto succeeded = ReadFile(pipeHandle, buffer, sizeof(buffer), &numberOfBytesRead, nullptr);
+        message.append(buffer, numberOfBytesRead);
+
+        if (succeeded)
+        {
+            return !message.empty();
+        }
+
+        if (GetLastError() != ERROR_MORE_DATA)
+        {
+            return false;
+        }
+    }
+}
+
+bool IsSameOrDescendantPath(_In_ const wstring_view ancestor, _In_ const wstring_view path)
+{
+    if (ancestor.empty() || path.size() < ancestor.size())
+    {
+        return false;
+    }
+
+    if (CompareStringOrdinal(ancestor.data(), static_cast<int>(ancestor.size()), path.data(), static_cast<int>(ancestor.size()), TRUE) != CSTR_EQUAL)
+    {
+        return false;
+    }
+
+    return path.size() == ancestor.size() || path[ancestor.size()] == L'\\';
+}
+
+StandInServer::StandInServer(_In_ vector<StandInSyncRoot> syncRoots, _In_ map<string, DWORD> responseDelays)
+    : m_syncRoots(std::move(syncRoots)), m_responseDelays(std::move(responseDelays))
+{
+}
+
+StandInServer::~StandInServer()
+{
+    Stop();
+}
+
+_Success_(return == true) bool StandInServer::TryStart()
+{
+    for (DWORD i = 0; i < NUMBER_OF_INSTANCES; ++i)
+    {
+        const auto pipeHandle = CreateNamedPipe(
+            PIPE_NAME,
+            PIPE_ACCESS_DUPLEX | (i == 0 ? FILE_FLAG_FIRST_PIPE_INSTANCE : 0),
+            PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+            NUMBER_OF_INSTANCES,
+            PIPE_BUFFER_SIZE,
+            PIPE_BUFFER_SIZE,
+            0,
+            nullptr);
+
+        if (pipeHandle == INVALID_HANDLE_VALUE)
+        {
+            Stop();
+            return false;
+        }
+
+        m_threads.emplace_back([this, pipeHandle] { Serve(pipeHandle); });
+    }
+
+    return true;
+}
+
+void StandInServer::Stop()
+{
+    m_isStopping = true;
+
+    // Each connection wakes up one listening instance, which then exits
+    for (size_t i = 0; i < m_threads.size(); ++i)
+    {
+        while (true)
+        {
+            const auto pipeHandle = CreateFile(PIPE_NAME, GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+            if (pipeHandle != INVALID_HANDLE_VALUE)
+            {
+                CloseHandle(pipeHandle);
+                break;
+            }
+
+            if (GetLastError() != ERROR_PIPE_BUSY)
+            {
+                break;
+            }
+
+            WaitNamedPipe(PIPE_NAME, 100);
+        }
+    }
+
+    for (auto& thread : m_threads)
+    {
+        thread.join();
+    }
+
+    m_threads.clear();
+}
+
+map<string, uint64_t> StandInServer::GetNumberOfMessages()
+{
+    const lock_guard lock(m_mutex);
+    return m_numberOfMessages;
+}
+
+void StandInServer::Serve(_In_ const HANDLE pipeHandle)
+{
+    const ATL::CHandle pipeHandleOwner(pipeHandle);
+
+    string message;
+
+    while (!m_isStopping)
+    {
+        if (!ConnectNamedPipe(pipeHandle, nullptr) && GetLastError() != ERROR_PIPE_CONNECTED)
+        {
+            return;
+        }
+
+        if (!m_isStopping && TryReadMessage(pipeHandle, message))
+        {
+            const auto messageJsonObject = json::parse(message, nullptr, false);
+            if (!messageJsonObject.is_discarded() && messageJsonObject.contains("type"))
+            {
+                const auto messageType = messageJsonObject["type"].get<string>();
+
+                {
+                    const lock_guard lock(m_mutex);
+                    ++m_numberOfMessages[messageType];
+                }
+
+                const auto response = GetResponse(messageType, messageJsonObject.value("parameters", json()));
+                if (response.has_value())
+                {
+                    if (const auto delay = m_responseDelays.find(messageType); delay != m_responseDelays.end())
+                    {
+                        Sleep(delay->second);
+                    }
+
+                    DWORD numberOfBytesWritten;
+                    WriteFile(pipeHandle, response->data(), static_cast<DWORD>(response->size()), &numberOfBytesWritten, nullptr);
+                    FlushFileBuffers(pipeHandle);
+                }
+            }
+        }
+
+        DisconnectNamedPipe(pipeHandle);
+    }
+}
+
+optional<string> StandInServer::GetResponse(_In_ const string& messageType, _In_ const json& parameters) const
+{
+    if (messageType == "SyncRootPathsQuery")
+    {
+        auto paths = json::array();
+
+        for (const auto& type : parameters)
+        {
+            for (const auto& syncRoot : m_syncRoots)
+            {
+                if (type.is_number_integer() && type.get<int>() == syncRoot.type)
+                {
+                    paths.push_back(ConvertUtf16ToUtf8(syncRoot.path.c_str()));
+                }
+            }
+        }
+
+        return paths.dump();
+    }
+
+    if (messageType == "RemoteIdsQuery")
+    {
+        wstring path;
+        if (!parameters.is_string() || !TryConvertUtf8ToUtf16(parameters.get_ref<const string&>(), path))
+        {
+            return "null";
+        }
+
+        for (const auto& syncRoot : m_syncRoots)
+        {
+            if (syncRoot.type == CLOUD_FILES_SYNC_ROOT_TYPE && IsSameOrDescendantPath(syncRoot.path, path))
+            {
+                return json { { "shareId", "StandInShare" }, { "linkId", to_string(hash<wstring>()(path)) } }.dump();
+            }
+        }
+
+        return "null";
+    }
+
+    if (messageType == "ThumbnailQuery" || messageType == "ContentDuplicatesQuery")
+    {
+        return "[]";
+    }
+
+    // Commands and reports are not answered
+    return nullopt;
+}
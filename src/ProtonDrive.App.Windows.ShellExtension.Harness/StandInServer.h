@@ -0,0 +1,45 @@
+#pragma once
+
+#include "pch.h"
+
+struct StandInSyncRoot
+{
+    int type = 0;
+    std::wstring path;
+};
+
+/// Answers the IPC messages of the shell extension in place of the app, on the pipe of the app.
+/// Sync root paths come from the trace, remote IDs exist for every path inside a sync root of the cloud files type,
+/// other queries get empty responses. Each response is delayed by the configured time for its message type.
+class StandInServer
+{
+public:
+    StandInServer(_In_ std::vector<StandInSyncRoot> syncRoots, _In_ std::map<std::string, DWORD> responseDelays);
+    ~StandInServer();
+
+    StandInServer(const StandInServer&) = delete;
+    StandInServer& operator=(const StandInServer&) = delete;
+
+    /// Fails if the pipe is already served, which is the case while the app is running
+    _Success_(return == true) bool TryStart();
+    void Stop();
+
+    /// Number of messages received since the start, by message type
+    [[nodiscard]] std::map<std::string, uint64_t> GetNumberOfMessages();
+
+private:
+    static constexpr DWORD NUMBER_OF_INSTANCES = 8;
+    static constexpr DWORD PIPE_BUFFER_SIZE = 64 * 1024;
+
+    void Serve(_In_ HANDLE pipeHandle);
+
+    /// Returns no value for messages that have no response
+    [[nodiscard]] std::optional<std::string> GetResponse(_In_ const std::string& messageType, _In_ const nlohmann::json& parameters) const;
+
+    std::vector<StandInSyncRoot> m_syncRoots;
+    std::map<std::string, DWORD> m_responseDelays;
+    std::vector<std::thread> m_threads;
+    std::atomic<bool> m_isStopping = false;
+    std::mutex m_mutex;
+    std::map<std::string, uint64_t> m_numberOfMessages;
+};
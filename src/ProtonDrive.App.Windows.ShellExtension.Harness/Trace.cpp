@@ -0,0 +1,113 @@
+#include "pch.h"
+#include "Trace.h"
+
+#include "unicode.h"
+
+using namespace std;
+using namespace nlohmann;
+
+wstring GetUtf16String(_In_ const json& value)
+{
+    wstring result;
+    if (!TryConvertUtf8ToUtf16(value.get_ref<const string&>(), result))
+    {
+        throw invalid_argument("String is not valid UTF-8");
+    }
+
+    return result;
+}
+
+Trace LoadTrace(_In_ const filesystem::path& tracePath)
+{
+    ifstream traceFile(tracePath);
+    if (!traceFile)
+    {
+        throw runtime_error("Cannot open the trace file");
+    }
+
+    const auto traceJsonObject = json::parse(traceFile);
+
+    Trace trace;
+    trace.name = traceJsonObject.value("name", tracePath.stem().string());
+    trace.numberOfIterations = traceJsonObject.value("numberOfIterations", size_t { 1 });
+    trace.isAppRunning = traceJsonObject.value("isAppRunning", true);
+
+    for (const auto& syncRoot : traceJsonObject.value("syncRoots", json::array()))
+    {
+        trace.syncRoots.push_back({ syncRoot.at("type").get<int>(), GetUtf16String(syncRoot.at("path")) });
+    }
+
+    trace.responseDelays = traceJsonObject.value("responseDelayMilliseconds", map<string, DWORD>());
+
+    for (const auto& path : traceJsonObject.value("selectedPaths", json::array()))
+    {
+        trace.selectedPaths.push_back(GetUtf16String(path));
+    }
+
+    if (const auto generatedFiles = traceJsonObject.find("generatedFiles"); generatedFiles != traceJsonObject.end())
+    {
+        trace.generatedFilesFolder = GetUtf16String(generatedFiles->at("folder"));
+        trace.numberOfGeneratedFiles = generatedFiles->at("numberOfFiles").get<size_t>();
+    }
+
+    trace.p99Budgets = traceJsonObject.value("p99BudgetMicroseconds", map<string, uint64_t>());
+
+    return trace;
+}
+
+wstring Materialize(_In_ const wstring& path, _In_ const filesystem::path& workingFolder, _In_ const bool isFolder)
+{
+    const filesystem::path itemPath(path);
+    if (itemPath.is_absolute())
+    {
+        return path;
+    }
+
+    const auto absolutePath = (workingFolder / itemPath).lexically_normal();
+
+    if (isFolder)
+    {
+        filesystem::create_directories(absolutePath);
+    }
+    else if (!filesystem::exists(absolutePath))
+    {
+        filesystem::create_directories(absolutePath.parent_path());
+        ofstream file(absolutePath);
+    }
+
+    auto result = absolutePath.native();
+    if (result.ends_with(L'\\'))
+    {
+        result.pop_back();
+    }
+
+    return result;
+}
+
+void MaterializeTrace(_Inout_ Trace& trace, _In_ const filesystem::path& workingFolder)
+{
+    for (auto& syncRoot : trace.syncRoots)
+    {
+        syncRoot.path = Materialize(syncRoot.path, workingFolder, true);
+    }
+
+    for (auto& path : trace.selectedPaths)
+    {
+        path = Materialize(path, workingFolder, path.ends_with(L'\\') || path.ends_with(L'/'));
+    }
+
+    if (trace.numberOfGeneratedFiles == 0)
+    {
+        return;
+    }
+
+    const auto folder = Materialize(trace.generatedFilesFolder, workingFolder, true);
+
+    trace.selectedPaths.reserve(trace.selectedPaths.size() + trace.numberOfGeneratedFiles);
+
+    for (size_t i = 0; i < trace.numberOfGeneratedFiles; ++i)
+    {
+        auto& path = trace.selectedPaths.emplace_back(folder + L"\\File " + to_wstring(i) + L".txt");
+        ofstream file(filesystem::path(path), ios::app);
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "pch.h"
+#include "StandInServer.h"
+
+/// A context menu scenario to replay: the selection, the sync roots the app reports, and how fast it answers.
+/// Relative paths are relative to a working folder in which the harness creates them; a trailing separator
+/// denotes a folder. Absolute paths, as in traces recorded on a user machine, must exist.
+struct Trace
+{
+    std::string name;
+    size_t numberOfIterations = 1;
+
+    /// The stand-in server is not started when false, as if the app was not running
+    bool isAppRunning = true;
+
+    std::vector<StandInSyncRoot> syncRoots;
+    std::map<std::string, DWORD> responseDelays;
+    std::vector<std::wstring> selectedPaths;
+
+    /// Files named "File {index}.txt" created in this folder and appended to the selection
+    std::wstring generatedFilesFolder;
+    size_t numberOfGeneratedFiles = 0;
+
+    /// Latest acceptable 99th percentile per phase, in microseconds
+    std::map<std::string, uint64_t> p99Budgets;
+};
+
+/// Throws if the file cannot be read or is not a valid trace
+[[nodiscard]] Trace LoadTrace(_In_ const std::filesystem::path& tracePath);
+
+/// Creates the items of the trace given relative to the working folder, and makes all trace paths absolute
+void MaterializeTrace(_Inout_ Trace& trace, _In_ const std::filesystem::path& workingFolder);
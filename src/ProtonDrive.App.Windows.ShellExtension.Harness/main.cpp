@@ -0,0 +1,210 @@
+#include "pch.h"
+
+#include "ExtensionHost.h"
+#include "LoadGenerator.h"
+#include "Replay.h"
+#include "Soak.h"
+#include "Trace.h"
+
+using namespace std;
+using namespace ATL;
+
+constexpr auto EXTENSION_FILE_NAME = L"ProtonDrive.App.Windows.ShellExtension.dll";
+constexpr size_t DEFAULT_NUMBER_OF_SOAK_CYCLES = 1'000'000;
+
+void PrintUsage()
+{
+    cout << "Usage:" << endl
+        << "  ProtonDrive.App.Windows.ShellExtension.Harness replay <trace file> [--extension <extension DLL path>]" << endl
+        << "  ProtonDrive.App.Windows.ShellExtension.Harness load [--clients <number>] [--rate <queries per second>] [--duration <seconds>]" << endl
+        << "      [--mix <sync root paths queries>:<remote IDs queries>] [--path <remote IDs query path>] [--stand-in]" << endl
+        << "  ProtonDrive.App.Windows.ShellExtension.Harness soak <trace file> [--cycles <number>] [--extension <extension DLL path>]" << endl
+        << endl
+        << "replay: Replays the context menu scenario of the trace against the shell extension, with a stand-in server" << endl
+        << "in place of the app, and prints the latency percentiles of each phase. The app must not be running." << endl
+        << "The exit code is 1 if a phase is over the p99 budget of the trace." << endl
+        << endl
+        << "load: Sends queries to the pipe server of the running app, or of the stand-in server, from concurrent clients" << endl
+        << "and prints the throughput, the rate of connections failing because all pipe instances are busy, and the latencies." << endl
+        << endl
+        << "soak: Runs Initialize/QueryContextMenu/InvokeCommand cycles for the selection of the trace against the stand-in" << endl
+        << "server, invoking the share command, and prints the private bytes and heap blocks of the process along the run." << endl
+        << "The iterations and budgets of the trace are ignored. The exit code is 1 if memory is retained per cycle." << endl;
+}
+
+/// Deleted with its content at the end of the run
+class WorkingFolder
+{
+public:
+    WorkingFolder()
+    {
+        m_path = filesystem::temp_directory_path() / (L"ProtonDrive.Harness." + to_wstring(GetCurrentProcessId()));
+        filesystem::create_directories(m_path);
+    }
+
+    ~WorkingFolder()
+    {
+        error_code error;
+        filesystem::remove_all(m_path, error);
+    }
+
+    WorkingFolder(const WorkingFolder&) = delete;
+    WorkingFolder& operator=(const WorkingFolder&) = delete;
+
+    [[nodiscard]] const filesystem::path& GetPath() const { return m_path; }
+
+private:
+    filesystem::path m_path;
+};
+
+[[nodiscard]] filesystem::path GetDefaultRemoteIdsQueryPath()
+{
+    CComHeapPtr<wchar_t> profileFolderPath;
+    if (FAILED(SHGetKnownFolderPath(FOLDERID_Profile, KF_FLAG_DEFAULT, nullptr, &profileFolderPath)))
+    {
+        return {};
+    }
+
+    return filesystem::path(static_cast<wchar_t*>(profileFolderPath)) / L"Proton Drive" / L"Document.txt";
+}
+
+_Success_(return == true) bool TryParseLoadGeneratorOptions(_In_ const int argc, _In_ wchar_t* argv[], _Out_ LoadGeneratorOptions& options)
+{
+    options = {};
+    options.remoteIdsQueryPath = GetDefaultRemoteIdsQueryPath();
+
+    for (auto i = 2; i < argc; ++i)
+    {
+        const wstring_view name(argv[i]);
+
+        if (name == L"--stand-in")
+        {
+            options.useStandInServer = true;
+            continue;
+        }
+
+        if (i + 1 >= argc)
+        {
+            return false;
+        }
+
+        const wstring value(argv[++i]);
+
+        if (name == L"--clients")
+        {
+            options.numberOfClients = stoul(value);
+        }
+        else if (name == L"--rate")
+        {
+            options.requestsPerSecond = stod(value);
+        }
+        else if (name == L"--duration")
+        {
+            options.durationMilliseconds = static_cast<DWORD>(stod(value) * 1000);
+        }
+        else if (name == L"--mix")
+        {
+            const auto separatorIndex = value.find(L':');
+            if (separatorIndex == wstring::npos)
+            {
+                return false;
+            }
+
+            options.syncRootPathsQueryWeight = stoul(value.substr(0, separatorIndex));
+            options.remoteIdsQueryWeight = stoul(value.substr(separatorIndex + 1));
+        }
+        else if (name == L"--path")
+        {
+            options.remoteIdsQueryPath = filesystem::absolute(value).native();
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// Runs the replay or soak mode, which both drive the shell extension through the scenario of a trace
+[[nodiscard]] int RunTrace(_In_ const wstring_view mode, _In_ const int argc, _In_ wchar_t* argv[])
+{
+    if (argc < 3)
+    {
+        PrintUsage();
+        return 2;
+    }
+
+    const filesystem::path tracePath(argv[2]);
+
+    wchar_t executablePath[MAX_PATH];
+    GetModuleFileName(nullptr, executablePath, ARRAYSIZE(executablePath));
+    auto extensionPath = filesystem::path(executablePath).replace_filename(EXTENSION_FILE_NAME);
+
+    auto numberOfCycles = DEFAULT_NUMBER_OF_SOAK_CYCLES;
+
+    for (auto i = 3; i + 1 < argc; i += 2)
+    {
+        const wstring_view name(argv[i]);
+
+        if (name == L"--extension")
+        {
+            extensionPath = filesystem::absolute(argv[i + 1]);
+        }
+        else if (name == L"--cycles")
+        {
+            numberOfCycles = stoull(argv[i + 1]);
+        }
+    }
+
+    const auto trace = LoadTrace(tracePath);
+
+    ExtensionHost extensionHost;
+    if (!extensionHost.TryLoad(extensionPath))
+    {
+        cerr << "Cannot load the shell extension from " << extensionPath.string() << endl;
+        return 2;
+    }
+
+    const WorkingFolder workingFolder;
+    return mode == L"soak"
+        ? Soak(extensionHost, trace, workingFolder.GetPath(), numberOfCycles)
+        : Replay(extensionHost, trace, workingFolder.GetPath());
+}
+
+int wmain(const int argc, wchar_t* argv[])
+{
+    const auto mode = argc >= 2 ? wstring_view(argv[1]) : wstring_view();
+
+    LoadGeneratorOptions loadGeneratorOptions;
+    if ((mode != L"replay" && mode != L"load" && mode != L"soak") || (mode == L"load" && !TryParseLoadGeneratorOptions(argc, argv, loadGeneratorOptions)))
+    {
+        PrintUsage();
+        return 2;
+    }
+
+    // Explorer shows context menus on single-threaded apartment threads
+    if (FAILED(CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED)))
+    {
+        return 2;
+    }
+
+    auto exitCode = 2;
+
+    try
+    {
+        exitCode = mode == L"load" ? GenerateLoad(loadGeneratorOptions) : RunTrace(mode, argc, argv);
+    }
+    catch (CAtlException& exception)
+    {
+        cerr << format("Failed with HRESULT 0x{:08X}", static_cast<uint32_t>(static_cast<HRESULT>(exception))) << endl;
+    }
+    catch (exception& exception)
+    {
+        cerr << "Failed: " << exception.what() << endl;
+    }
+
+    // The extension keeps threads running, exit without waiting for its static objects to be destroyed
+    CoUninitialize();
+    ExitProcess(static_cast<UINT>(exitCode));
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+// The same headers the shell extension precompiles, the shared extension code relies on them
+#include "../ProtonDrive.App.Windows.ShellExtension/pch.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
@@ -0,0 +1,306 @@
+#include "pch.h"
+#include "DegradationController.h"
+
+using namespace std;
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace Microsoft::VisualStudio::CppUnitTestFramework
+{
+    template <>
+    inline wstring ToString<DegradationMode>(const DegradationMode& mode)
+    {
+        return to_wstring(static_cast<int>(mode));
+    }
+}
+
+namespace ProtonDrive::App::Windows::ShellExtension::Tests
+{
+    /// Latencies of context menu builds, one millisecond apart, fed to a controller of its own
+    class SimulatedStream
+    {
+    public:
+        static constexpr uint64_t SLOW_MICROSECONDS = DegradationController::LATENCY_BUDGET_MICROSECONDS + 1;
+        static constexpr uint64_t FAST_MICROSECONDS = DegradationController::RECOVERY_LATENCY_MICROSECONDS - 1;
+
+        /// Neither over the budget nor fast enough to recover
+        static constexpr uint64_t MEDIUM_MICROSECONDS = (DegradationController::LATENCY_BUDGET_MICROSECONDS + DegradationController::RECOVERY_LATENCY_MICROSECONDS) / 2;
+
+        /// Returns true if one of the samples made the mode change, the samples after it are not recorded
+        bool Record(_In_ const size_t numberOfSamples, _In_ const uint64_t microseconds)
+        {
+            for (size_t i = 0; i < numberOfSamples; ++i)
+            {
+                ++m_now;
+
+                if (m_controller.Record(microseconds, m_now))
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        void Wait(_In_ const uint64_t milliseconds) { m_now += milliseconds; }
+
+        /// Records slow samples until the mode changes
+        void Degrade()
+        {
+            Assert::IsTrue(Record(DegradationController::WINDOW_SIZE, SLOW_MICROSECONDS));
+        }
+
+        /// Waits for the dwell time of the current mode and records fast samples until the mode changes
+        void Recover(_In_ const uint64_t dwellMilliseconds)
+        {
+            Wait(dwellMilliseconds);
+            Assert::IsTrue(Record(DegradationController::WINDOW_SIZE, FAST_MICROSECONDS));
+        }
+
+        [[nodiscard]] DegradationController& GetController() { return m_controller; }
+
+        [[nodiscard]] DegradationMode GetMode() const { return m_controller.GetMode(); }
+
+    private:
+        DegradationController m_controller;
+        uint64_t m_now = 1'000'000;
+    };
+
+    TEST_CLASS(DegradationControllerTests)
+    {
+    public:
+        TEST_METHOD(ModeDoesNotChangeBeforeTheWindowIsFull)
+        {
+            SimulatedStream stream;
+
+            Assert::IsFalse(stream.Record(DegradationController::WINDOW_SIZE - 1, SimulatedStream::SLOW_MICROSECONDS));
+            Assert::AreEqual(DegradationMode::Normal, stream.GetMode());
+        }
+
+        TEST_METHOD(SevenSlowSamplesOfSixteenDoNotDegrade)
+        {
+            SimulatedStream stream;
+
+            Assert::IsFalse(stream.Record(9, SimulatedStream::MEDIUM_MICROSECONDS));
+            Assert::IsFalse(stream.Record(7, SimulatedStream::SLOW_MICROSECONDS));
+            Assert::AreEqual(DegradationMode::Normal, stream.GetMode());
+        }
+
+        TEST_METHOD(EightSlowSamplesOfSixteenDegrade)
+        {
+            SimulatedStream stream;
+
+            Assert::IsFalse(stream.Record(8, SimulatedStream::MEDIUM_MICROSECONDS));
+            Assert::IsFalse(stream.Record(7, SimulatedStream::SLOW_MICROSECONDS));
+            Assert::IsTrue(stream.Record(1, SimulatedStream::SLOW_MICROSECONDS));
+            Assert::AreEqual(DegradationMode::CacheOnly, stream.GetMode());
+        }
+
+        TEST_METHOD(SlowSamplesAnywhereInTheSlidingWindowDegrade)
+        {
+            SimulatedStream stream;
+
+            // Slow samples alternate with medium ones, half of every window is slow once it is full
+            Assert::IsFalse(stream.Record(15, SimulatedStream::MEDIUM_MICROSECONDS));
+
+            for (size_t i = 0; i < 7; ++i)
+            {
+                Assert::IsFalse(stream.Record(1, SimulatedStream::SLOW_MICROSECONDS));
+                Assert::IsFalse(stream.Record(1, SimulatedStream::MEDIUM_MICROSECONDS));
+            }
+
+            Assert::IsTrue(stream.Record(1, SimulatedStream::SLOW_MICROSECONDS));
+            Assert::AreEqual(DegradationMode::CacheOnly, stream.GetMode());
+        }
+
+        TEST_METHOD(SamplesOfThePreviousModeAreNotCounted)
+        {
+            SimulatedStream stream;
+            stream.Degrade();
+
+            Assert::IsFalse(stream.Record(DegradationController::WINDOW_SIZE - 1, SimulatedStream::SLOW_MICROSECONDS));
+            Assert::AreEqual(DegradationMode::CacheOnly, stream.GetMode());
+        }
+
+        TEST_METHOD(ModeIsNotLeftBeforeTheDwellTime)
+        {
+            SimulatedStream stream;
+            stream.Degrade();
+
+            Assert::IsFalse(stream.Record(DegradationController::WINDOW_SIZE, SimulatedStream::FAST_MICROSECONDS));
+
+            // The last of these samples comes a millisecond before the dwell time is over
+            stream.Wait(DegradationController::MINIMUM_DWELL_MILLISECONDS - DegradationController::WINDOW_SIZE - 2);
+            Assert::IsFalse(stream.Record(1, SimulatedStream::FAST_MICROSECONDS));
+            Assert::AreEqual(DegradationMode::CacheOnly, stream.GetMode());
+
+            Assert::IsTrue(stream.Record(1, SimulatedStream::FAST_MICROSECONDS));
+            Assert::AreEqual(DegradationMode::Normal, stream.GetMode());
+        }
+
+        TEST_METHOD(ModeIsNotLeftWhileSomeSamplesAreNotFast)
+        {
+            SimulatedStream stream;
+            stream.Degrade();
+            stream.Wait(DegradationController::MINIMUM_DWELL_MILLISECONDS);
+
+            Assert::IsFalse(stream.Record(DegradationController::WINDOW_SIZE - 1, SimulatedStream::FAST_MICROSECONDS));
+            Assert::IsFalse(stream.Record(1, SimulatedStream::MEDIUM_MICROSECONDS));
+            Assert::AreEqual(DegradationMode::CacheOnly, stream.GetMode());
+
+            // The medium sample leaves the window after sixteen more
+            Assert::IsFalse(stream.Record(DegradationController::WINDOW_SIZE - 1, SimulatedStream::FAST_MICROSECONDS));
+            Assert::IsTrue(stream.Record(1, SimulatedStream::FAST_MICROSECONDS));
+            Assert::AreEqual(DegradationMode::Normal, stream.GetMode());
+        }
+
+        TEST_METHOD(RelapseDoublesTheDwellTime)
+        {
+            SimulatedStream stream;
+            stream.Degrade();
+            stream.Recover(DegradationController::MINIMUM_DWELL_MILLISECONDS);
+
+            // Degrading again soon after recovering
+            stream.Degrade();
+
+            stream.Wait(DegradationController::MINIMUM_DWELL_MILLISECONDS);
+            Assert::IsFalse(stream.Record(DegradationController::WINDOW_SIZE, SimulatedStream::FAST_MICROSECONDS));
+            Assert::AreEqual(DegradationMode::CacheOnly, stream.GetMode());
+
+            stream.Wait(DegradationController::MINIMUM_DWELL_MILLISECONDS);
+            Assert::IsTrue(stream.Record(1, SimulatedStream::FAST_MICROSECONDS));
+            Assert::AreEqual(DegradationMode::Normal, stream.GetMode());
+        }
+
+        TEST_METHOD(DwellTimeIsResetWhenDegradingLongAfterRecovering)
+        {
+            SimulatedStream stream;
+            stream.Degrade();
+            stream.Recover(DegradationController::MINIMUM_DWELL_MILLISECONDS);
+            stream.Degrade();
+            stream.Recover(2 * DegradationController::MINIMUM_DWELL_MILLISECONDS);
+
+            stream.Wait(DegradationController::RELAPSE_MILLISECONDS);
+            stream.Degrade();
+
+            stream.Recover(DegradationController::MINIMUM_DWELL_MILLISECONDS);
+            Assert::AreEqual(DegradationMode::Normal, stream.GetMode());
+        }
+
+        TEST_METHOD(DwellTimeIsCappedAfterRepeatedRelapses)
+        {
+            SimulatedStream stream;
+
+            for (int i = 0; i < 10; ++i)
+            {
+                stream.Degrade();
+                stream.Recover(DegradationController::MAXIMUM_DWELL_MILLISECONDS);
+            }
+
+            stream.Degrade();
+
+            stream.Wait(DegradationController::MAXIMUM_DWELL_MILLISECONDS - DegradationController::WINDOW_SIZE - 1);
+            Assert::IsFalse(stream.Record(DegradationController::WINDOW_SIZE, SimulatedStream::FAST_MICROSECONDS));
+            Assert::IsTrue(stream.Record(1, SimulatedStream::FAST_MICROSECONDS));
+            Assert::AreEqual(DegradationMode::Normal, stream.GetMode());
+        }
+
+        TEST_METHOD(ModesAreEnteredOneAtATime)
+        {
+            SimulatedStream stream;
+
+            stream.Degrade();
+            Assert::AreEqual(DegradationMode::CacheOnly, stream.GetMode());
+
+            stream.Degrade();
+            Assert::AreEqual(DegradationMode::SkipLargeSelectionChecks, stream.GetMode());
+
+            stream.Degrade();
+            Assert::AreEqual(DegradationMode::HideMenuItems, stream.GetMode());
+        }
+
+        TEST_METHOD(HideMenuItemsIsTheCheapestMode)
+        {
+            SimulatedStream stream;
+            stream.Degrade();
+            stream.Degrade();
+            stream.Degrade();
+
+            Assert::IsFalse(stream.Record(4 * DegradationController::WINDOW_SIZE, SimulatedStream::SLOW_MICROSECONDS));
+            Assert::AreEqual(DegradationMode::HideMenuItems, stream.GetMode());
+        }
+
+        TEST_METHOD(RecoveryFromHideMenuItemsIsOneModeAtATime)
+        {
+            SimulatedStream stream;
+            stream.Degrade();
+            stream.Degrade();
+            stream.Degrade();
+
+            stream.Recover(DegradationController::MINIMUM_DWELL_MILLISECONDS);
+            Assert::AreEqual(DegradationMode::SkipLargeSelectionChecks, stream.GetMode());
+
+            // Recovering does not double the dwell time, only relapsing does
+            stream.Recover(DegradationController::MINIMUM_DWELL_MILLISECONDS);
+            Assert::AreEqual(DegradationMode::CacheOnly, stream.GetMode());
+
+            stream.Recover(DegradationController::MINIMUM_DWELL_MILLISECONDS);
+            Assert::AreEqual(DegradationMode::Normal, stream.GetMode());
+
+            Assert::IsFalse(stream.Record(DegradationController::WINDOW_SIZE, SimulatedStream::FAST_MICROSECONDS));
+            Assert::AreEqual(DegradationMode::Normal, stream.GetMode());
+        }
+
+        TEST_METHOD(ModeChangesAreTakenOnce)
+        {
+            SimulatedStream stream;
+            stream.Record(8, SimulatedStream::MEDIUM_MICROSECONDS);
+            stream.Record(8, SimulatedStream::SLOW_MICROSECONDS);
+
+            vector<DegradationModeChange> modeChanges;
+            stream.GetController().TakeModeChanges(modeChanges);
+
+            Assert::AreEqual(size_t { 1 }, modeChanges.size());
+            Assert::AreEqual(DegradationMode::Normal, modeChanges[0].previousMode);
+            Assert::AreEqual(DegradationMode::CacheOnly, modeChanges[0].mode);
+            Assert::AreEqual(size_t { 8 }, modeChanges[0].numberOfSlowSamples);
+
+            stream.GetController().TakeModeChanges(modeChanges);
+            Assert::IsTrue(modeChanges.empty());
+        }
+
+        TEST_METHOD(OnlyTheLatestModeChangesAreKept)
+        {
+            SimulatedStream stream;
+
+            // Ten changes to CacheOnly, each followed by a change back to Normal
+            for (int i = 0; i < 10; ++i)
+            {
+                stream.Degrade();
+                stream.Recover(DegradationController::MAXIMUM_DWELL_MILLISECONDS);
+            }
+
+            vector<DegradationModeChange> modeChanges;
+            stream.GetController().TakeModeChanges(modeChanges);
+
+            Assert::AreEqual(DegradationController::MAXIMUM_NUMBER_OF_MODE_CHANGES, modeChanges.size());
+
+            for (size_t i = 0; i < modeChanges.size(); i += 2)
+            {
+                Assert::AreEqual(DegradationMode::Normal, modeChanges[i].previousMode);
+                Assert::AreEqual(DegradationMode::CacheOnly, modeChanges[i].mode);
+                Assert::AreEqual(DegradationController::WINDOW_SIZE, modeChanges[i].numberOfSlowSamples);
+
+                Assert::AreEqual(DegradationMode::CacheOnly, modeChanges[i + 1].previousMode);
+                Assert::AreEqual(DegradationMode::Normal, modeChanges[i + 1].mode);
+                Assert::AreEqual(size_t { 0 }, modeChanges[i + 1].numberOfSlowSamples);
+            }
+
+            // The oldest changes were dropped, the ones after the last take are kept
+            stream.Degrade();
+            stream.GetController().TakeModeChanges(modeChanges);
+
+            Assert::AreEqual(size_t { 1 }, modeChanges.size());
+            Assert::AreEqual(DegradationMode::CacheOnly, modeChanges[0].mode);
+        }
+    };
+}
@@ -0,0 +1,286 @@
+#include "pch.h"
+#include "PathCanonicalization.h"
+
+using namespace std;
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace ProtonDrive::App::Windows::ShellExtension::Tests
+{
+    /// Unique folder under the temporary folder, deleted with its content at the end of the test
+    class TemporaryFolder
+    {
+    public:
+        TemporaryFolder()
+        {
+            m_path = filesystem::temp_directory_path() / (L"ProtonDrive.Tests." + to_wstring(GetCurrentProcessId()) + L"." + to_wstring(GetTickCount64()));
+            filesystem::create_directories(m_path);
+        }
+
+        ~TemporaryFolder()
+        {
+            error_code error;
+            filesystem::remove_all(m_path, error);
+        }
+
+        TemporaryFolder(const TemporaryFolder&) = delete;
+        TemporaryFolder& operator=(const TemporaryFolder&) = delete;
+
+        [[nodiscard]] const filesystem::path& GetPath() const { return m_path; }
+
+    private:
+        filesystem::path m_path;
+    };
+
+    TEST_CLASS(PathCanonicalizationTests)
+    {
+    public:
+        TEST_METHOD(LocalDevicePrefixIsRemoved)
+        {
+            Assert::AreEqual(wstring(L"C:\\USERS\\PUBLIC"), CanonicalizePath(L"\\\\?\\C:\\Users\\Public"));
+        }
+
+        TEST_METHOD(LocalDeviceUncPrefixBecomesUncPrefix)
+        {
+            Assert::AreEqual(wstring(L"\\\\SERVER\\SHARE\\FOLDER"), CanonicalizePath(L"\\\\?\\UNC\\server\\share\\folder"));
+        }
+
+        TEST_METHOD(DeviceNamespacePrefixIsRemoved)
+        {
+            Assert::AreEqual(wstring(L"C:\\USERS\\PUBLIC"), CanonicalizePath(L"\\\\.\\C:\\Users\\Public"));
+        }
+
+        TEST_METHOD(ObjectManagerPrefixIsRemoved)
+        {
+            Assert::AreEqual(wstring(L"C:\\USERS\\PUBLIC"), CanonicalizePath(L"\\??\\C:\\Users\\Public"));
+        }
+
+        TEST_METHOD(PrefixedAndPlainSpellingsHaveTheSameKey)
+        {
+            const auto key = CanonicalizePath(L"C:\\Users\\Public");
+
+            Assert::AreEqual(key, CanonicalizePath(L"\\\\?\\C:\\Users\\Public"));
+            Assert::AreEqual(key, CanonicalizePath(L"\\\\.\\c:\\users\\public\\"));
+            Assert::AreEqual(CanonicalizePath(L"\\\\server\\share"), CanonicalizePath(L"\\\\?\\UNC\\SERVER\\Share\\"));
+        }
+
+        TEST_METHOD(UncPathKeepsItsPrefix)
+        {
+            Assert::AreEqual(wstring(L"\\\\SERVER\\SHARE\\A"), CanonicalizePath(L"\\\\server\\share\\a"));
+        }
+
+        TEST_METHOD(TrailingSeparatorsAreRemoved)
+        {
+            Assert::AreEqual(wstring(L"C:\\A\\B"), CanonicalizePath(L"C:\\A\\B\\"));
+            Assert::AreEqual(wstring(L"C:\\A\\B"), CanonicalizePath(L"C:\\A\\B\\\\\\"));
+            Assert::AreEqual(wstring(L"C:\\A\\B"), CanonicalizePath(L"C:\\A\\B/"));
+        }
+
+        TEST_METHOD(DriveRootHasNoTrailingSeparator)
+        {
+            Assert::AreEqual(wstring(L"C:"), CanonicalizePath(L"C:\\"));
+            Assert::AreEqual(wstring(L"C:"), CanonicalizePath(L"\\\\?\\C:\\"));
+        }
+
+        TEST_METHOD(MixedAndRepeatedSeparatorsAreFolded)
+        {
+            Assert::AreEqual(wstring(L"C:\\A\\B\\C"), CanonicalizePath(L"C:/A\\\\B//C"));
+            Assert::AreEqual(wstring(L"C:\\A\\B\\C"), CanonicalizePath(L"C:\\A/\\/B\\C"));
+        }
+
+        TEST_METHOD(EmptyPathHasEmptyKey)
+        {
+            Assert::AreEqual(wstring(), CanonicalizePath(L""));
+            Assert::AreEqual(wstring(), CanonicalizePath(L"\\\\?\\"));
+        }
+
+        TEST_METHOD(AsciiLettersAreUpperCased)
+        {
+            Assert::AreEqual(wstring(L"C:\\ABC XYZ-09.TXT"), CanonicalizePath(L"c:\\abc xyz-09.txt"));
+        }
+
+        TEST_METHOD(NonAsciiLettersAreUpperCased)
+        {
+            Assert::AreEqual(wstring(L"C:\\\u00C9T\u00C9\\\u0394\u0395\u039B\u03A4\u0391"), CanonicalizePath(L"C:\\\u00E9t\u00E9\\\u03B4\u03B5\u03BB\u03C4\u03B1"));
+            Assert::AreEqual(wstring(L"C:\\\u0414\u041E\u041C"), CanonicalizePath(L"C:\\\u0434\u043E\u043C"));
+            Assert::AreEqual(wstring(L"C:\\\uFF21\uFF22"), CanonicalizePath(L"C:\\\uFF41\uFF42"));
+        }
+
+        TEST_METHOD(NonAsciiCaseVariantsHaveTheSameKey)
+        {
+            Assert::AreEqual(CanonicalizePath(L"C:\\\u00C9t\u00E9"), CanonicalizePath(L"C:\\\u00E9T\u00C9"));
+            Assert::AreEqual(CanonicalizePath(L"C:\\\u03C3"), CanonicalizePath(L"C:\\\u03A3"));
+        }
+
+        TEST_METHOD(LettersWithoutSimpleUpperCaseAreKept)
+        {
+            // Upper-casing "ß" would need two characters, NTFS keeps it as it is
+            Assert::AreEqual(wstring(L"C:\\STRA\u00DFE"), CanonicalizePath(L"C:\\stra\u00DFe"));
+        }
+
+        TEST_METHOD(ShortNamesAreExpanded)
+        {
+            const TemporaryFolder folder;
+            const auto longPath = folder.GetPath() / L"Folder with a long name" / L"File with a long name.txt";
+            filesystem::create_directories(longPath.parent_path());
+            const auto file = CreateFile(longPath.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, nullptr);
+            Assert::IsTrue(file != INVALID_HANDLE_VALUE);
+            CloseHandle(file);
+
+            wchar_t shortPath[MAX_PATH];
+            const auto shortPathLength = GetShortPathName(longPath.c_str(), shortPath, ARRAYSIZE(shortPath));
+            Assert::IsTrue(shortPathLength > 0 && shortPathLength < ARRAYSIZE(shortPath));
+
+            if (wstring_view(shortPath).find(L'~') == wstring_view::npos)
+            {
+                Logger::WriteMessage("Short names are not generated on the volume of the temporary folder");
+                return;
+            }
+
+            const auto key = CanonicalizePath(shortPath);
+
+            Assert::AreEqual(CanonicalizePath(longPath.native()), key);
+            Assert::IsTrue(key.ends_with(L"\\FOLDER WITH A LONG NAME\\FILE WITH A LONG NAME.TXT"));
+        }
+
+        TEST_METHOD(NamesWithTildeThatExistAreKept)
+        {
+            const TemporaryFolder folder;
+            const auto path = folder.GetPath() / L"a~b folder";
+            filesystem::create_directories(path);
+
+            Assert::IsTrue(CanonicalizePath(path.native()).ends_with(L"\\A~B FOLDER"));
+        }
+
+        TEST_METHOD(NamesWithTildeThatDoNotExistAreKept)
+        {
+            Assert::AreEqual(wstring(L"C:\\NOT~1\\EXISTING~2.TXT"), CanonicalizePath(L"C:\\not~1\\existing~2.txt"));
+        }
+
+        TEST_METHOD(SubstDriveIsReplacedWithItsTarget)
+        {
+            const TemporaryFolder folder;
+            const auto subfolderPath = folder.GetPath() / L"Subfolder";
+            filesystem::create_directories(subfolderPath);
+
+            // The last free drive letter, drive targets are remembered per letter for a few seconds
+            const auto usedDrives = GetLogicalDrives();
+            auto driveLetter = L'Z';
+            while (driveLetter > L'D' && (usedDrives & (1U << (driveLetter - L'A'))) != 0)
+            {
+                --driveLetter;
+            }
+
+            if ((usedDrives & (1U << (driveLetter - L'A'))) != 0)
+            {
+                Logger::WriteMessage("No free drive letter");
+                return;
+            }
+
+            const wchar_t deviceName[] = { driveLetter, L':', 0 };
+            Assert::IsTrue(DefineDosDevice(0, deviceName, folder.GetPath().c_str()) != FALSE);
+
+            const auto key = CanonicalizePath(wstring(deviceName) + L"\\subfolder");
+
+            (void)DefineDosDevice(DDD_REMOVE_DEFINITION | DDD_EXACT_MATCH_ON_REMOVE, deviceName, folder.GetPath().c_str());
+
+            Assert::AreEqual(CanonicalizePath(subfolderPath.native()), key);
+        }
+
+        TEST_METHOD(SubstDeviceTargetIsConverted)
+        {
+            Assert::AreEqual(wstring(L"C:\\Projects"), ConvertDosDeviceTargetToPath(L"\\??\\C:\\Projects"));
+        }
+
+        TEST_METHOD(NetworkDriveDeviceTargetIsConverted)
+        {
+            Assert::AreEqual(wstring(L"\\\\server\\share"), ConvertDosDeviceTargetToPath(L"\\Device\\LanmanRedirector;Z:000000000001a2b3\\server\\share"));
+            Assert::AreEqual(wstring(L"\\\\server\\share\\folder"), ConvertDosDeviceTargetToPath(L"\\Device\\Mup;Z:000000000001a2b3\\server\\share\\folder"));
+        }
+
+        TEST_METHOD(OtherDeviceTargetsAreNotConverted)
+        {
+            Assert::AreEqual(wstring(), ConvertDosDeviceTargetToPath(L"\\Device\\HarddiskVolume3"));
+            Assert::AreEqual(wstring(), ConvertDosDeviceTargetToPath(L"\\Device\\LanmanRedirector;Z:000000000001a2b3"));
+            Assert::AreEqual(wstring(), ConvertDosDeviceTargetToPath(L""));
+        }
+
+        TEST_METHOD(NameIsUpperCasedAndNothingElse)
+        {
+            pmr::wstring key;
+
+            CanonicalizeName(L"r\u00E9sum\u00E9 ~1.txt", key);
+            Assert::AreEqual(L"R\u00C9SUM\u00C9 ~1.TXT", key.c_str());
+
+            CanonicalizeName(L"a/b\\", key);
+            Assert::AreEqual(L"A/B\\", key.c_str());
+        }
+
+        TEST_METHOD(PolymorphicStringGetsTheSameKey)
+        {
+            pmr::wstring key;
+            CanonicalizePath(L"\\\\?\\c:\\a//b\\", key);
+
+            Assert::AreEqual(CanonicalizePath(L"C:\\A\\B").c_str(), key.c_str());
+        }
+
+        TEST_METHOD(SameCanonicalPathIsOrdinal)
+        {
+            Assert::IsTrue(IsSameCanonicalPath(L"C:\\A", L"C:\\A"));
+            Assert::IsFalse(IsSameCanonicalPath(L"C:\\A", L"C:\\a"));
+            Assert::IsFalse(IsSameCanonicalPath(L"C:\\A", L"C:\\A\\B"));
+            Assert::IsTrue(IsSameCanonicalPath(L"", L""));
+        }
+
+        TEST_METHOD(AncestorMustEndAtSeparator)
+        {
+            Assert::IsTrue(IsSameOrAncestorCanonicalPath(L"C:\\A", L"C:\\A\\B"));
+            Assert::IsTrue(IsSameOrAncestorCanonicalPath(L"C:\\A", L"C:\\A"));
+            Assert::IsFalse(IsSameOrAncestorCanonicalPath(L"C:\\A", L"C:\\AB"));
+            Assert::IsFalse(IsSameOrAncestorCanonicalPath(L"C:\\A", L"C:\\A B"));
+            Assert::IsFalse(IsSameOrAncestorCanonicalPath(L"C:\\A\\B", L"C:\\A"));
+        }
+
+        TEST_METHOD(EmptyPathIsNobodysAncestor)
+        {
+            Assert::IsFalse(IsSameOrAncestorCanonicalPath(L"", L"C:\\A"));
+            Assert::IsFalse(IsSameOrAncestorCanonicalPath(L"", L""));
+            Assert::IsFalse(AreRelatedCanonicalPaths(L"", L"C:\\A"));
+            Assert::IsFalse(AreRelatedCanonicalPaths(L"C:\\A", L""));
+        }
+
+        TEST_METHOD(DriveRootIsAncestorOfEverythingOnTheDrive)
+        {
+            Assert::IsTrue(AreRelatedCanonicalPaths(CanonicalizePath(L"C:\\"), CanonicalizePath(L"C:\\Users")));
+            Assert::IsFalse(AreRelatedCanonicalPaths(CanonicalizePath(L"C:\\"), CanonicalizePath(L"D:\\Users")));
+        }
+
+        TEST_METHOD(RelationIsSymmetric)
+        {
+            Assert::IsTrue(AreRelatedCanonicalPaths(L"C:\\A", L"C:\\A\\B\\C"));
+            Assert::IsTrue(AreRelatedCanonicalPaths(L"C:\\A\\B\\C", L"C:\\A"));
+            Assert::IsTrue(AreRelatedCanonicalPaths(L"C:\\A", L"C:\\A"));
+        }
+
+        TEST_METHOD(SiblingsWithCommonPrefixAreUnrelated)
+        {
+            Assert::IsFalse(AreRelatedCanonicalPaths(L"C:\\PHOTOS", L"C:\\PHOTOS 2"));
+            Assert::IsFalse(AreRelatedCanonicalPaths(L"C:\\PHOTOS 2\\A", L"C:\\PHOTOS"));
+            Assert::IsFalse(AreRelatedCanonicalPaths(L"\\\\SERVER\\SHARE", L"\\\\SERVER\\SHARE2"));
+            Assert::IsFalse(AreRelatedCanonicalPaths(L"C:\\A\\B", L"C:\\A\\C"));
+        }
+
+        TEST_METHOD(UncPathsAreNetworkPaths)
+        {
+            Assert::IsTrue(IsNetworkCanonicalPath(CanonicalizePath(L"\\server\share\a")));
+            Assert::IsTrue(IsNetworkCanonicalPath(CanonicalizePath(L"\\?\UNC\server\share")));
+            Assert::IsFalse(IsNetworkCanonicalPath(CanonicalizePath(L"\\?\C:\Users")));
+            Assert::IsFalse(IsNetworkCanonicalPath(CanonicalizePath(L"C:\Users")));
+        }
+
+        TEST_METHOD(DifferentlySpelledPathsAreRelated)
+        {
+            Assert::IsTrue(AreRelatedCanonicalPaths(CanonicalizePath(L"\\\\?\\C:\\Data\\"), CanonicalizePath(L"c:/data/Sub")));
+            Assert::IsTrue(AreRelatedCanonicalPaths(CanonicalizePath(L"\\\\?\\UNC\\Server\\Share"), CanonicalizePath(L"\\\\server\\share\\x")));
+        }
+    };
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+// The same headers the shell extension precompiles, the code under test relies on them
+#include "../ProtonDrive.App.Windows.ShellExtension/pch.h"
+
+#include <filesystem>
+
+#include <CppUnitTest.h>
@@ -0,0 +1,90 @@
+#include "pch.h"
+#include "AllocationAccounting.h"
+
+using namespace std;
+using namespace nlohmann;
+
+void to_json(json& j, const AllocationGauge& gauge)
+{
+    j = json{
+        {NAMEOF(gauge.subsystem), gauge.subsystem},
+        {NAMEOF(gauge.bytes), gauge.bytes},
+        {NAMEOF(gauge.count), gauge.count},
+        {NAMEOF(gauge.peakBytes), gauge.peakBytes},
+        {NAMEOF(gauge.totalCount), gauge.totalCount},
+    };
+}
+
+AllocationAccounting& AllocationAccounting::GetInstance()
+{
+    static AllocationAccounting instance;
+    return instance;
+}
+
+#ifdef ALLOCATION_ACCOUNTING
+
+pmr::memory_resource* AllocationAccounting::GetResource(_In_ const AllocationSubsystem subsystem)
+{
+    return &m_resources[static_cast<size_t>(subsystem)];
+}
+
+void AllocationAccounting::GetGauges(_Out_ vector<AllocationGauge>& gauges) const
+{
+    gauges.clear();
+
+    for (size_t i = 0; i < m_resources.size(); ++i)
+    {
+        auto& gauge = gauges.emplace_back(m_resources[i].GetGauge());
+        gauge.subsystem = NAMEOF_ENUM(static_cast<AllocationSubsystem>(i));
+    }
+}
+
+AllocationGauge AllocationAccounting::CountingMemoryResource::GetGauge() const
+{
+    AllocationGauge gauge;
+    gauge.bytes = m_bytes.load(memory_order_relaxed);
+    gauge.count = m_count.load(memory_order_relaxed);
+    gauge.peakBytes = m_peakBytes.load(memory_order_relaxed);
+    gauge.totalCount = m_totalCount.load(memory_order_relaxed);
+
+    return gauge;
+}
+
+void* AllocationAccounting::CountingMemoryResource::do_allocate(const size_t bytes, const size_t alignment)
+{
+    const auto pointer = pmr::new_delete_resource()->allocate(bytes, alignment);
+
+    m_count.fetch_add(1, memory_order_relaxed);
+    m_totalCount.fetch_add(1, memory_order_relaxed);
+
+    const auto heldBytes = m_bytes.fetch_add(bytes, memory_order_relaxed) + bytes;
+
+    auto peakBytes = m_peakBytes.load(memory_order_relaxed);
+    while (heldBytes > peakBytes && !m_peakBytes.compare_exchange_weak(peakBytes, heldBytes, memory_order_relaxed))
+    {
+    }
+
+    return pointer;
+}
+
+void AllocationAccounting::CountingMemoryResource::do_deallocate(void* pointer, const size_t bytes, const size_t alignment)
+{
+    pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+
+    m_count.fetch_sub(1, memory_order_relaxed);
+    m_bytes.fetch_sub(bytes, memory_order_relaxed);
+}
+
+#else
+
+pmr::memory_resource* AllocationAccounting::GetResource(_In_ AllocationSubsystem /*subsystem*/)
+{
+    return pmr::new_delete_resource();
+}
+
+void AllocationAccounting::GetGauges(_Out_ vector<AllocationGauge>& gauges) const
+{
+    gauges.clear();
+}
+
+#endif
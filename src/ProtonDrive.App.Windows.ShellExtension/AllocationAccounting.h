@@ -0,0 +1,58 @@
+#pragma once
+
+#include "pch.h"
+
+enum struct AllocationSubsystem
+{
+    Invocation,
+    Ipc,
+    Count,
+};
+
+struct AllocationGauge
+{
+    std::string subsystem;
+    uint64_t bytes = 0;
+    uint64_t count = 0;
+    uint64_t peakBytes = 0;
+    uint64_t totalCount = 0;
+};
+
+void to_json(nlohmann::json& j, const AllocationGauge& gauge);
+
+/// Hands out the memory resources of the subsystems allocating through std::pmr. In builds defining ALLOCATION_ACCOUNTING,
+/// they count the bytes and blocks each subsystem holds, so that a host process running for days can be checked for leaks
+/// and unbounded growth through the statistics report. Otherwise they are the upstream resource and cost nothing.
+class AllocationAccounting
+{
+public:
+    static AllocationAccounting& GetInstance();
+
+    [[nodiscard]] std::pmr::memory_resource* GetResource(_In_ AllocationSubsystem subsystem);
+
+    /// Leaves the gauges empty unless accounting is compiled in
+    void GetGauges(_Out_ std::vector<AllocationGauge>& gauges) const;
+
+private:
+    AllocationAccounting() = default;
+
+#ifdef ALLOCATION_ACCOUNTING
+    class CountingMemoryResource : public std::pmr::memory_resource
+    {
+    public:
+        [[nodiscard]] AllocationGauge GetGauge() const;
+
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+        [[nodiscard]] bool do_is_equal(const memory_resource& other) const noexcept override { return this == &other; }
+
+        std::atomic<uint64_t> m_bytes = 0;
+        std::atomic<uint64_t> m_count = 0;
+        std::atomic<uint64_t> m_peakBytes = 0;
+        std::atomic<uint64_t> m_totalCount = 0;
+    };
+
+    std::array<CountingMemoryResource, static_cast<size_t>(AllocationSubsystem::Count)> m_resources;
+#endif
+};
@@ -0,0 +1,120 @@
+#include "pch.h"
+#include "CommandRing.h"
+
+#include "checksum.h"
+
+using namespace std;
+using namespace ATL;
+
+CommandRing::CommandRing(_In_ void* sectionView)
+    : m_header(static_cast<CommandRingHeader*>(sectionView)),
+    m_slots(static_cast<std::byte*>(sectionView) + COMMAND_RING_HEADER_SIZE)
+{
+}
+
+bool CommandRing::IsValid() const
+{
+    return m_header->signature == COMMAND_RING_SIGNATURE
+        && m_header->version == COMMAND_RING_VERSION
+        && m_header->numberOfSlots == COMMAND_RING_NUMBER_OF_SLOTS
+        && m_header->slotSize == COMMAND_RING_SLOT_SIZE;
+}
+
+CommandRingPostResult CommandRing::TryPost(_In_ string_view message)
+{
+    if (message.size() > COMMAND_RING_MAXIMUM_MESSAGE_SIZE)
+    {
+        return CommandRingPostResult::TooLarge;
+    }
+
+    auto position = m_header->enqueuePosition.load(memory_order_relaxed);
+    CommandRingSlotHeader* slot;
+
+    while (true)
+    {
+        slot = &GetSlot(position);
+
+        const auto sequence = slot->sequence.load(memory_order_acquire);
+        const auto difference = static_cast<int64_t>(sequence - position);
+
+        if (difference == 0)
+        {
+            if (m_header->enqueuePosition.compare_exchange_weak(position, position + 1, memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (difference < 0)
+        {
+            // The consumer has not yet freed the slot from the previous lap
+            m_header->numberOfOverflows.fetch_add(1, memory_order_relaxed);
+            return CommandRingPostResult::Full;
+        }
+        else
+        {
+            position = m_header->enqueuePosition.load(memory_order_relaxed);
+        }
+    }
+
+    slot->length = static_cast<uint32_t>(message.size());
+    slot->checksum = GetFnv1aHash(message);
+    memcpy(reinterpret_cast<std::byte*>(slot) + sizeof(CommandRingSlotHeader), message.data(), message.size());
+
+    // Fails if the consumer gave up waiting on this slot, in which case the message was not delivered
+    auto expectedSequence = position;
+    if (!slot->sequence.compare_exchange_strong(expectedSequence, position + 1, memory_order_release, memory_order_relaxed))
+    {
+        return CommandRingPostResult::Abandoned;
+    }
+
+    return CommandRingPostResult::Posted;
+}
+
+CommandRingSlotHeader& CommandRing::GetSlot(_In_ const uint64_t position) const
+{
+    const auto index = static_cast<size_t>(position & (COMMAND_RING_NUMBER_OF_SLOTS - 1));
+    return *reinterpret_cast<CommandRingSlotHeader*>(m_slots + index * COMMAND_RING_SLOT_SIZE);
+}
+
+_Success_(return == true) bool TryPostCommand(_In_ string_view message)
+{
+    if (message.size() > COMMAND_RING_MAXIMUM_MESSAGE_SIZE)
+    {
+        return false;
+    }
+
+    // The section exists only while the app is running, so it is opened for every message
+    CHandle sectionHandle(OpenFileMapping(FILE_MAP_READ | FILE_MAP_WRITE, FALSE, COMMAND_RING_SECTION_NAME));
+    if (!sectionHandle)
+    {
+        return false;
+    }
+
+    const auto sectionView = MapViewOfFile(sectionHandle, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, COMMAND_RING_SECTION_SIZE);
+    if (!sectionView)
+    {
+        return false;
+    }
+
+    auto ring = CommandRing(sectionView);
+
+    const auto posted = ring.IsValid() && ring.TryPost(message) == CommandRingPostResult::Posted;
+
+    UnmapViewOfFile(sectionView);
+
+    if (!posted)
+    {
+        return false;
+    }
+
+    CHandle eventHandle(OpenEvent(EVENT_MODIFY_STATE, FALSE, COMMAND_RING_EVENT_NAME));
+    if (!eventHandle)
+    {
+        // The app drains the ring periodically as well
+        return true;
+    }
+
+    SetEvent(eventHandle);
+
+    return true;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "pch.h"
+
+constexpr auto COMMAND_RING_SECTION_NAME = L"Local\\ProtonDrive.CommandRing";
+constexpr auto COMMAND_RING_EVENT_NAME = L"Local\\ProtonDrive.CommandRing.Posted";
+
+// The layout of the section is shared with the app, changing any of these requires bumping the version
+constexpr uint32_t COMMAND_RING_SIGNATURE = 0x52434450; // "PDCR"
+constexpr uint32_t COMMAND_RING_VERSION = 1;
+constexpr uint32_t COMMAND_RING_HEADER_SIZE = 256;
+constexpr uint32_t COMMAND_RING_NUMBER_OF_SLOTS = 256;
+constexpr uint32_t COMMAND_RING_SLOT_SIZE = 4096;
+constexpr uint32_t COMMAND_RING_SECTION_SIZE = COMMAND_RING_HEADER_SIZE + COMMAND_RING_NUMBER_OF_SLOTS * COMMAND_RING_SLOT_SIZE;
+
+struct CommandRingHeader
+{
+    uint32_t signature;
+    uint32_t version;
+    uint32_t numberOfSlots;
+    uint32_t slotSize;
+
+    /// Next position to be claimed by a producer
+    alignas(64) std::atomic<uint64_t> enqueuePosition;
+
+    /// Next position to be consumed, advanced by the app only
+    alignas(64) std::atomic<uint64_t> dequeuePosition;
+
+    /// Messages that did not fit, the producers fall back to the pipe for them
+    std::atomic<uint64_t> numberOfOverflows;
+};
+
+/// Each slot starts with this header, followed by the UTF-8 message.
+/// The slot at position p is free for a producer when its sequence equals p, and holds
+/// a complete message when its sequence equals p + 1. The consumer frees it by setting p + number of slots.
+struct CommandRingSlotHeader
+{
+    std::atomic<uint64_t> sequence;
+    uint32_t length;
+    uint32_t checksum;
+};
+
+constexpr uint32_t COMMAND_RING_MAXIMUM_MESSAGE_SIZE = COMMAND_RING_SLOT_SIZE - sizeof(CommandRingSlotHeader);
+
+static_assert(sizeof(CommandRingHeader) <= COMMAND_RING_HEADER_SIZE);
+static_assert((COMMAND_RING_NUMBER_OF_SLOTS & (COMMAND_RING_NUMBER_OF_SLOTS - 1)) == 0);
+static_assert(std::atomic<uint64_t>::is_always_lock_free);
+
+enum struct CommandRingPostResult
+{
+    Posted,
+    Full,
+    TooLarge,
+    Abandoned,
+};
+
+/// Multi-producer, single-consumer ring of fire-and-forget IPC messages in a shared memory section owned by the app.
+/// Producers never wait for the app. A producer that dies between claiming and publishing a slot stalls the consumer
+/// only until the app abandons that slot; a message written into an abandoned slot is then rejected by its checksum.
+class CommandRing
+{
+public:
+    explicit CommandRing(_In_ void* sectionView);
+
+    [[nodiscard]] bool IsValid() const;
+    [[nodiscard]] CommandRingPostResult TryPost(_In_ std::string_view message);
+
+private:
+    CommandRingHeader* m_header;
+    std::byte* m_slots;
+
+    [[nodiscard]] CommandRingSlotHeader& GetSlot(_In_ uint64_t position) const;
+};
+
+/// Posts the message to the ring of the running app and wakes the app up.
+/// Fails if the app is not running, the ring is full, or the message is too large for a slot.
+_Success_(return == true) bool TryPostCommand(_In_ std::string_view message);
@@ -0,0 +1,148 @@
+#include "pch.h"
+#include "ContentHasher.h"
+
+using namespace std;
+using namespace ATL;
+
+/// The provider is thread safe and costly to open, it is shared by all hashes of the process
+BCRYPT_ALG_HANDLE GetSha256AlgorithmProvider()
+{
+    static const auto s_algorithmProvider = []
+    {
+        BCRYPT_ALG_HANDLE algorithmProvider = nullptr;
+        if (!BCRYPT_SUCCESS(BCryptOpenAlgorithmProvider(&algorithmProvider, BCRYPT_SHA256_ALGORITHM, nullptr, 0)))
+        {
+            return static_cast<BCRYPT_ALG_HANDLE>(nullptr);
+        }
+
+        return algorithmProvider;
+    }();
+
+    return s_algorithmProvider;
+}
+
+ContentHasher::ContentHasher(_In_ const uint64_t minimumSize, _In_ const DWORD timeBudgetMilliseconds)
+    : m_minimumSize(minimumSize),
+    m_timeBudgetMilliseconds(timeBudgetMilliseconds)
+{
+}
+
+vector<optional<ContentHash>> ContentHasher::Hash(_In_ const vector<wstring>& paths)
+{
+    vector<optional<ContentHash>> hashes(paths.size());
+
+    if (GetSha256AlgorithmProvider() == nullptr)
+    {
+        return hashes;
+    }
+
+    m_deadline = GetTickCount64() + m_timeBudgetMilliseconds;
+    m_nextIndex = 0;
+
+    // Reading is mostly sequential within a file, several files at once keep the disk and the CPU busy
+    const auto numberOfThreads = static_cast<unsigned int>((min<size_t>)({ paths.size(), thread::hardware_concurrency(), MAXIMUM_NUMBER_OF_THREADS }));
+
+    vector<thread> threads;
+    threads.reserve(numberOfThreads);
+    for (unsigned int i = 1; i < numberOfThreads; ++i)
+    {
+        try
+        {
+            threads.emplace_back([this, &paths, &hashes] { RunWorker(paths, hashes); });
+        }
+        catch (...)
+        {
+            // Fewer threads only hash fewer files within the budget, the started ones are still joined below
+            break;
+        }
+    }
+
+    RunWorker(paths, hashes);
+
+    for (auto& workerThread : threads)
+    {
+        workerThread.join();
+    }
+
+    return hashes;
+}
+
+void ContentHasher::RunWorker(_In_ const vector<wstring>& paths, _Inout_ vector<optional<ContentHash>>& hashes)
+{
+    vector<byte> buffer(READ_BLOCK_SIZE);
+
+    for (auto index = m_nextIndex++; index < paths.size() && GetTickCount64() < m_deadline; index = m_nextIndex++)
+    {
+        hashes[index] = HashFile(paths[index], buffer);
+    }
+}
+
+optional<ContentHash> ContentHasher::HashFile(_In_ const wstring& path, _Inout_ vector<byte>& buffer) const
+{
+    CHandle file;
+    const auto fileHandle = CreateFile(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+    {
+        return nullopt;
+    }
+
+    file.Attach(fileHandle);
+
+    FILE_ATTRIBUTE_TAG_INFO attributeInformation;
+    LARGE_INTEGER size;
+    if (!GetFileInformationByHandleEx(file, FileAttributeTagInfo, &attributeInformation, sizeof(attributeInformation))
+        || !GetFileSizeEx(file, &size))
+    {
+        return nullopt;
+    }
+
+    // Reading would download files of other cloud storage providers
+    if ((attributeInformation.FileAttributes & (FILE_ATTRIBUTE_RECALL_ON_DATA_ACCESS | FILE_ATTRIBUTE_OFFLINE)) != 0
+        || static_cast<uint64_t>(size.QuadPart) < m_minimumSize)
+    {
+        return nullopt;
+    }
+
+    BCRYPT_HASH_HANDLE hashHandle = nullptr;
+    if (!BCRYPT_SUCCESS(BCryptCreateHash(GetSha256AlgorithmProvider(), &hashHandle, nullptr, 0, nullptr, 0, 0)))
+    {
+        return nullopt;
+    }
+
+    ContentHash hash;
+    auto succeeded = true;
+
+    while (true)
+    {
+        DWORD numberOfBytesRead;
+        if (!ReadFile(file, buffer.data(), static_cast<DWORD>(buffer.size()), &numberOfBytesRead, nullptr)
+            || GetTickCount64() >= m_deadline)
+        {
+            succeeded = false;
+            break;
+        }
+
+        if (numberOfBytesRead == 0)
+        {
+            break;
+        }
+
+        if (!BCRYPT_SUCCESS(BCryptHashData(hashHandle, reinterpret_cast<PUCHAR>(buffer.data()), numberOfBytesRead, 0)))
+        {
+            succeeded = false;
+            break;
+        }
+
+        hash.size += numberOfBytesRead;
+    }
+
+    succeeded = BCRYPT_SUCCESS(BCryptFinishHash(hashHandle, reinterpret_cast<PUCHAR>(hash.sha256.data()), static_cast<ULONG>(hash.sha256.size()), 0)) && succeeded;
+    BCryptDestroyHash(hashHandle);
+
+    if (!succeeded)
+    {
+        return nullopt;
+    }
+
+    return hash;
+}
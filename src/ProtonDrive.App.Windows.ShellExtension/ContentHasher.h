@@ -0,0 +1,32 @@
+#pragma once
+
+#include "pch.h"
+
+struct ContentHash
+{
+    uint64_t size = 0;
+    std::array<std::byte, 32> sha256 = {};
+};
+
+/// Computes SHA-256 hashes of file contents with several threads, each reading its file sequentially in large blocks.
+/// Files below the minimum size, not stored locally, unreadable or not done within the time budget get no hash.
+class ContentHasher
+{
+public:
+    ContentHasher(_In_ uint64_t minimumSize, _In_ DWORD timeBudgetMilliseconds);
+
+    [[nodiscard]] std::vector<std::optional<ContentHash>> Hash(_In_ const std::vector<std::wstring>& paths);
+
+private:
+    static constexpr unsigned int MAXIMUM_NUMBER_OF_THREADS = 4;
+    static constexpr DWORD READ_BLOCK_SIZE = 1 << 20;
+
+    uint64_t m_minimumSize;
+    DWORD m_timeBudgetMilliseconds;
+    ULONGLONG m_deadline = 0;
+
+    std::atomic<size_t> m_nextIndex = 0;
+
+    void RunWorker(_In_ const std::vector<std::wstring>& paths, _Inout_ std::vector<std::optional<ContentHash>>& hashes);
+    [[nodiscard]] std::optional<ContentHash> HashFile(_In_ const std::wstring& path, _Inout_ std::vector<std::byte>& buffer) const;
+};
@@ -1,7 +1,8 @@
 #include "pch.h"
 #include "ContextMenuCommandBase.h"
 
-ContextMenuCommandBase::ContextMenuCommandBase(const ATL::CComPtr<IShellItemArray>& selectedShellItems)
+ContextMenuCommandBase::ContextMenuCommandBase(const ATL::CComPtr<IShellItemArray>& selectedShellItems, std::pmr::memory_resource* memoryResource)
+    : m_memoryResource(memoryResource)
 {
     m_selectedShellItems = selectedShellItems;
 }
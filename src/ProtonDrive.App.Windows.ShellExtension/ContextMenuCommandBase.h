@@ -2,11 +2,41 @@
 class ContextMenuCommandBase
 {
 public:
-    ContextMenuCommandBase(const ATL::CComPtr<IShellItemArray>& selectedShellItems);
+    ContextMenuCommandBase(const ATL::CComPtr<IShellItemArray>& selectedShellItems, std::pmr::memory_resource* memoryResource);
     [[nodiscard]] virtual bool CanExecute() const = 0;
-    virtual void Execute() const = 0;
+    virtual void Execute(_In_opt_ HWND ownerWindow) const = 0;
     virtual ~ContextMenuCommandBase();
 
 protected:
     ATL::CComPtr<IShellItemArray> m_selectedShellItems;
+
+    /// Backs the temporaries of the current context menu invocation
+    std::pmr::memory_resource* m_memoryResource;
+
+    [[nodiscard]] bool IsTrueForAllSelectedItems(_In_ auto& predicate) const
+    {
+        ATL::CComPtr<IEnumShellItems> shellItemEnumerator;
+        auto result = m_selectedShellItems->EnumItems(&shellItemEnumerator);
+        ATLENSURE_SUCCEEDED(result);
+
+        while (true)
+        {
+            ATL::CComPtr<IShellItem> currentSelectedItem;
+            ULONG numberOfItemsFetched;
+            result = shellItemEnumerator->Next(1, &currentSelectedItem, &numberOfItemsFetched);
+            ATLENSURE_SUCCEEDED(result);
+
+            if (numberOfItemsFetched <= 0)
+            {
+                break;
+            }
+
+            if (!predicate(*currentSelectedItem))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
 };
@@ -1,38 +1,42 @@
 #include "pch.h"
 #include "ContextMenuHandler.h"
 
+#include "DegradationController.h"
 #include "graphics.h"
+#include "HostProcessPolicy.h"
+#include "LatencyRecorder.h"
+#include "SyncStateCache.h"
 
 using namespace std;
 using namespace ATL;
 using namespace nlohmann;
 
-std::map<CommandId, CContextMenuHandler::MenuItem> CContextMenuHandler::s_menuItemMap =
+constexpr ULONGLONG PREFETCH_TIME_BUDGET_MILLISECONDS = 500;
+
+CContextMenuHandler::CContextMenuHandler()
+    : m_commandIdMap(m_arena.GetResource())
 {
+}
+
+IFACEMETHODIMP CContextMenuHandler::Initialize(PCIDLIST_ABSOLUTE pidlFolder, IDataObject* pdtobj, HKEY /*hkeyProgID*/)
+{
+    // The shell releases the handler without querying the menu
+    if (GetHostProcessPolicy() == HostProcessPolicy::Disabled)
     {
-        CommandId::ShareByUrl,
-        {
-            IDS_SHARE_BY_LINK_MENU_ITEM_HEADER,
-            IDS_SHARE_BY_LINK_DESCRIPTION,
-            L"shareByProtonDriveUrl",
-            [](const CContextMenuHandler& x) -> const ContextMenuCommandBase& { return *x.m_shareByUrlCommand; }
-        }
-    },
-    {
-        CommandId::MoveToDrive,
-        {
-            IDS_MOVE_TO_DRIVE_MENU_ITEM_HEADER,
-            IDS_MOVE_TO_DRIVE_DESCRIPTION,
-            L"moveToProtonDrive",
-            [](const CContextMenuHandler& x) -> const ContextMenuCommandBase& { return *x.m_moveToDriveCommand; }
-        }
+        return E_NOTIMPL;
     }
-};
 
-CContextMenuHandler::CContextMenuHandler() = default;
+    const LatencyScope latencyScope(LatencyPhase::Initialize);
+
+    // Everything allocated during the previous invocation is released at once
+    m_commandIdMap.clear();
+    m_shareByUrlCommand.reset();
+    m_moveToDriveCommand.reset();
+    m_keepOnDeviceCommand.reset();
+    m_freeUpSpaceCommand.reset();
+    m_selectedShellItems.Release();
+    m_arena.Release();
 
-IFACEMETHODIMP CContextMenuHandler::Initialize(PCIDLIST_ABSOLUTE pidlFolder, IDataObject* pdtobj, HKEY /*hkeyProgID*/)
-{
     const auto result = SHCreateShellItemArrayFromDataObject(pdtobj, IID_PPV_ARGS(&m_selectedShellItems));
     if (FAILED(result))
     {
@@ -44,8 +48,10 @@ IFACEMETHODIMP CContextMenuHandler::Initialize(PCIDLIST_ABSOLUTE pidlFolder, IDa
         return E_FAIL;
     }
 
-    m_shareByUrlCommand = make_unique<ShareByUrlCommand>(m_selectedShellItems);
-    m_moveToDriveCommand = make_unique<MoveToDriveCommand>(m_selectedShellItems);
+    m_shareByUrlCommand = make_unique<ShareByUrlCommand>(m_selectedShellItems, m_arena.GetResource());
+    m_moveToDriveCommand = make_unique<MoveToDriveCommand>(m_selectedShellItems, m_arena.GetResource());
+    m_keepOnDeviceCommand = make_unique<KeepOnDeviceCommand>(m_selectedShellItems, m_arena.GetResource());
+    m_freeUpSpaceCommand = make_unique<FreeUpSpaceCommand>(m_selectedShellItems, m_arena.GetResource());
 
     return S_OK;
 }
@@ -59,7 +65,23 @@ IFACEMETHODIMP CContextMenuHandler::QueryContextMenu(HMENU hmenu, UINT indexMenu
             return E_FAIL;
         }
 
-        static constexpr array CommandIds = {CommandId::ShareByUrl, CommandId::MoveToDrive};
+        LatencyRecorder::GetInstance().ReportIfDue();
+
+        const FirstUseScope firstUseScope;
+        const LatencyScope latencyScope(LatencyPhase::QueryContextMenu);
+
+        // Still measured, so that the menu items come back once the host process is responsive again
+        if (DegradationController::GetInstance().GetMode() == DegradationMode::HideMenuItems)
+        {
+            return MAKE_HRESULT(SEVERITY_SUCCESS, FACILITY_NULL, 0);
+        }
+
+        // The commands ask for these one after the other, on a cold cache querying them at once saves round trips
+        SyncStateCache::GetInstance().Prefetch(
+            { { SyncRootType::CloudFiles }, { SyncRootType::CloudFiles, SyncRootType::HostDeviceFolder, SyncRootType::ForeignDevice } },
+            GetTickCount64() + PREFETCH_TIME_BUDGET_MILLISECONDS);
+
+        static constexpr array CommandIds = {CommandId::ShareByUrl, CommandId::MoveToDrive, CommandId::KeepOnDevice, CommandId::FreeUpSpace};
 
         auto menuCommandIdOffset = 0U;
 
@@ -91,7 +113,15 @@ IFACEMETHODIMP CContextMenuHandler::InvokeCommand(LPCMINVOKECOMMANDINFO pici)
                 return E_FAIL;
             }
 
-            s_menuItemMap[commandIdIterator->second].GetCommand(*this).Execute();
+            const LatencyScope latencyScope(LatencyPhase::InvokeCommand);
+
+            const auto menuItem = TryGetMenuItem(commandIdIterator->second);
+            if (!menuItem)
+            {
+                return E_FAIL;
+            }
+
+            menuItem->GetCommand(*this).Execute(pici->hwnd);
 
             // TODO: handle failure and display message box
 
@@ -144,7 +174,8 @@ void CContextMenuHandler::InsertDriveMenuItem(
     _In_ const UINT firstMenuCommandId,
     _Inout_ UINT& menuCommandIdOffset)
 {
-    const auto& command = s_menuItemMap[commandId].GetCommand(*this);
+    const auto& menuItem = s_menuItems[static_cast<size_t>(commandId)];
+    const auto& command = menuItem.GetCommand(*this);
 
     if (!command.CanExecute())
     {
@@ -154,7 +185,7 @@ void CContextMenuHandler::InsertDriveMenuItem(
     MENUITEMINFO menuItemInfo;
 
     wchar_t menuName[64] = { 0 };
-    LoadString(_AtlBaseModule.GetModuleInstance(), s_menuItemMap[commandId].HeaderStringId, menuName, ARRAYSIZE(menuName));
+    LoadString(_AtlBaseModule.GetModuleInstance(), menuItem.HeaderStringId, menuName, ARRAYSIZE(menuName));
 
     menuItemInfo.cbSize = sizeof(MENUITEMINFO);
     menuItemInfo.fMask = MIIM_STRING | MIIM_FTYPE | MIIM_ID | MIIM_STATE;
@@ -204,28 +235,34 @@ void CContextMenuHandler::SetMenuItemIcon(_In_ MENUITEMINFO& menuItemInfo)
 
 HRESULT CContextMenuHandler::LoadDescription(_In_ const CommandId commandId, _Out_writes_(cchMax) LPWSTR pszName, _In_ const UINT cchMax)
 {
-    const auto descriptionStringIdIterator = s_menuItemMap.find(commandId);
-    if (descriptionStringIdIterator == s_menuItemMap.end())
+    const auto menuItem = TryGetMenuItem(commandId);
+    if (!menuItem)
     {
         return E_INVALIDARG;
     }
 
     wchar_t stringBuffer[64] = { 0 };
 
-    LoadString(_AtlBaseModule.GetModuleInstance(), descriptionStringIdIterator->second.DescriptionStringId, stringBuffer, ARRAYSIZE(stringBuffer));
+    LoadString(_AtlBaseModule.GetModuleInstance(), menuItem->DescriptionStringId, stringBuffer, ARRAYSIZE(stringBuffer));
 
     return StringCchCopyW(pszName, cchMax, stringBuffer);
 }
 
 HRESULT CContextMenuHandler::LoadVerb(_In_ const CommandId commandId, _Out_writes_(cchMax) LPWSTR pszName, _In_ const UINT cchMax)
 {
-    const auto verbIterator = s_menuItemMap.find(commandId);
-    if (verbIterator == s_menuItemMap.end())
+    const auto menuItem = TryGetMenuItem(commandId);
+    if (!menuItem)
     {
         return E_INVALIDARG;
     }
 
-    return StringCchCopyW(pszName, cchMax, verbIterator->second.Verb.c_str());
+    return StringCchCopyW(pszName, cchMax, menuItem->Verb);
+}
+
+const CContextMenuHandler::MenuItem* CContextMenuHandler::TryGetMenuItem(_In_ const CommandId commandId)
+{
+    const auto index = static_cast<size_t>(commandId);
+    return index < s_menuItems.size() ? &s_menuItems[index] : nullptr;
 }
 
 // CContextMenuHandler
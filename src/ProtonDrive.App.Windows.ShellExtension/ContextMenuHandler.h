@@ -5,6 +5,9 @@
 
 #include "WindowsShellExtension_i.h"
 
+#include "FreeUpSpaceCommand.h"
+#include "InvocationArena.h"
+#include "KeepOnDeviceCommand.h"
 #include "MoveToDriveCommand.h"
 #include "ShareByUrlCommand.h"
 
@@ -16,6 +19,9 @@ enum struct CommandId
 {
     ShareByUrl,
     MoveToDrive,
+    KeepOnDevice,
+    FreeUpSpace,
+    Count,
 };
 
 class ATL_NO_VTABLE CContextMenuHandler :
@@ -28,8 +34,8 @@ class ATL_NO_VTABLE CContextMenuHandler :
     {
         UINT HeaderStringId = 0;
         UINT DescriptionStringId = 0;
-        std::wstring Verb;
-        std::function<const ContextMenuCommandBase&(const CContextMenuHandler&)> GetCommand;
+        const wchar_t* Verb = nullptr;
+        const ContextMenuCommandBase& (*GetCommand)(const CContextMenuHandler&) = nullptr;
     };
 
 public:
@@ -55,13 +61,45 @@ public:
     DECLARE_PROTECT_FINAL_CONSTRUCT()
 
 private:
+    // Declared first, so that it outlives everything allocated from it
+    InvocationArena m_arena;
+
     ATL::CComPtr<IShellItemArray> m_selectedShellItems;
     SharedBitmapHandle m_iconBitmapHandle = nullptr;
-    std::map<ULONG, CommandId> m_commandIdMap;
+    std::pmr::map<ULONG, CommandId> m_commandIdMap;
     std::unique_ptr<const ShareByUrlCommand> m_shareByUrlCommand;
     std::unique_ptr<const MoveToDriveCommand> m_moveToDriveCommand;
-
-    static std::map<CommandId, MenuItem> s_menuItemMap;
+    std::unique_ptr<const KeepOnDeviceCommand> m_keepOnDeviceCommand;
+    std::unique_ptr<const FreeUpSpaceCommand> m_freeUpSpaceCommand;
+
+    /// Indexed by CommandId. Constant-initialized, so that loading the DLL into a process runs no initializers.
+    static constexpr std::array<MenuItem, static_cast<size_t>(CommandId::Count)> s_menuItems =
+    {{
+        {
+            IDS_SHARE_BY_LINK_MENU_ITEM_HEADER,
+            IDS_SHARE_BY_LINK_DESCRIPTION,
+            L"shareByProtonDriveUrl",
+            [](const CContextMenuHandler& x) -> const ContextMenuCommandBase& { return *x.m_shareByUrlCommand; }
+        },
+        {
+            IDS_MOVE_TO_DRIVE_MENU_ITEM_HEADER,
+            IDS_MOVE_TO_DRIVE_DESCRIPTION,
+            L"moveToProtonDrive",
+            [](const CContextMenuHandler& x) -> const ContextMenuCommandBase& { return *x.m_moveToDriveCommand; }
+        },
+        {
+            IDS_KEEP_ON_DEVICE_MENU_ITEM_HEADER,
+            IDS_KEEP_ON_DEVICE_DESCRIPTION,
+            L"keepOnDeviceWithProtonDrive",
+            [](const CContextMenuHandler& x) -> const ContextMenuCommandBase& { return *x.m_keepOnDeviceCommand; }
+        },
+        {
+            IDS_FREE_UP_SPACE_MENU_ITEM_HEADER,
+            IDS_FREE_UP_SPACE_DESCRIPTION,
+            L"freeUpSpaceWithProtonDrive",
+            [](const CContextMenuHandler& x) -> const ContextMenuCommandBase& { return *x.m_freeUpSpaceCommand; }
+        },
+    }};
 
     void InsertDriveMenuItem(
         _In_ HMENU menuHandle,
@@ -72,6 +110,7 @@ private:
 
     void SetMenuItemIcon(_In_ MENUITEMINFO& menuItemInfo);
     
+    [[nodiscard]] static const MenuItem* TryGetMenuItem(_In_ CommandId commandId);
     static HRESULT LoadDescription(_In_ CommandId commandId, _Out_writes_(cchMax) LPWSTR pszName, _In_ UINT cchMax);
     static HRESULT LoadVerb(_In_ CommandId commandId, _Out_writes_(cchMax) LPWSTR pszName, _In_ UINT cchMax);
 };
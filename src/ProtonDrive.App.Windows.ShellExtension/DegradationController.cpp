@@ -0,0 +1,71 @@
+#include "pch.h"
+#include "DegradationController.h"
+
+using namespace std;
+
+DegradationController& DegradationController::GetInstance()
+{
+    static DegradationController instance;
+    return instance;
+}
+
+bool DegradationController::Record(_In_ const uint64_t microseconds, _In_ const uint64_t nowMilliseconds)
+{
+    const lock_guard lock(m_mutex);
+
+    m_samples[m_numberOfSamples % WINDOW_SIZE] = microseconds;
+    ++m_numberOfSamples;
+
+    if (m_numberOfSamples < WINDOW_SIZE)
+    {
+        return false;
+    }
+
+    const auto mode = m_mode.load(memory_order_relaxed);
+
+    const auto numberOfSlowSamples = static_cast<size_t>(ranges::count_if(m_samples, [](const uint64_t x) { return x > LATENCY_BUDGET_MICROSECONDS; }));
+
+    if (numberOfSlowSamples >= NUMBER_OF_SLOW_SAMPLES_TO_DEGRADE && mode != DegradationMode::HideMenuItems)
+    {
+        const auto isRelapse = m_hasRecovered && nowMilliseconds - m_lastRecoveryTime < RELAPSE_MILLISECONDS;
+        m_dwellMilliseconds = isRelapse ? (std::min)(m_dwellMilliseconds * 2, MAXIMUM_DWELL_MILLISECONDS) : MINIMUM_DWELL_MILLISECONDS;
+
+        SetMode(static_cast<DegradationMode>(static_cast<int>(mode) + 1), numberOfSlowSamples, nowMilliseconds);
+        return true;
+    }
+
+    const auto isFast = ranges::all_of(m_samples, [](const uint64_t x) { return x < RECOVERY_LATENCY_MICROSECONDS; });
+
+    if (mode != DegradationMode::Normal && isFast && nowMilliseconds - m_modeStartTime >= m_dwellMilliseconds)
+    {
+        m_hasRecovered = true;
+        m_lastRecoveryTime = nowMilliseconds;
+
+        SetMode(static_cast<DegradationMode>(static_cast<int>(mode) - 1), numberOfSlowSamples, nowMilliseconds);
+        return true;
+    }
+
+    return false;
+}
+
+void DegradationController::TakeModeChanges(_Out_ vector<DegradationModeChange>& modeChanges)
+{
+    const lock_guard lock(m_mutex);
+
+    modeChanges = std::move(m_modeChanges);
+    m_modeChanges.clear();
+}
+
+void DegradationController::SetMode(_In_ const DegradationMode mode, _In_ const size_t numberOfSlowSamples, _In_ const uint64_t nowMilliseconds)
+{
+    if (m_modeChanges.size() >= MAXIMUM_NUMBER_OF_MODE_CHANGES)
+    {
+        m_modeChanges.erase(m_modeChanges.begin());
+    }
+
+    m_modeChanges.push_back({ m_mode.load(memory_order_relaxed), mode, numberOfSlowSamples });
+
+    m_mode.store(mode, memory_order_relaxed);
+    m_modeStartTime = nowMilliseconds;
+    m_numberOfSamples = 0;
+}
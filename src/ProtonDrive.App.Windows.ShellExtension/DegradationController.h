@@ -0,0 +1,74 @@
+#pragma once
+
+#include "pch.h"
+
+/// Ways of building the context menu, each one cheaper than the previous one
+enum struct DegradationMode
+{
+    /// Everything is checked, the app is queried when the cache has no answer
+    Normal,
+
+    /// Items that need an answer missing from the cache are not shown, the app is never waited for
+    CacheOnly,
+
+    /// Additionally, Move to Drive is not offered for large selections instead of checking every selected item
+    SkipLargeSelectionChecks,
+
+    /// No items are added to the menu
+    HideMenuItems,
+
+    Count,
+};
+
+struct DegradationModeChange
+{
+    DegradationMode previousMode;
+    DegradationMode mode;
+    size_t numberOfSlowSamples;
+};
+
+/// Switches the context menu of this host process to cheaper modes while its recent latencies exceed the budget,
+/// and back one mode at a time once they improve. The latencies of a cheaper mode do not tell how the more expensive
+/// one would perform, so a mode is left only after a dwell time, which doubles every time the cheaper mode has to be
+/// entered again soon after leaving it.
+class DegradationController
+{
+public:
+    static constexpr size_t WINDOW_SIZE = 16;
+    static constexpr size_t NUMBER_OF_SLOW_SAMPLES_TO_DEGRADE = WINDOW_SIZE / 2;
+    static constexpr uint64_t LATENCY_BUDGET_MICROSECONDS = 150'000;
+    static constexpr uint64_t RECOVERY_LATENCY_MICROSECONDS = LATENCY_BUDGET_MICROSECONDS / 2;
+    static constexpr uint64_t MINIMUM_DWELL_MILLISECONDS = 60'000;
+    static constexpr uint64_t MAXIMUM_DWELL_MILLISECONDS = 60 * 60'000;
+    static constexpr uint64_t RELAPSE_MILLISECONDS = 10 * 60'000;
+    static constexpr size_t MAXIMUM_NUMBER_OF_MODE_CHANGES = 16;
+
+    DegradationController() = default;
+
+    static DegradationController& GetInstance();
+
+    [[nodiscard]] DegradationMode GetMode() const { return m_mode.load(std::memory_order_relaxed); }
+
+    /// Returns true if the sample made the mode change
+    bool Record(_In_ uint64_t microseconds, _In_ uint64_t nowMilliseconds);
+
+    /// Takes the mode changes since the previous call, the oldest ones are dropped if there were too many
+    void TakeModeChanges(_Out_ std::vector<DegradationModeChange>& modeChanges);
+
+private:
+    std::mutex m_mutex;
+    std::atomic<DegradationMode> m_mode = DegradationMode::Normal;
+
+    /// Latencies of the current mode only
+    std::array<uint64_t, WINDOW_SIZE> m_samples {};
+    size_t m_numberOfSamples = 0;
+
+    uint64_t m_modeStartTime = 0;
+    uint64_t m_lastRecoveryTime = 0;
+    bool m_hasRecovered = false;
+    uint64_t m_dwellMilliseconds = MINIMUM_DWELL_MILLISECONDS;
+
+    std::vector<DegradationModeChange> m_modeChanges;
+
+    void SetMode(_In_ DegradationMode mode, _In_ size_t numberOfSlowSamples, _In_ uint64_t nowMilliseconds);
+};
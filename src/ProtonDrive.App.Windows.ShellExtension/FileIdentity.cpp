@@ -0,0 +1,84 @@
+#include "pch.h"
+#include "FileIdentity.h"
+
+#include "PathCanonicalization.h"
+
+using namespace std;
+using namespace ATL;
+
+bool FileIdentity::operator==(const FileIdentity& other) const
+{
+    return volumeSerialNumber == other.volumeSerialNumber
+        && memcmp(fileId.Identifier, other.fileId.Identifier, sizeof(fileId.Identifier)) == 0;
+}
+
+size_t FileIdentityHash::operator()(const FileIdentity& identity) const noexcept
+{
+    uint64_t fileIdParts[2];
+    memcpy(fileIdParts, identity.fileId.Identifier, sizeof(fileIdParts));
+
+    return hash<uint64_t>()(identity.volumeSerialNumber ^ fileIdParts[0] ^ rotl(fileIdParts[1], 32));
+}
+
+_Success_(return == true) bool TryOpenForIdentity(_In_z_ const LPCWSTR path, _In_ const bool followReparsePoint, _Out_ CHandle& handle)
+{
+    // FILE_FLAG_BACKUP_SEMANTICS is required for opening folders
+    const DWORD flags = FILE_FLAG_BACKUP_SEMANTICS | (followReparsePoint ? 0 : FILE_FLAG_OPEN_REPARSE_POINT);
+
+    const auto file = CreateFile(
+        path,
+        FILE_READ_ATTRIBUTES,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr,
+        OPEN_EXISTING,
+        flags,
+        nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    handle.Attach(file);
+    return true;
+}
+
+_Success_(return == true) bool TryGetFileIdentity(_In_ const HANDLE handle, _Out_ FileIdentity& identity)
+{
+    FILE_ID_INFO information;
+    if (!GetFileInformationByHandleEx(handle, FileIdInfo, &information, sizeof(information)))
+    {
+        return false;
+    }
+
+    identity.volumeSerialNumber = information.VolumeSerialNumber;
+    identity.fileId = information.FileId;
+    return true;
+}
+
+template <typename TString>
+_Success_(return == true) bool TryGetCanonicalFinalPath(_In_ const HANDLE handle, _Out_ TString& canonicalPath)
+{
+    TString finalPath(MAX_PATH, 0, canonicalPath.get_allocator());
+
+    auto length = GetFinalPathNameByHandle(handle, finalPath.data(), static_cast<DWORD>(finalPath.size()), FILE_NAME_NORMALIZED | VOLUME_NAME_DOS);
+    if (length >= finalPath.size())
+    {
+        // The returned length includes the terminating null character when the buffer is too small
+        finalPath.resize(length);
+        length = GetFinalPathNameByHandle(handle, finalPath.data(), static_cast<DWORD>(finalPath.size()), FILE_NAME_NORMALIZED | VOLUME_NAME_DOS);
+    }
+
+    if (length == 0 || length >= finalPath.size())
+    {
+        return false;
+    }
+
+    finalPath.resize(length);
+
+    CanonicalizePath(finalPath, canonicalPath);
+    return !canonicalPath.empty();
+}
+
+template _Success_(return == true) bool TryGetCanonicalFinalPath(_In_ HANDLE handle, _Out_ wstring& canonicalPath);
+template _Success_(return == true) bool TryGetCanonicalFinalPath(_In_ HANDLE handle, _Out_ pmr::wstring& canonicalPath);
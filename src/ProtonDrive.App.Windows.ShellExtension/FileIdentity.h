@@ -0,0 +1,28 @@
+#pragma once
+
+#include "pch.h"
+
+/// Identifies a file or folder regardless of the path it was reached through
+struct FileIdentity
+{
+    ULONGLONG volumeSerialNumber = 0;
+    FILE_ID_128 fileId = {};
+
+    [[nodiscard]] bool operator==(const FileIdentity& other) const;
+};
+
+struct FileIdentityHash
+{
+    [[nodiscard]] size_t operator()(const FileIdentity& identity) const noexcept;
+};
+
+/// Opens the file or folder with no access rights beyond reading its attributes.
+/// If the item is a reparse point, the reparse point itself is opened unless asked to follow it.
+_Success_(return == true) bool TryOpenForIdentity(_In_z_ LPCWSTR path, _In_ bool followReparsePoint, _Out_ ATL::CHandle& handle);
+
+_Success_(return == true) bool TryGetFileIdentity(_In_ HANDLE handle, _Out_ FileIdentity& identity);
+
+/// Canonical path of the opened item, with the junctions, symbolic links, subst and network drives
+/// along the way resolved to their targets
+template <typename TString>
+_Success_(return == true) bool TryGetCanonicalFinalPath(_In_ HANDLE handle, _Out_ TString& canonicalPath);
@@ -0,0 +1,8 @@
+#pragma once
+#include "HydrationCommandBase.h"
+
+class FreeUpSpaceCommand : public HydrationCommandBase
+{
+public:
+    FreeUpSpaceCommand(_In_ const ATL::CComPtr<IShellItemArray>& selectedShellItems, _In_ std::pmr::memory_resource* memoryResource);
+};
@@ -0,0 +1,54 @@
+#include "pch.h"
+#include "HostProcessPolicy.h"
+
+using namespace std;
+
+bool IsExplorerHostProcess()
+{
+    wchar_t modulePath[MAX_PATH];
+    const auto length = GetModuleFileName(nullptr, modulePath, ARRAYSIZE(modulePath));
+    if (length == 0 || length >= ARRAYSIZE(modulePath))
+    {
+        return false;
+    }
+
+    const auto modulePathView = wstring_view(modulePath, length);
+    const auto fileName = modulePathView.substr(modulePathView.find_last_of(L'\\') + 1);
+
+    constexpr auto explorerFileName = wstring_view(L"explorer.exe");
+
+    return CompareStringOrdinal(
+        fileName.data(),
+        static_cast<int>(fileName.size()),
+        explorerFileName.data(),
+        static_cast<int>(explorerFileName.size()),
+        TRUE) == CSTR_EQUAL;
+}
+
+HostProcessPolicy ReadConfiguredHostProcessPolicy()
+{
+    DWORD value = 0;
+    DWORD valueSize = sizeof(value);
+
+    const auto result = RegGetValue(
+        HKEY_CURRENT_USER,
+        HOST_PROCESS_POLICY_REGISTRY_KEY,
+        HOST_PROCESS_POLICY_REGISTRY_VALUE,
+        RRF_RT_REG_DWORD,
+        nullptr,
+        &value,
+        &valueSize);
+
+    if (result != ERROR_SUCCESS || value > static_cast<DWORD>(HostProcessPolicy::Disabled))
+    {
+        return HostProcessPolicy::OnDemand;
+    }
+
+    return static_cast<HostProcessPolicy>(value);
+}
+
+HostProcessPolicy GetHostProcessPolicy()
+{
+    static const auto policy = IsExplorerHostProcess() ? HostProcessPolicy::Full : ReadConfiguredHostProcessPolicy();
+    return policy;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "pch.h"
+
+/// How much of the extension is active in the process that loaded it. Explorer always gets all features;
+/// other processes showing shell context menus, such as file dialogs of arbitrary applications, get
+/// the policy configured for them, so that they do not keep a subscription connection to the app open.
+enum struct HostProcessPolicy
+{
+    /// Menu items with the sync state kept up to date by a background subscription
+    Full = 0,
+
+    /// Menu items with the sync state queried when the menu is shown, no background work
+    OnDemand = 1,
+
+    /// No menu items
+    Disabled = 2,
+};
+
+constexpr auto HOST_PROCESS_POLICY_REGISTRY_KEY = L"Software\\Proton\\Drive";
+constexpr auto HOST_PROCESS_POLICY_REGISTRY_VALUE = L"ShellExtensionHostPolicy";
+
+/// Determined once per process, from the host executable name and the per-user registry setting
+[[nodiscard]] HostProcessPolicy GetHostProcessPolicy();
@@ -0,0 +1,107 @@
+#include "pch.h"
+#include "HydrationCommandBase.h"
+
+#include "PathCanonicalization.h"
+#include "PathListEncoding.h"
+#include "SyncStateCache.h"
+
+using namespace std;
+using namespace ATL;
+using namespace nlohmann;
+
+struct HydrationCommandRequest : IpcMessage<FrontCodedPathList>
+{
+    HydrationCommandRequest(const wchar_t* messageType, vector<wstring> paths) : IpcMessage<FrontCodedPathList>(messageType, FrontCodedPathList(std::move(paths))) {}
+};
+
+HydrationCommandBase::HydrationCommandBase(
+    _In_ const CComPtr<IShellItemArray>& selectedShellItems,
+    _In_ pmr::memory_resource* memoryResource,
+    _In_ const wchar_t* messageType)
+    : ContextMenuCommandBase(selectedShellItems, memoryResource), m_messageType(messageType)
+{
+}
+
+bool HydrationCommandBase::CanExecute() const
+{
+    shared_ptr<const vector<wstring>> syncRootPathsPointer;
+    if (!SyncStateCache::GetInstance().TryGetSyncRootPaths({ SyncRootType::CloudFiles }, syncRootPathsPointer, m_memoryResource)
+        || syncRootPathsPointer->empty())
+    {
+        return false;
+    }
+
+    pmr::vector<pmr::wstring> rootPaths(m_memoryResource);
+    rootPaths.resize(syncRootPathsPointer->size());
+    for (size_t i = 0; i < syncRootPathsPointer->size(); ++i)
+    {
+        CanonicalizePath((*syncRootPathsPointer)[i], rootPaths[i]);
+    }
+
+    pmr::wstring canonicalSelectedItemPath(m_memoryResource);
+
+    const auto isInsideCloudFilesRoot = [&rootPaths, &canonicalSelectedItemPath](IShellItem& selectedItem)
+    {
+        SFGAOF attributes;
+        if (FAILED(selectedItem.GetAttributes(SFGAO_FILESYSTEM, &attributes)) || attributes == 0)
+        {
+            return false;
+        }
+
+        CComHeapPtr<WCHAR> selectedItemPath;
+        if (FAILED(selectedItem.GetDisplayName(SIGDN_FILESYSPATH, &selectedItemPath)))
+        {
+            return false;
+        }
+
+        CanonicalizePath(static_cast<LPCWSTR>(selectedItemPath), canonicalSelectedItemPath);
+        if (canonicalSelectedItemPath.empty())
+        {
+            return false;
+        }
+
+        return ranges::any_of(rootPaths, [&canonicalSelectedItemPath](const pmr::wstring& rootPath)
+        {
+            return !rootPath.empty() && IsSameOrAncestorCanonicalPath(rootPath, canonicalSelectedItemPath);
+        });
+    };
+
+    return IsTrueForAllSelectedItems(isInsideCloudFilesRoot);
+}
+
+void HydrationCommandBase::Execute(_In_opt_ HWND) const
+{
+    vector<wstring> paths;
+    if (!TryGetSelectedItemPaths(paths))
+    {
+        return;
+    }
+
+    if (!TrySendIpcMessage(HydrationCommandRequest(m_messageType, std::move(paths))))
+    {
+        AtlThrowLastWin32();
+    }
+}
+
+bool HydrationCommandBase::TryGetSelectedItemPaths(_Out_ vector<wstring>& paths) const
+{
+    DWORD numberOfItems;
+    const auto result = m_selectedShellItems->GetCount(&numberOfItems);
+    ATLENSURE_SUCCEEDED(result);
+
+    paths.reserve(numberOfItems);
+
+    const auto addPath = [&paths](IShellItem& selectedItem)
+    {
+        CComHeapPtr<WCHAR> selectedItemPath;
+        if (FAILED(selectedItem.GetDisplayName(SIGDN_FILESYSPATH, &selectedItemPath)))
+        {
+            return false;
+        }
+
+        paths.emplace_back(selectedItemPath);
+        return true;
+    };
+
+    return IsTrueForAllSelectedItems(addPath) && !paths.empty();
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include "ContextMenuCommandBase.h"
+
+/// Sends the whole selection to the app in a single request, which then changes the hydration of
+/// all placeholders under the selected items. Available only for items inside Cloud Files sync roots.
+class HydrationCommandBase : public ContextMenuCommandBase
+{
+public:
+    [[nodiscard]] bool CanExecute() const override;
+    void Execute(_In_opt_ HWND ownerWindow) const override;
+
+protected:
+    HydrationCommandBase(
+        _In_ const ATL::CComPtr<IShellItemArray>& selectedShellItems,
+        _In_ std::pmr::memory_resource* memoryResource,
+        _In_ const wchar_t* messageType);
+
+private:
+    const wchar_t* m_messageType;
+
+    _Success_(return == true) bool TryGetSelectedItemPaths(_Out_ std::vector<std::wstring>& paths) const;
+};
@@ -0,0 +1,16 @@
+#include "pch.h"
+#include "InvocationArena.h"
+
+#include "AllocationAccounting.h"
+
+using namespace std;
+
+InvocationArena::InvocationArena()
+    : m_initialBuffer(), m_resource(m_initialBuffer.data(), m_initialBuffer.size(), AllocationAccounting::GetInstance().GetResource(AllocationSubsystem::Invocation))
+{
+}
+
+void InvocationArena::Release()
+{
+    m_resource.release();
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "pch.h"
+
+/// Monotonic memory resource backing the temporaries of a single Initialize -> QueryContextMenu -> InvokeCommand
+/// cycle of the context menu handler. Nothing is freed individually, everything is released in one shot
+/// when the next cycle starts, which keeps the extension from fragmenting the heap of the host process.
+class InvocationArena
+{
+public:
+    InvocationArena();
+    InvocationArena(const InvocationArena&) = delete;
+    InvocationArena& operator=(const InvocationArena&) = delete;
+
+    [[nodiscard]] std::pmr::memory_resource* GetResource() { return &m_resource; }
+
+    /// Releases all the memory allocated since the previous release.
+    /// All the objects allocated from the arena must be destroyed beforehand.
+    void Release();
+
+private:
+    static constexpr size_t INITIAL_BUFFER_SIZE = 8 << 10;
+
+    alignas(std::max_align_t) std::array<std::byte, INITIAL_BUFFER_SIZE> m_initialBuffer;
+    std::pmr::monotonic_buffer_resource m_resource;
+};
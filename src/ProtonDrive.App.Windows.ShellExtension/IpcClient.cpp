@@ -0,0 +1,199 @@
+#include "pch.h"
+#include "IpcClient.h"
+
+using namespace std;
+using namespace ATL;
+
+IpcClient& IpcClient::GetInstance()
+{
+    static IpcClient s_instance;
+    return s_instance;
+}
+
+_Success_(return == true) bool IpcClient::TryStart(_Inout_ IpcOperation& operation)
+{
+    if (!TryOpenPipe(operation.pipeHandle, FILE_FLAG_OVERLAPPED))
+    {
+        return false;
+    }
+
+    DWORD pipeReadMode = PIPE_READMODE_MESSAGE;
+    if (!SetNamedPipeHandleState(operation.pipeHandle, &pipeReadMode, nullptr, nullptr))
+    {
+        return false;
+    }
+
+    operation.response.resize(RESPONSE_BUFFER_SIZE);
+
+    {
+        const lock_guard lock(m_mutex);
+
+        if (!m_completionPort)
+        {
+            const auto completionPort = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+            if (completionPort == nullptr)
+            {
+                return false;
+            }
+
+            m_completionPort.Attach(completionPort);
+        }
+
+        if (CreateIoCompletionPort(operation.pipeHandle, m_completionPort, 0, 0) == nullptr)
+        {
+            return false;
+        }
+
+        // Registered before starting, the completion can arrive before TransactNamedPipe returns
+        m_pendingOperations.insert(&operation);
+
+        if (!m_isIoThreadRunning)
+        {
+            m_isIoThreadRunning = true;
+
+            // The thread runs code of this module, which must stay loaded until it ends
+            _pAtlModule->Lock();
+
+            thread([this]
+            {
+                RunIoThread();
+
+                _pAtlModule->Unlock();
+            }).detach();
+        }
+    }
+
+    const auto completionPort = static_cast<HANDLE>(m_completionPort);
+
+    // The operation must not be touched once started, the awaiting coroutine might already be resumed and gone
+    if (!TransactNamedPipe(
+        operation.pipeHandle,
+        operation.request.data(),
+        static_cast<DWORD>(operation.request.size()),
+        operation.response.data(),
+        static_cast<DWORD>(operation.response.size()),
+        nullptr,
+        &operation))
+    {
+        const auto error = GetLastError();
+        if (error != ERROR_IO_PENDING && error != ERROR_MORE_DATA)
+        {
+            const lock_guard lock(m_mutex);
+            m_pendingOperations.erase(&operation);
+            return false;
+        }
+    }
+
+    // Wakes up the I/O thread so that it takes the deadline of the new operation into account
+    PostQueuedCompletionStatus(completionPort, 0, 0, nullptr);
+
+    return true;
+}
+
+void IpcClient::RunIoThread()
+{
+    while (true)
+    {
+        const auto timeout = CancelExpiredOperations();
+
+        DWORD numberOfBytesTransferred = 0;
+        ULONG_PTR completionKey;
+        LPOVERLAPPED overlapped = nullptr;
+        const auto succeeded = GetQueuedCompletionStatus(m_completionPort, &numberOfBytesTransferred, &completionKey, &overlapped, timeout);
+
+        if (overlapped != nullptr)
+        {
+            OnCompleted(*static_cast<IpcOperation*>(overlapped), numberOfBytesTransferred, succeeded ? ERROR_SUCCESS : GetLastError());
+            continue;
+        }
+
+        if (succeeded || GetLastError() != WAIT_TIMEOUT)
+        {
+            continue;
+        }
+
+        const lock_guard lock(m_mutex);
+        if (m_pendingOperations.empty())
+        {
+            m_isIoThreadRunning = false;
+            return;
+        }
+    }
+}
+
+void IpcClient::OnCompleted(_Inout_ IpcOperation& operation, _In_ const DWORD numberOfBytesTransferred, _In_ const DWORD error)
+{
+    operation.responseLength += numberOfBytesTransferred;
+
+    if (error == ERROR_SUCCESS)
+    {
+        operation.response.resize(operation.responseLength);
+        Complete(operation, operation.responseLength > 0);
+        return;
+    }
+
+    if (error != ERROR_MORE_DATA || operation.isCancelled || operation.response.size() >= MAXIMUM_RESPONSE_SIZE)
+    {
+        Complete(operation, false);
+        return;
+    }
+
+    // Large responses arrive in several reads, oversized ones are rejected before decoding
+    operation.response.resize((min)(operation.response.size() * 2, MAXIMUM_RESPONSE_SIZE));
+    static_cast<OVERLAPPED&>(operation) = {};
+
+    if (!ReadFile(
+        operation.pipeHandle,
+        operation.response.data() + operation.responseLength,
+        static_cast<DWORD>(operation.response.size() - operation.responseLength),
+        nullptr,
+        &operation))
+    {
+        const auto readError = GetLastError();
+        if (readError != ERROR_IO_PENDING && readError != ERROR_MORE_DATA)
+        {
+            Complete(operation, false);
+        }
+    }
+}
+
+void IpcClient::Complete(_Inout_ IpcOperation& operation, _In_ const bool succeeded)
+{
+    {
+        const lock_guard lock(m_mutex);
+        m_pendingOperations.erase(&operation);
+    }
+
+    operation.pipeHandle.Close();
+    operation.succeeded = succeeded;
+
+    operation.continuation.resume();
+}
+
+DWORD IpcClient::CancelExpiredOperations()
+{
+    const lock_guard lock(m_mutex);
+
+    const auto now = GetTickCount64();
+    auto timeout = static_cast<ULONGLONG>(IDLE_TIMEOUT_MILLISECONDS);
+
+    for (const auto operation : m_pendingOperations)
+    {
+        if (operation->isCancelled)
+        {
+            continue;
+        }
+
+        if (now >= operation->deadline)
+        {
+            // Completes with ERROR_OPERATION_ABORTED
+            CancelIoEx(operation->pipeHandle, operation);
+            operation->isCancelled = true;
+            continue;
+        }
+
+        timeout = (min)(timeout, operation->deadline - now);
+    }
+
+    return static_cast<DWORD>(timeout);
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "pch.h"
+#include "ipc.h"
+
+/// Coroutine that starts right away and whose result can be waited for from any thread.
+/// The coroutine frame frees itself when done, so giving up waiting does not leak it.
+template <typename T>
+class IpcTask
+{
+    struct State
+    {
+        std::mutex mutex;
+        std::condition_variable completed;
+        bool isCompleted = false;
+        std::optional<T> result;
+    };
+
+public:
+    struct promise_type
+    {
+        std::shared_ptr<State> state = std::make_shared<State>();
+
+        IpcTask get_return_object() { return IpcTask(state); }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_value(T value) { Complete(std::move(value)); }
+        void unhandled_exception() { Complete(std::nullopt); }
+
+        void Complete(std::optional<T> result)
+        {
+            const std::lock_guard lock(state->mutex);
+            state->result = std::move(result);
+            state->isCompleted = true;
+            state->completed.notify_all();
+        }
+    };
+
+    /// Returns false if the coroutine did not complete before the deadline, or ended with an exception
+    _Success_(return == true) bool TryWaitUntil(_In_ const ULONGLONG deadline, _Out_ T& result)
+    {
+        std::unique_lock lock(m_state->mutex);
+
+        while (!m_state->isCompleted)
+        {
+            const auto now = GetTickCount64();
+            if (now >= deadline)
+            {
+                return false;
+            }
+
+            m_state->completed.wait_for(lock, std::chrono::milliseconds(deadline - now));
+        }
+
+        if (!m_state->result.has_value())
+        {
+            return false;
+        }
+
+        result = std::move(*m_state->result);
+        return true;
+    }
+
+private:
+    explicit IpcTask(std::shared_ptr<State> state) : m_state(std::move(state)) {}
+
+    std::shared_ptr<State> m_state;
+};
+
+/// One request and response exchange over its own pipe instance, driven by the I/O thread of the IPC client
+struct IpcOperation : OVERLAPPED
+{
+    IpcOperation(std::string request, const ULONGLONG deadline) : OVERLAPPED{}, request(std::move(request)), deadline(deadline) {}
+
+    IpcOperation(const IpcOperation&) = delete;
+    IpcOperation& operator=(const IpcOperation&) = delete;
+
+    ATL::CHandle pipeHandle;
+    std::string request;
+    std::string response;
+    size_t responseLength = 0;
+    ULONGLONG deadline;
+    bool isCancelled = false;
+    bool succeeded = false;
+    std::coroutine_handle<> continuation;
+};
+
+/// Exchanges messages with the app without blocking the calling thread, so that several queries can be
+/// in flight at once. Completions are handled by a single I/O completion port thread shared by the process,
+/// which ends when no operation has been pending for a while. Coroutines awaiting queries resume on that thread
+/// and must not block it.
+class IpcClient
+{
+public:
+    static IpcClient& GetInstance();
+
+    template <typename TResponse>
+    class QueryAwaitable
+    {
+    public:
+        QueryAwaitable(std::string request, const ULONGLONG deadline) : m_operation(std::move(request), deadline) {}
+
+        [[nodiscard]] bool await_ready() const noexcept { return false; }
+
+        bool await_suspend(const std::coroutine_handle<> continuation)
+        {
+            m_operation.continuation = continuation;
+
+            // Resumes right away if the query could not be started
+            return GetInstance().TryStart(m_operation);
+        }
+
+        std::optional<TResponse> await_resume()
+        {
+            TResponse response;
+            if (!m_operation.succeeded || !TryDecodeIpcResponse(m_operation.response, response))
+            {
+                return std::nullopt;
+            }
+
+            return response;
+        }
+
+    private:
+        IpcOperation m_operation;
+    };
+
+    /// Completes with no response if the app does not respond before the deadline, which is in GetTickCount64 time
+    template <typename TResponse, typename TParameters>
+    [[nodiscard]] QueryAwaitable<TResponse> Query(_In_ const IpcMessage<TParameters>& message, _In_ const ULONGLONG deadline)
+    {
+        const nlohmann::json messageJsonObject = message;
+
+        return QueryAwaitable<TResponse>(messageJsonObject.dump(), deadline);
+    }
+
+private:
+    static constexpr DWORD IDLE_TIMEOUT_MILLISECONDS = 5000;
+
+    IpcClient() = default;
+
+    _Success_(return == true) bool TryStart(_Inout_ IpcOperation& operation);
+    void RunIoThread();
+    void OnCompleted(_Inout_ IpcOperation& operation, _In_ DWORD numberOfBytesTransferred, _In_ DWORD error);
+    void Complete(_Inout_ IpcOperation& operation, _In_ bool succeeded);
+    [[nodiscard]] DWORD CancelExpiredOperations();
+
+    std::mutex m_mutex;
+    ATL::CHandle m_completionPort;
+    std::unordered_set<IpcOperation*> m_pendingOperations;
+    bool m_isIoThreadRunning = false;
+};
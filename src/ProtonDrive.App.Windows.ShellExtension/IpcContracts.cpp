@@ -0,0 +1,75 @@
+#include "pch.h"
+#include "IpcContracts.h"
+
+using namespace std;
+
+struct RemoteIdsSaxDecoder : StrictSaxDecoderBase
+{
+    explicit RemoteIdsSaxDecoder(optional<RemoteIdsQueryResponse>& response) : response(response) {}
+
+    optional<RemoteIdsQueryResponse>& response;
+    wstring* currentValue = nullptr;
+    bool isInObject = false;
+    bool isComplete = false;
+
+    bool null()
+    {
+        // Either the whole response or the value of a property that is not needed
+        isComplete = !isInObject;
+        return true;
+    }
+
+    bool start_object(size_t)
+    {
+        if (isInObject || isComplete)
+        {
+            return false;
+        }
+
+        isInObject = true;
+        response.emplace();
+        return true;
+    }
+
+    bool key(string_t& name)
+    {
+        if (string_view(name) == NAMEOF(RemoteIdsQueryResponse::shareId))
+        {
+            currentValue = &response->shareId;
+        }
+        else if (string_view(name) == NAMEOF(RemoteIdsQueryResponse::linkId))
+        {
+            currentValue = &response->linkId;
+        }
+        else
+        {
+            currentValue = nullptr;
+        }
+
+        return true;
+    }
+
+    bool string(string_t& value)
+    {
+        if (!isInObject)
+        {
+            return false;
+        }
+
+        return currentValue == nullptr || TryConvertUtf8ToUtf16(value, *currentValue);
+    }
+
+    bool end_object()
+    {
+        isComplete = true;
+        return true;
+    }
+};
+
+_Success_(return == true) bool TryDecodeIpcResponse(_In_ const string_view responseString, _Out_ optional<RemoteIdsQueryResponse>& response)
+{
+    response.reset();
+
+    RemoteIdsSaxDecoder decoder(response);
+    return TryRunSaxDecoder(responseString, decoder);
+}
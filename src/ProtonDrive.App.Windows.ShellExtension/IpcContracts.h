@@ -0,0 +1,30 @@
+#pragma once
+
+#include "pch.h"
+#include "ipc.h"
+
+enum struct SyncRootType
+{
+    CloudFiles = 1,
+    HostDeviceFolder = 2,
+    ForeignDevice = 3,
+};
+
+struct SyncRootPathsQueryRequest : IpcMessage<std::vector<SyncRootType>>
+{
+    explicit SyncRootPathsQueryRequest(const std::vector<SyncRootType>& syncRootTypes) : IpcMessage(L"SyncRootPathsQuery", syncRootTypes) {}
+};
+
+struct RemoteIdsQueryRequest : IpcMessage<std::wstring>
+{
+    explicit RemoteIdsQueryRequest(const std::wstring& path) : IpcMessage(L"RemoteIdsQuery", path) {}
+};
+
+struct RemoteIdsQueryResponse
+{
+    std::wstring shareId;
+    std::wstring linkId;
+};
+
+/// Decodes either null or an object with the remote IDs, without building a DOM.
+_Success_(return == true) bool TryDecodeIpcResponse(_In_ std::string_view responseString, _Out_ std::optional<RemoteIdsQueryResponse>& response);
@@ -0,0 +1,75 @@
+#include "pch.h"
+#include "IpcResponseDecoder.h"
+
+using namespace std;
+
+/// Decodes front-coded string lists, see FrontCodedPathList
+struct StringListSaxDecoder : StrictSaxDecoderBase
+{
+    explicit StringListSaxDecoder(vector<wstring>& items) : items(items) {}
+
+    vector<wstring>& items;
+    bool isInArray = false;
+    optional<size_t> sharedPrefixLength;
+    wstring suffix;
+
+    bool start_array(const size_t numberOfElements)
+    {
+        if (isInArray || (numberOfElements != static_cast<size_t>(-1) && numberOfElements > 2 * MAXIMUM_NUMBER_OF_RESPONSE_ITEMS))
+        {
+            return false;
+        }
+
+        isInArray = true;
+        return true;
+    }
+
+    bool number_unsigned(const number_unsigned_t value)
+    {
+        if (!isInArray || sharedPrefixLength.has_value() || items.empty() || value > items.back().size())
+        {
+            return false;
+        }
+
+        sharedPrefixLength = static_cast<size_t>(value);
+        return true;
+    }
+
+    bool string(string_t& value)
+    {
+        if (!isInArray || items.size() >= MAXIMUM_NUMBER_OF_RESPONSE_ITEMS)
+        {
+            return false;
+        }
+
+        if (!sharedPrefixLength.has_value())
+        {
+            return TryConvertUtf8ToUtf16(value, items.emplace_back());
+        }
+
+        if (!TryConvertUtf8ToUtf16(value, suffix))
+        {
+            return false;
+        }
+
+        auto item = items.back().substr(0, *sharedPrefixLength);
+        item.append(suffix);
+        items.push_back(std::move(item));
+
+        sharedPrefixLength.reset();
+        return true;
+    }
+
+    bool end_array()
+    {
+        return isInArray && !sharedPrefixLength.has_value();
+    }
+};
+
+_Success_(return == true) bool TryDecodeIpcResponse(_In_ const string_view responseString, _Out_ vector<wstring>& response)
+{
+    response.clear();
+
+    StringListSaxDecoder decoder(response);
+    return TryRunSaxDecoder(responseString, decoder);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "pch.h"
+#include "unicode.h"
+
+/// Largest IPC response accepted from the app. Anything longer is rejected before being decoded.
+constexpr size_t MAXIMUM_RESPONSE_SIZE = 4 << 20;
+
+/// Largest number of items accepted in a list response.
+constexpr size_t MAXIMUM_NUMBER_OF_RESPONSE_ITEMS = 1 << 16;
+
+/// SAX event handler that rejects every event. Decoders derive from it and accept only the events
+/// expected at the current position, so that malformed input stops the parser as early as possible.
+struct StrictSaxDecoderBase
+{
+    using number_integer_t = nlohmann::json::number_integer_t;
+    using number_unsigned_t = nlohmann::json::number_unsigned_t;
+    using number_float_t = nlohmann::json::number_float_t;
+    using string_t = nlohmann::json::string_t;
+    using binary_t = nlohmann::json::binary_t;
+
+    bool null() { return false; }
+    bool boolean(bool) { return false; }
+    bool number_integer(number_integer_t) { return false; }
+    bool number_unsigned(number_unsigned_t) { return false; }
+    bool number_float(number_float_t, const string_t&) { return false; }
+    bool string(string_t&) { return false; }
+    bool binary(binary_t&) { return false; }
+    bool start_object(std::size_t) { return false; }
+    bool key(string_t&) { return false; }
+    bool end_object() { return false; }
+    bool start_array(std::size_t) { return false; }
+    bool end_array() { return false; }
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception&) { return false; }
+};
+
+template <typename TDecoder>
+_Success_(return == true) bool TryRunSaxDecoder(_In_ const std::string_view responseString, _Inout_ TDecoder& decoder)
+{
+    if (responseString.empty() || responseString.size() > MAXIMUM_RESPONSE_SIZE)
+    {
+        return false;
+    }
+
+    return nlohmann::json::sax_parse(responseString.begin(), responseString.end(), &decoder);
+}
+
+/// Decodes a front-coded JSON array of strings straight into UTF-16 strings, without building a DOM.
+_Success_(return == true) bool TryDecodeIpcResponse(_In_ std::string_view responseString, _Out_ std::vector<std::wstring>& response);
+
+/// Fallback for response types without a streaming decoder.
+template <typename TResponse>
+_Success_(return == true) bool TryDecodeIpcResponse(_In_ const std::string_view responseString, _Out_ TResponse& response)
+{
+    if (responseString.empty() || responseString.size() > MAXIMUM_RESPONSE_SIZE)
+    {
+        return false;
+    }
+
+    const auto parsedResponse = nlohmann::json::parse(responseString, nullptr, false);
+    if (parsedResponse.is_discarded())
+    {
+        return false;
+    }
+
+    // Responses of an unexpected shape or with invalid strings fail to convert
+    try
+    {
+        response = parsedResponse.get<TResponse>();
+    }
+    catch (std::exception&)
+    {
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,10 @@
+#include "pch.h"
+#include "KeepOnDeviceCommand.h"
+
+using namespace std;
+using namespace ATL;
+
+KeepOnDeviceCommand::KeepOnDeviceCommand(_In_ const CComPtr<IShellItemArray>& selectedShellItems, _In_ pmr::memory_resource* memoryResource)
+    : HydrationCommandBase(selectedShellItems, memoryResource, L"KeepOnDeviceCommand")
+{
+}
@@ -0,0 +1,8 @@
+#pragma once
+#include "HydrationCommandBase.h"
+
+class KeepOnDeviceCommand : public HydrationCommandBase
+{
+public:
+    KeepOnDeviceCommand(_In_ const ATL::CComPtr<IShellItemArray>& selectedShellItems, _In_ std::pmr::memory_resource* memoryResource);
+};
@@ -0,0 +1,270 @@
+#include "pch.h"
+#include "LatencyRecorder.h"
+
+#include "AllocationAccounting.h"
+#include "CommandRing.h"
+#include "DegradationController.h"
+#include "HostProcessPolicy.h"
+#include "ipc.h"
+
+using namespace std;
+using namespace nlohmann;
+
+struct DegradationModeChangeStatistics
+{
+    string previousMode;
+    string mode;
+    size_t numberOfSlowSamples = 0;
+};
+
+void to_json(json& j, const DegradationModeChangeStatistics& change)
+{
+    j = json{
+        {NAMEOF(change.previousMode), change.previousMode},
+        {NAMEOF(change.mode), change.mode},
+        {NAMEOF(change.numberOfSlowSamples), change.numberOfSlowSamples},
+    };
+}
+
+struct ShellExtensionStatistics
+{
+    string hostProcessPolicy;
+    uint64_t firstUseWorkingSetIncrease = 0;
+    vector<PhaseLatencyStatistics> latencies;
+    string degradationMode;
+    vector<DegradationModeChangeStatistics> degradationModeChanges;
+    vector<AllocationGauge> allocations;
+};
+
+void to_json(json& j, const ShellExtensionStatistics& statistics)
+{
+    j = json{
+        {NAMEOF(statistics.hostProcessPolicy), statistics.hostProcessPolicy},
+        {NAMEOF(statistics.firstUseWorkingSetIncrease), statistics.firstUseWorkingSetIncrease},
+        {NAMEOF(statistics.latencies), statistics.latencies},
+        {NAMEOF(statistics.degradationMode), statistics.degradationMode},
+        {NAMEOF(statistics.degradationModeChanges), statistics.degradationModeChanges},
+        {NAMEOF(statistics.allocations), statistics.allocations},
+    };
+}
+
+struct ShellExtensionStatisticsReport : IpcMessage<ShellExtensionStatistics>
+{
+    explicit ShellExtensionStatisticsReport(const ShellExtensionStatistics& statistics) : IpcMessage(L"ShellExtensionStatisticsReport", statistics) {}
+};
+
+void to_json(json& j, const PhaseLatencyStatistics& statistics)
+{
+    j = json{
+        {NAMEOF(statistics.phase), statistics.phase},
+        {NAMEOF(statistics.count), statistics.count},
+        {NAMEOF(statistics.p50), statistics.p50},
+        {NAMEOF(statistics.p95), statistics.p95},
+        {NAMEOF(statistics.p99), statistics.p99},
+        {NAMEOF(statistics.max), statistics.max},
+    };
+}
+
+LatencyRecorder& LatencyRecorder::GetInstance()
+{
+    static LatencyRecorder instance;
+    return instance;
+}
+
+LatencyRecorder::LatencyRecorder()
+    : m_nextReportTime(GetTickCount64() + REPORTING_INTERVAL_MILLISECONDS)
+{
+}
+
+void LatencyRecorder::Record(_In_ const LatencyPhase phase, _In_ const uint64_t microseconds)
+{
+    auto& histogram = m_histograms[static_cast<size_t>(phase)];
+
+    histogram.buckets[GetBucketIndex(microseconds)].fetch_add(1, memory_order_relaxed);
+
+    auto max = histogram.max.load(memory_order_relaxed);
+    while (microseconds > max && !histogram.max.compare_exchange_weak(max, microseconds, memory_order_relaxed))
+    {
+    }
+
+    // Mode changes are reported as soon as the next menu is shown
+    if (phase == LatencyPhase::QueryContextMenu && DegradationController::GetInstance().Record(microseconds, GetTickCount64()))
+    {
+        m_nextReportTime.store(0, memory_order_relaxed);
+    }
+}
+
+void LatencyRecorder::TakeStatistics(_Out_ vector<PhaseLatencyStatistics>& statistics)
+{
+    statistics.clear();
+
+    for (size_t phaseIndex = 0; phaseIndex < m_histograms.size(); ++phaseIndex)
+    {
+        auto& histogram = m_histograms[phaseIndex];
+
+        array<uint64_t, NUMBER_OF_BUCKETS> counts;
+        uint64_t totalCount = 0;
+        for (size_t i = 0; i < NUMBER_OF_BUCKETS; ++i)
+        {
+            counts[i] = histogram.buckets[i].exchange(0, memory_order_relaxed);
+            totalCount += counts[i];
+        }
+
+        const auto max = histogram.max.exchange(0, memory_order_relaxed);
+
+        if (totalCount == 0)
+        {
+            continue;
+        }
+
+        auto& phaseStatistics = statistics.emplace_back();
+        phaseStatistics.phase = NAMEOF_ENUM(static_cast<LatencyPhase>(phaseIndex));
+        phaseStatistics.count = totalCount;
+        phaseStatistics.max = max;
+
+        const auto getPercentile = [&counts, totalCount, max](const uint64_t percent)
+        {
+            const auto rank = (totalCount * percent + 99) / 100;
+            uint64_t cumulativeCount = 0;
+            for (size_t i = 0; i < NUMBER_OF_BUCKETS; ++i)
+            {
+                cumulativeCount += counts[i];
+                if (cumulativeCount >= rank)
+                {
+                    return (std::min)(GetBucketUpperBound(i), max);
+                }
+            }
+
+            return max;
+        };
+
+        phaseStatistics.p50 = getPercentile(50);
+        phaseStatistics.p95 = getPercentile(95);
+        phaseStatistics.p99 = getPercentile(99);
+    }
+}
+
+void LatencyRecorder::ReportIfDue()
+{
+    const auto now = GetTickCount64();
+
+    auto nextReportTime = m_nextReportTime.load(memory_order_relaxed);
+    if (now < nextReportTime
+        || !m_nextReportTime.compare_exchange_strong(nextReportTime, now + REPORTING_INTERVAL_MILLISECONDS, memory_order_relaxed))
+    {
+        return;
+    }
+
+    ShellExtensionStatistics statistics;
+    TakeStatistics(statistics.latencies);
+
+    if (statistics.latencies.empty())
+    {
+        return;
+    }
+
+    statistics.hostProcessPolicy = NAMEOF_ENUM(GetHostProcessPolicy());
+    statistics.firstUseWorkingSetIncrease = m_firstUseWorkingSetIncrease;
+
+    auto& degradationController = DegradationController::GetInstance();
+    statistics.degradationMode = NAMEOF_ENUM(degradationController.GetMode());
+
+    vector<DegradationModeChange> modeChanges;
+    degradationController.TakeModeChanges(modeChanges);
+    for (const auto& modeChange : modeChanges)
+    {
+        statistics.degradationModeChanges.push_back({ string(NAMEOF_ENUM(modeChange.previousMode)), string(NAMEOF_ENUM(modeChange.mode)), modeChange.numberOfSlowSamples });
+    }
+
+    AllocationAccounting::GetInstance().GetGauges(statistics.allocations);
+
+    // Called while the menu is being built, so the report is dropped rather than falling back to the pipe
+    const json reportJsonObject = ShellExtensionStatisticsReport(statistics);
+    TryPostCommand(reportJsonObject.dump());
+}
+
+size_t LatencyRecorder::GetBucketIndex(_In_ const uint64_t microseconds)
+{
+    // Four linear sub-buckets per power of two
+    if (microseconds < 4)
+    {
+        return static_cast<size_t>(microseconds);
+    }
+
+    const auto exponent = static_cast<size_t>(bit_width(microseconds)) - 1;
+    const auto subBucket = static_cast<size_t>(microseconds >> (exponent - 2)) & 3;
+
+    return (std::min)(4 * (exponent - 1) + subBucket, NUMBER_OF_BUCKETS - 1);
+}
+
+uint64_t LatencyRecorder::GetBucketUpperBound(_In_ const size_t index)
+{
+    if (index < 4)
+    {
+        return index;
+    }
+
+    const auto exponent = index / 4 + 1;
+    const auto subBucket = index % 4;
+
+    return ((5 + subBucket) << (exponent - 2)) - 1;
+}
+
+LatencyScope::LatencyScope(_In_ const LatencyPhase phase)
+    : m_phase(phase)
+{
+    QueryPerformanceCounter(&m_startTime);
+}
+
+LatencyScope::~LatencyScope()
+{
+    LARGE_INTEGER endTime;
+    QueryPerformanceCounter(&endTime);
+
+    static const auto frequency = []
+    {
+        LARGE_INTEGER value;
+        QueryPerformanceFrequency(&value);
+        return value.QuadPart;
+    }();
+
+    const auto elapsedTicks = static_cast<uint64_t>(endTime.QuadPart - m_startTime.QuadPart);
+
+    LatencyRecorder::GetInstance().Record(m_phase, elapsedTicks * 1'000'000 / static_cast<uint64_t>(frequency));
+}
+
+atomic<bool> FirstUseScope::s_isUsed = false;
+
+FirstUseScope::FirstUseScope()
+    : m_isFirstUse(!s_isUsed.exchange(true))
+{
+    if (m_isFirstUse)
+    {
+        m_initialWorkingSetSize = GetWorkingSetSize();
+    }
+}
+
+FirstUseScope::~FirstUseScope()
+{
+    if (!m_isFirstUse)
+    {
+        return;
+    }
+
+    const auto workingSetSize = GetWorkingSetSize();
+    if (workingSetSize > m_initialWorkingSetSize)
+    {
+        LatencyRecorder::GetInstance().RecordFirstUseWorkingSetIncrease(workingSetSize - m_initialWorkingSetSize);
+    }
+}
+
+SIZE_T FirstUseScope::GetWorkingSetSize()
+{
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return 0;
+    }
+
+    return counters.WorkingSetSize;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "pch.h"
+
+enum struct LatencyPhase
+{
+    Initialize,
+    QueryContextMenu,
+    InvokeCommand,
+    SyncRootPathsQuery,
+    RemoteIdsQuery,
+    Count,
+};
+
+struct PhaseLatencyStatistics
+{
+    std::string phase;
+    uint64_t count = 0;
+    uint64_t p50 = 0;
+    uint64_t p95 = 0;
+    uint64_t p99 = 0;
+    uint64_t max = 0;
+};
+
+void to_json(nlohmann::json& j, const PhaseLatencyStatistics& statistics);
+
+/// Collects latency histograms of the context menu phases in this process and periodically reports
+/// their percentiles to the app, so that slow menus reported by users can be matched with field data.
+/// Values are in microseconds, percentiles are accurate to a quarter of a power of two.
+class LatencyRecorder
+{
+public:
+    static LatencyRecorder& GetInstance();
+
+    void Record(_In_ LatencyPhase phase, _In_ uint64_t microseconds);
+
+    /// Takes the statistics collected since the previous call and resets the histograms
+    void TakeStatistics(_Out_ std::vector<PhaseLatencyStatistics>& statistics);
+
+    /// Posts the statistics to the app if the reporting interval has elapsed; cheap otherwise. Never waits for the app.
+    void ReportIfDue();
+
+    void RecordFirstUseWorkingSetIncrease(_In_ uint64_t bytes) { m_firstUseWorkingSetIncrease = bytes; }
+
+private:
+    static constexpr size_t NUMBER_OF_BUCKETS = 128;
+    static constexpr uint64_t REPORTING_INTERVAL_MILLISECONDS = 15 * 60 * 1000;
+
+    struct Histogram
+    {
+        std::array<std::atomic<uint64_t>, NUMBER_OF_BUCKETS> buckets {};
+        std::atomic<uint64_t> max = 0;
+    };
+
+    LatencyRecorder();
+
+    [[nodiscard]] static size_t GetBucketIndex(_In_ uint64_t microseconds);
+    [[nodiscard]] static uint64_t GetBucketUpperBound(_In_ size_t index);
+
+    std::array<Histogram, static_cast<size_t>(LatencyPhase::Count)> m_histograms;
+    std::atomic<uint64_t> m_nextReportTime;
+    std::atomic<uint64_t> m_firstUseWorkingSetIncrease = 0;
+};
+
+/// Records the time elapsed between its construction and destruction
+class LatencyScope
+{
+public:
+    explicit LatencyScope(_In_ LatencyPhase phase);
+    ~LatencyScope();
+
+    LatencyScope(const LatencyScope&) = delete;
+    LatencyScope& operator=(const LatencyScope&) = delete;
+
+private:
+    LatencyPhase m_phase;
+    LARGE_INTEGER m_startTime;
+};
+
+/// Measures how much the working set of the host process grows during the first context menu shown in it,
+/// which is when the extension initializes its static state and pages in most of its code
+class FirstUseScope
+{
+public:
+    FirstUseScope();
+    ~FirstUseScope();
+
+    FirstUseScope(const FirstUseScope&) = delete;
+    FirstUseScope& operator=(const FirstUseScope&) = delete;
+
+private:
+    static std::atomic<bool> s_isUsed;
+
+    bool m_isFirstUse;
+    SIZE_T m_initialWorkingSetSize = 0;
+
+    [[nodiscard]] static SIZE_T GetWorkingSetSize();
+};
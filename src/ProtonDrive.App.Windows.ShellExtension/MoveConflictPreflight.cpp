@@ -0,0 +1,220 @@
+#include "pch.h"
+#include "MoveConflictPreflight.h"
+
+#include "PathCanonicalization.h"
+#include "TaskDialog.h"
+#include "resource.h"
+
+using namespace std;
+using namespace ATL;
+
+constexpr int REPLACE_BUTTON_ID = 100;
+constexpr int KEEP_BOTH_BUTTON_ID = 101;
+constexpr int SKIP_BUTTON_ID = 102;
+
+constexpr int MAXIMUM_NUMBER_OF_NAME_ATTEMPTS = 1000;
+
+wstring_view GetItemName(_In_ const wstring_view path)
+{
+    return path.substr(path.find_last_of(L'\\') + 1);
+}
+
+MoveConflictPreflight::MoveConflictPreflight(_In_ const wstring_view destinationFolderPath, _In_ pmr::memory_resource* memoryResource)
+    : m_memoryResource(memoryResource),
+    m_takenNames(memoryResource),
+    m_nameKey(memoryResource)
+{
+    SnapshotDestinationNames(destinationFolderPath);
+}
+
+size_t MoveConflictPreflight::FindConflicts(_Inout_ pmr::vector<PlannedMove>& plan)
+{
+    // Without a complete snapshot the conflicts are left to the copy engine
+    if (!m_isSnapshotComplete)
+    {
+        return 0;
+    }
+
+    size_t numberOfConflicts = 0;
+
+    for (auto& move : plan)
+    {
+        if (move.sourcePath.empty())
+        {
+            continue;
+        }
+
+        move.hasConflict = !TryTakeName(GetItemName(move.sourcePath));
+        move.isDestinationVacant = !move.hasConflict;
+        if (move.hasConflict)
+        {
+            ++numberOfConflicts;
+        }
+    }
+
+    return numberOfConflicts;
+}
+
+void MoveConflictPreflight::Resolve(_In_ const ConflictResolution resolution, _Inout_ pmr::vector<PlannedMove>& plan)
+{
+    switch (resolution)
+    {
+    case ConflictResolution::Skip:
+        erase_if(plan, [](const PlannedMove& move) { return move.hasConflict; });
+        break;
+
+    case ConflictResolution::KeepBoth:
+        for (auto& move : plan)
+        {
+            if (move.hasConflict)
+            {
+                AssignUniqueName(move);
+            }
+        }
+        break;
+
+    case ConflictResolution::Replace:
+        for (auto& move : plan)
+        {
+            move.replaceExisting = move.hasConflict;
+        }
+        break;
+
+    case ConflictResolution::Cancel:
+        plan.clear();
+        break;
+
+    default:
+        break;
+    }
+}
+
+ConflictResolution MoveConflictPreflight::AskForResolution(_In_opt_ const HWND ownerWindow, _In_ const size_t numberOfConflicts)
+{
+    wchar_t contentFormat[128] = { 0 };
+    LoadString(_AtlBaseModule.GetModuleInstance(), IDS_MOVE_CONFLICT_CONTENT, contentFormat, ARRAYSIZE(contentFormat));
+
+    wchar_t content[160] = { 0 };
+    if (FAILED(StringCchPrintf(content, ARRAYSIZE(content), contentFormat, static_cast<unsigned int>(numberOfConflicts))))
+    {
+        return ConflictResolution::AskForEachItem;
+    }
+
+    const TASKDIALOG_BUTTON buttons[] =
+    {
+        { REPLACE_BUTTON_ID, MAKEINTRESOURCE(IDS_MOVE_CONFLICT_REPLACE) },
+        { KEEP_BOTH_BUTTON_ID, MAKEINTRESOURCE(IDS_MOVE_CONFLICT_KEEP_BOTH) },
+        { SKIP_BUTTON_ID, MAKEINTRESOURCE(IDS_MOVE_CONFLICT_SKIP) },
+    };
+
+    TASKDIALOGCONFIG config = { sizeof(config) };
+    config.hwndParent = ownerWindow;
+    config.hInstance = _AtlBaseModule.GetModuleInstance();
+    config.dwFlags = TDF_USE_COMMAND_LINKS | TDF_ALLOW_DIALOG_CANCELLATION | TDF_POSITION_RELATIVE_TO_WINDOW;
+    config.dwCommonButtons = TDCBF_CANCEL_BUTTON;
+    config.pszWindowTitle = MAKEINTRESOURCE(IDS_MOVE_CONFLICT_TITLE);
+    config.pszMainInstruction = MAKEINTRESOURCE(IDS_MOVE_CONFLICT_INSTRUCTION);
+    config.pszContent = content;
+    config.cButtons = ARRAYSIZE(buttons);
+    config.pButtons = buttons;
+    config.nDefaultButton = KEEP_BOTH_BUTTON_ID;
+
+    int buttonId;
+    if (!TryShowTaskDialog(config, buttonId))
+    {
+        return ConflictResolution::AskForEachItem;
+    }
+
+    switch (buttonId)
+    {
+    case REPLACE_BUTTON_ID:
+        return ConflictResolution::Replace;
+    case KEEP_BOTH_BUTTON_ID:
+        return ConflictResolution::KeepBoth;
+    case SKIP_BUTTON_ID:
+        return ConflictResolution::Skip;
+    default:
+        return ConflictResolution::Cancel;
+    }
+}
+
+void MoveConflictPreflight::SnapshotDestinationNames(_In_ const wstring_view destinationFolderPath)
+{
+    wstring searchPattern(destinationFolderPath);
+    if (!searchPattern.empty() && searchPattern.back() != L'\\')
+    {
+        searchPattern += L'\\';
+    }
+
+    searchPattern += L'*';
+
+    WIN32_FIND_DATA findData;
+    const auto findHandle = FindFirstFileEx(
+        searchPattern.c_str(),
+        FindExInfoBasic,
+        &findData,
+        FindExSearchNameMatch,
+        nullptr,
+        FIND_FIRST_EX_LARGE_FETCH);
+
+    if (findHandle == INVALID_HANDLE_VALUE)
+    {
+        m_isSnapshotComplete = GetLastError() == ERROR_FILE_NOT_FOUND;
+        return;
+    }
+
+    do
+    {
+        const auto name = wstring_view(findData.cFileName);
+        if (name == L"." || name == L"..")
+        {
+            continue;
+        }
+
+        CanonicalizeName(name, m_nameKey);
+        m_takenNames.insert(m_nameKey);
+    }
+    while (FindNextFile(findHandle, &findData));
+
+    m_isSnapshotComplete = GetLastError() == ERROR_NO_MORE_FILES;
+
+    FindClose(findHandle);
+}
+
+bool MoveConflictPreflight::TryTakeName(_In_ const wstring_view name)
+{
+    CanonicalizeName(name, m_nameKey);
+    return m_takenNames.insert(m_nameKey).second;
+}
+
+void MoveConflictPreflight::AssignUniqueName(_Inout_ PlannedMove& move)
+{
+    const auto name = GetItemName(move.sourcePath);
+
+    // Folders have no extension, and neither have files whose only dot is the leading one
+    const auto extensionPosition = move.isDirectory ? wstring_view::npos : name.find_last_of(L'.');
+    const auto hasExtension = extensionPosition != wstring_view::npos && extensionPosition > 0;
+    const auto stem = hasExtension ? name.substr(0, extensionPosition) : name;
+    const auto extension = hasExtension ? name.substr(extensionPosition) : wstring_view();
+
+    pmr::wstring candidateName(m_memoryResource);
+
+    for (auto number = 2; number < MAXIMUM_NUMBER_OF_NAME_ATTEMPTS; ++number)
+    {
+        candidateName.assign(stem);
+        candidateName.append(L" (");
+        candidateName.append(to_wstring(number));
+        candidateName.append(L")");
+        candidateName.append(extension);
+
+        if (TryTakeName(candidateName))
+        {
+            move.destinationName = candidateName;
+            move.hasConflict = false;
+            move.isDestinationVacant = true;
+            return;
+        }
+    }
+
+    // Left to the copy engine to ask about
+}
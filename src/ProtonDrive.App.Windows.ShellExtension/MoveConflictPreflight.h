@@ -0,0 +1,39 @@
+#pragma once
+
+#include "pch.h"
+#include "MovePlanner.h"
+
+enum struct ConflictResolution
+{
+    /// The copy engine asks about every conflicting item during the move
+    AskForEachItem,
+    Skip,
+    KeepBoth,
+    Replace,
+    Cancel,
+};
+
+/// Finds all name conflicts of a move before anything is moved, so that the user resolves them once for the whole selection.
+/// The destination folder is enumerated once into a case-insensitive set instead of checking the existence of every item.
+class MoveConflictPreflight
+{
+public:
+    MoveConflictPreflight(_In_ std::wstring_view destinationFolderPath, _In_ std::pmr::memory_resource* memoryResource);
+
+    /// Marks the planned moves whose name is already taken in the destination folder or by an earlier item of the selection
+    [[nodiscard]] size_t FindConflicts(_Inout_ std::pmr::vector<PlannedMove>& plan);
+
+    void Resolve(_In_ ConflictResolution resolution, _Inout_ std::pmr::vector<PlannedMove>& plan);
+
+    [[nodiscard]] static ConflictResolution AskForResolution(_In_opt_ HWND ownerWindow, _In_ size_t numberOfConflicts);
+
+private:
+    std::pmr::memory_resource* m_memoryResource;
+    std::pmr::unordered_set<std::pmr::wstring> m_takenNames;
+    std::pmr::wstring m_nameKey;
+    bool m_isSnapshotComplete = false;
+
+    void SnapshotDestinationNames(_In_ std::wstring_view destinationFolderPath);
+    [[nodiscard]] bool TryTakeName(_In_ std::wstring_view name);
+    void AssignUniqueName(_Inout_ PlannedMove& move);
+};
@@ -0,0 +1,222 @@
+#include "pch.h"
+#include "MoveDuplicatePreflight.h"
+
+#include "ContentHasher.h"
+#include "IpcClient.h"
+#include "SelectionWalker.h"
+#include "TaskDialog.h"
+#include "checksum.h"
+#include "resource.h"
+
+using namespace std;
+using namespace ATL;
+using namespace nlohmann;
+
+constexpr int MOVE_BUTTON_ID = 100;
+constexpr int SKIP_BUTTON_ID = 101;
+
+struct ContentDuplicatesQueryItem
+{
+    uint64_t size;
+    string sha256;
+};
+
+void to_json(json& j, const ContentDuplicatesQueryItem& item)
+{
+    j = json{
+        {NAMEOF(item.size), item.size},
+        {NAMEOF(item.sha256), item.sha256},
+    };
+}
+
+/// The response has the path of an existing file with the same content for every item, or an empty string
+struct ContentDuplicatesQuery : IpcMessage<vector<ContentDuplicatesQueryItem>>
+{
+    explicit ContentDuplicatesQuery(vector<ContentDuplicatesQueryItem> items) : IpcMessage(L"ContentDuplicatesQuery", std::move(items)) {}
+};
+
+IpcTask<vector<wstring>> QueryContentDuplicates(vector<ContentDuplicatesQueryItem> items, const ULONGLONG deadline)
+{
+    auto existingPaths = co_await IpcClient::GetInstance().Query<vector<wstring>>(ContentDuplicatesQuery(std::move(items)), deadline);
+
+    co_return existingPaths.value_or(vector<wstring>());
+}
+
+size_t MoveDuplicatePreflight::FindDuplicates(_Inout_ pmr::vector<PlannedMove>& plan)
+{
+    vector<wstring> selectedPaths;
+    unordered_map<wstring_view, size_t> planIndexes;
+
+    for (size_t i = 0; i < plan.size(); ++i)
+    {
+        selectedPaths.emplace_back(plan[i].sourcePath);
+        planIndexes.emplace(plan[i].sourcePath, i);
+    }
+
+    // Runs on the thread of a large move, which can afford a longer walk than the one deciding whether the move is large
+    SelectionWalker walker(WALK_TIME_BUDGET_MILLISECONDS);
+    vector<WalkedFile> files;
+    (void)walker.Walk(selectedPaths, MINIMUM_SIZE, files);
+
+    if (files.empty())
+    {
+        return 0;
+    }
+
+    vector<wstring> paths;
+    paths.reserve(files.size());
+    uint64_t totalSize = 0;
+
+    for (auto& file : files)
+    {
+        paths.push_back(std::move(file.path));
+        totalSize += file.size;
+    }
+
+    const auto hashingTimeBudget = static_cast<DWORD>((std::min)(
+        MINIMUM_HASHING_TIME_BUDGET_MILLISECONDS + totalSize / MINIMUM_HASHING_BYTES_PER_MILLISECOND,
+        static_cast<uint64_t>(MAXIMUM_HASHING_TIME_BUDGET_MILLISECONDS)));
+
+    ContentHasher hasher(MINIMUM_SIZE, hashingTimeBudget);
+    const auto hashes = hasher.Hash(paths);
+
+    vector<ContentDuplicatesQueryItem> items;
+    vector<size_t> itemPathIndexes;
+
+    for (size_t i = 0; i < hashes.size(); ++i)
+    {
+        if (!hashes[i].has_value())
+        {
+            continue;
+        }
+
+        items.push_back({ hashes[i]->size, ConvertToHexadecimal(hashes[i]->sha256) });
+        itemPathIndexes.push_back(i);
+
+        if (const auto planIndex = planIndexes.find(paths[i]); planIndex != planIndexes.end())
+        {
+            plan[planIndex->second].contentHash = hashes[i];
+        }
+    }
+
+    if (items.empty())
+    {
+        return 0;
+    }
+
+    // The app looks for the content among the files in the sync root, which takes a while for large folders
+    const auto deadline = GetTickCount64() + QUERY_TIMEOUT_MILLISECONDS;
+
+    vector<wstring> existingPaths;
+    auto task = QueryContentDuplicates(std::move(items), deadline);
+    if (!task.TryWaitUntil(deadline, existingPaths) || existingPaths.size() != itemPathIndexes.size())
+    {
+        return 0;
+    }
+
+    size_t numberOfDuplicates = 0;
+
+    for (size_t i = 0; i < existingPaths.size(); ++i)
+    {
+        if (existingPaths[i].empty())
+        {
+            continue;
+        }
+
+        const auto& path = paths[itemPathIndexes[i]];
+
+        // Selected files are planned themselves, other files are inside a selected folder
+        for (auto length = path.size(); length != wstring::npos && length > 0; length = path.find_last_of(L'\\', length - 1))
+        {
+            const auto planIndex = planIndexes.find(wstring_view(path).substr(0, length));
+            if (planIndex == planIndexes.end())
+            {
+                continue;
+            }
+
+            auto& move = plan[planIndex->second];
+            if (length == path.size())
+            {
+                move.hasDuplicate = true;
+            }
+            else
+            {
+                move.duplicateDescendantPaths.push_back(path);
+            }
+
+            ++numberOfDuplicates;
+            break;
+        }
+    }
+
+    return numberOfDuplicates;
+}
+
+void MoveDuplicatePreflight::Resolve(_In_ const DuplicateResolution resolution, _Inout_ pmr::vector<PlannedMove>& plan)
+{
+    switch (resolution)
+    {
+    case DuplicateResolution::Skip:
+        // The folders containing duplicates are moved without them
+        erase_if(plan, [](const PlannedMove& move) { return move.hasDuplicate; });
+        break;
+
+    case DuplicateResolution::Cancel:
+        plan.clear();
+        break;
+
+    default:
+        for (auto& move : plan)
+        {
+            move.duplicateDescendantPaths.clear();
+        }
+
+        break;
+    }
+}
+
+DuplicateResolution MoveDuplicatePreflight::AskForResolution(_In_opt_ const HWND ownerWindow, _In_ const size_t numberOfDuplicates)
+{
+    wchar_t contentFormat[256] = { 0 };
+    LoadString(_AtlBaseModule.GetModuleInstance(), IDS_MOVE_DUPLICATE_CONTENT, contentFormat, ARRAYSIZE(contentFormat));
+
+    wchar_t content[288] = { 0 };
+    if (FAILED(StringCchPrintf(content, ARRAYSIZE(content), contentFormat, static_cast<unsigned int>(numberOfDuplicates))))
+    {
+        return DuplicateResolution::Move;
+    }
+
+    const TASKDIALOG_BUTTON buttons[] =
+    {
+        { SKIP_BUTTON_ID, MAKEINTRESOURCE(IDS_MOVE_DUPLICATE_SKIP) },
+        { MOVE_BUTTON_ID, MAKEINTRESOURCE(IDS_MOVE_DUPLICATE_MOVE) },
+    };
+
+    TASKDIALOGCONFIG config = { sizeof(config) };
+    config.hwndParent = ownerWindow;
+    config.hInstance = _AtlBaseModule.GetModuleInstance();
+    config.dwFlags = TDF_USE_COMMAND_LINKS | TDF_ALLOW_DIALOG_CANCELLATION | TDF_POSITION_RELATIVE_TO_WINDOW;
+    config.dwCommonButtons = TDCBF_CANCEL_BUTTON;
+    config.pszWindowTitle = MAKEINTRESOURCE(IDS_MOVE_CONFLICT_TITLE);
+    config.pszMainInstruction = MAKEINTRESOURCE(IDS_MOVE_DUPLICATE_INSTRUCTION);
+    config.pszContent = content;
+    config.cButtons = ARRAYSIZE(buttons);
+    config.pButtons = buttons;
+    config.nDefaultButton = SKIP_BUTTON_ID;
+
+    int buttonId;
+    if (!TryShowTaskDialog(config, buttonId))
+    {
+        return DuplicateResolution::Move;
+    }
+
+    switch (buttonId)
+    {
+    case SKIP_BUTTON_ID:
+        return DuplicateResolution::Skip;
+    case MOVE_BUTTON_ID:
+        return DuplicateResolution::Move;
+    default:
+        return DuplicateResolution::Cancel;
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "pch.h"
+#include "MovePlanner.h"
+
+enum struct DuplicateResolution
+{
+    Move,
+    Skip,
+    Cancel,
+};
+
+/// Finds the files of a move whose content already exists in Proton Drive, so that the user can leave them
+/// where they are instead of uploading the same content again. The selected files and the files inside the selected
+/// folders are hashed in parallel and the app is asked about all of them in one query. The app only compares them
+/// with the files stored on this computer in the Proton Drive folder, online-only files would have to be downloaded.
+class MoveDuplicatePreflight
+{
+public:
+    /// Marks the planned moves of files whose content already exists in Proton Drive, and lists such files inside
+    /// the planned folders. Returns the number of both.
+    [[nodiscard]] static size_t FindDuplicates(_Inout_ std::pmr::vector<PlannedMove>& plan);
+
+    static void Resolve(_In_ DuplicateResolution resolution, _Inout_ std::pmr::vector<PlannedMove>& plan);
+
+    [[nodiscard]] static DuplicateResolution AskForResolution(_In_opt_ HWND ownerWindow, _In_ size_t numberOfDuplicates);
+
+private:
+    /// Small files are cheap to upload again
+    static constexpr uint64_t MINIMUM_SIZE = 64 << 10;
+    static constexpr DWORD WALK_TIME_BUDGET_MILLISECONDS = 10000;
+
+    /// The budget grows with the bytes to hash, so that large files are hashed even by slow disks
+    static constexpr DWORD MINIMUM_HASHING_TIME_BUDGET_MILLISECONDS = 2000;
+    static constexpr DWORD MAXIMUM_HASHING_TIME_BUDGET_MILLISECONDS = 120000;
+    static constexpr uint64_t MINIMUM_HASHING_BYTES_PER_MILLISECOND = 50'000;
+
+    static constexpr DWORD QUERY_TIMEOUT_MILLISECONDS = 5000;
+};
@@ -0,0 +1,172 @@
+#include "pch.h"
+#include "MoveJournal.h"
+
+#include "FileIdentity.h"
+#include "MovePlanner.h"
+#include "checksum.h"
+#include "unicode.h"
+
+using namespace std;
+using namespace ATL;
+using namespace nlohmann;
+
+/// Adds the volume serial number and file index of the item to the record, the same identity the app reads.
+/// The app opens items following reparse points, so does this.
+void AppendFileIdentity(_In_ const wstring& path, _In_ const char* volumeKey, _In_ const char* fileIdKey, _Inout_ json& record)
+{
+    CHandle handle;
+    BY_HANDLE_FILE_INFORMATION information;
+    if (!TryOpenForIdentity(path.c_str(), true, handle) || !GetFileInformationByHandle(handle, &information))
+    {
+        return;
+    }
+
+    record[volumeKey] = information.dwVolumeSerialNumber;
+    record[fileIdKey] = static_cast<int64_t>((static_cast<uint64_t>(information.nFileIndexHigh) << 32) | information.nFileIndexLow);
+}
+
+MoveJournal::MoveJournal(_In_ const HANDLE file, _In_ wstring path, _In_ wstring destinationFolderPath)
+    : m_file(file),
+    m_path(std::move(path)),
+    m_destinationFolderPath(std::move(destinationFolderPath)),
+    m_lastWriteTime(GetTickCount64())
+{
+    m_buffer.reserve(MOVE_JOURNAL_GROUP_COMMIT_SIZE);
+}
+
+MoveJournal::~MoveJournal()
+{
+    m_file.Close();
+
+    (void)DeleteFile(m_path.c_str());
+}
+
+_Success_(return == true) bool MoveJournal::TryCreate(_In_ const wstring_view destinationFolderPath, _Out_ unique_ptr<MoveJournal>& journal)
+{
+    CComHeapPtr<WCHAR> localAppDataPath;
+    if (FAILED(SHGetKnownFolderPath(FOLDERID_LocalAppData, KF_FLAG_DEFAULT, nullptr, &localAppDataPath)))
+    {
+        return false;
+    }
+
+    wstring folderPath(localAppDataPath);
+    folderPath.append(L"\\").append(MOVE_JOURNAL_FOLDER_RELATIVE_PATH);
+
+    const auto result = SHCreateDirectoryEx(nullptr, folderPath.c_str(), nullptr);
+    if (result != ERROR_SUCCESS && result != ERROR_ALREADY_EXISTS)
+    {
+        return false;
+    }
+
+    GUID id;
+    wchar_t idString[40];
+    if (FAILED(CoCreateGuid(&id)) || StringFromGUID2(id, idString, ARRAYSIZE(idString)) == 0)
+    {
+        return false;
+    }
+
+    auto path = folderPath.append(L"\\").append(idString).append(MOVE_JOURNAL_FILE_EXTENSION);
+
+    // Not shared for writing, so that the app does not resume a move that is still running
+    const auto file = CreateFile(path.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ, nullptr, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    journal.reset(new MoveJournal(file, std::move(path), wstring(destinationFolderPath)));
+    journal->Append(json{ {"type", "move"}, {"destination", ConvertUtf16ToUtf8(wstring(destinationFolderPath).c_str())} });
+
+    return true;
+}
+
+void MoveJournal::AppendPlannedItem(_In_ const size_t index, _In_ const PlannedMove& move)
+{
+    // The final name, so that the app does not need to know how name conflicts were resolved
+    auto name = move.destinationName.empty()
+        ? wstring_view(move.sourcePath).substr(move.sourcePath.find_last_of(L'\\') + 1)
+        : wstring_view(move.destinationName);
+
+    json record {
+        {"type", "planned"},
+        {"index", index},
+        {"source", ConvertUtf16ToUtf8(move.sourcePath.c_str())},
+        {"name", ConvertUtf16ToUtf8(wstring(name).c_str())},
+        {"vacant", move.isDestinationVacant},
+        {"replace", move.replaceExisting},
+    };
+
+    AppendFileIdentity(wstring(move.sourcePath), "volume", "fileId", record);
+
+    // Only the very file the user agreed to replace may be overwritten
+    if (move.replaceExisting)
+    {
+        AppendFileIdentity(m_destinationFolderPath + L'\\' + wstring(name), "destinationVolume", "destinationFileId", record);
+    }
+
+    if (move.contentHash.has_value())
+    {
+        record["size"] = move.contentHash->size;
+        record["sha256"] = ConvertToHexadecimal(move.contentHash->sha256);
+    }
+
+    // Resuming moves the rest of the folder, but not the files the user chose to leave where they are
+    if (!move.duplicateDescendantPaths.empty())
+    {
+        auto& skippedPaths = record["skipped"] = json::array();
+        for (const auto& path : move.duplicateDescendantPaths)
+        {
+            skippedPaths.push_back(ConvertUtf16ToUtf8(path.c_str()));
+        }
+    }
+
+    Append(record);
+}
+
+void MoveJournal::CommitPlan()
+{
+    Write();
+
+    if (!FlushFileBuffers(m_file))
+    {
+        AtlThrowLastWin32();
+    }
+}
+
+void MoveJournal::AppendCompletedItem(_In_ const size_t index)
+{
+    Append(json{ {"type", "completed"}, {"index", index} });
+
+    if (m_buffer.size() >= MOVE_JOURNAL_GROUP_COMMIT_SIZE || GetTickCount64() - m_lastWriteTime >= MOVE_JOURNAL_GROUP_COMMIT_MILLISECONDS)
+    {
+        Write();
+    }
+}
+
+void MoveJournal::Append(_In_ const json& record)
+{
+    const auto recordString = record.dump();
+
+    char checksumString[16];
+    const auto checksumLength = sprintf_s(checksumString, "\t%08x\n", GetFnv1aHash(recordString));
+
+    m_buffer.append(recordString).append(checksumString, checksumLength);
+}
+
+void MoveJournal::Write()
+{
+    m_lastWriteTime = GetTickCount64();
+
+    if (m_buffer.empty())
+    {
+        return;
+    }
+
+    DWORD numberOfBytesWritten;
+    if (!WriteFile(m_file, m_buffer.data(), static_cast<DWORD>(m_buffer.size()), &numberOfBytesWritten, nullptr))
+    {
+        AtlThrowLastWin32();
+    }
+
+    m_buffer.clear();
+}
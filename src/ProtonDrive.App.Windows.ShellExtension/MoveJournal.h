@@ -0,0 +1,49 @@
+#pragma once
+
+#include "pch.h"
+
+constexpr auto MOVE_JOURNAL_FOLDER_RELATIVE_PATH = L"Proton\\Proton Drive\\MoveJournals";
+constexpr auto MOVE_JOURNAL_FILE_EXTENSION = L".journal";
+
+/// Group-committed completion records are written at most this much apart, or when the buffer fills up
+constexpr ULONGLONG MOVE_JOURNAL_GROUP_COMMIT_MILLISECONDS = 250;
+constexpr size_t MOVE_JOURNAL_GROUP_COMMIT_SIZE = 64 * 1024;
+
+struct PlannedMove;
+
+/// Append-only record of a move in progress, read by the app to resume the move after Explorer crashed or the machine restarted.
+/// Each line is a JSON record followed by a tab and the hexadecimal FNV-1a checksum of the record, torn lines are ignored when read.
+/// The planned items are made durable before the first item moves. Completion records are only an optimization,
+/// the app checks whether the source of every item still exists, so they are group-committed and never flushed to disk.
+/// The journal is deleted when the object is destroyed; it survives only if the process dies while moving.
+/// Planned items record the identity of the source and of the destination the user chose to replace, and the content hash
+/// when known, so that the app moves, overwrites or deletes nothing but the items of this move.
+class MoveJournal
+{
+public:
+    ~MoveJournal();
+
+    MoveJournal(const MoveJournal&) = delete;
+    MoveJournal& operator=(const MoveJournal&) = delete;
+
+    static _Success_(return == true) bool TryCreate(_In_ std::wstring_view destinationFolderPath, _Out_ std::unique_ptr<MoveJournal>& journal);
+
+    void AppendPlannedItem(_In_ size_t index, _In_ const PlannedMove& move);
+
+    /// Writes the planned items through to the disk
+    void CommitPlan();
+
+    void AppendCompletedItem(_In_ size_t index);
+
+private:
+    ATL::CHandle m_file;
+    std::wstring m_path;
+    std::wstring m_destinationFolderPath;
+    std::string m_buffer;
+    ULONGLONG m_lastWriteTime;
+
+    MoveJournal(_In_ HANDLE file, _In_ std::wstring path, _In_ std::wstring destinationFolderPath);
+
+    void Append(_In_ const nlohmann::json& record);
+    void Write();
+};
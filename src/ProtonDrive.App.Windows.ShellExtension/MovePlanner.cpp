@@ -0,0 +1,285 @@
+#include "pch.h"
+#include "MovePlanner.h"
+
+#include "MoveJournal.h"
+
+#include <sherrors.h>
+
+using namespace std;
+using namespace ATL;
+
+/// Records in the journal the selected items the copy engine has moved
+class ATL_NO_VTABLE CMoveJournalProgressSink :
+    public CComObjectRootEx<CComSingleThreadModel>,
+    public IFileOperationProgressSink
+{
+public:
+    void Initialize(_In_ MoveJournal& journal, _In_ const pmr::vector<PlannedMove>& plan)
+    {
+        m_journal = &journal;
+
+        for (size_t i = 0; i < plan.size(); ++i)
+        {
+            m_indexes.emplace(plan[i].sourcePath, i);
+        }
+    }
+
+    // IFileOperationProgressSink
+    IFACEMETHODIMP PostMoveItem(DWORD, IShellItem* psiItem, IShellItem*, LPCWSTR, HRESULT hrMove, IShellItem*) override
+    {
+        CComHeapPtr<WCHAR> sourcePath;
+        if (FAILED(hrMove) || m_journal == nullptr || psiItem == nullptr || FAILED(psiItem->GetDisplayName(SIGDN_FILESYSPATH, &sourcePath)))
+        {
+            return S_OK;
+        }
+
+        _ATLTRY
+        {
+            // Items inside the moved folders are reported too, they are not in the plan
+            const auto index = m_indexes.find(static_cast<LPCWSTR>(sourcePath));
+            if (index != m_indexes.end())
+            {
+                m_journal->AppendCompletedItem(index->second);
+            }
+        }
+        _ATLCATCHALL()
+        {
+            // Completion records are only an optimization, the move goes on without them
+            m_journal = nullptr;
+        }
+
+        return S_OK;
+    }
+
+    IFACEMETHODIMP StartOperations() override { return S_OK; }
+    IFACEMETHODIMP FinishOperations(HRESULT) override { return S_OK; }
+    IFACEMETHODIMP PreRenameItem(DWORD, IShellItem*, LPCWSTR) override { return S_OK; }
+    IFACEMETHODIMP PostRenameItem(DWORD, IShellItem*, LPCWSTR, HRESULT, IShellItem*) override { return S_OK; }
+    IFACEMETHODIMP PreMoveItem(DWORD, IShellItem*, IShellItem*, LPCWSTR) override { return S_OK; }
+    IFACEMETHODIMP PreCopyItem(DWORD, IShellItem*, IShellItem*, LPCWSTR) override { return S_OK; }
+    IFACEMETHODIMP PostCopyItem(DWORD, IShellItem*, IShellItem*, LPCWSTR, HRESULT, IShellItem*) override { return S_OK; }
+    IFACEMETHODIMP PreDeleteItem(DWORD, IShellItem*) override { return S_OK; }
+    IFACEMETHODIMP PostDeleteItem(DWORD, IShellItem*, HRESULT, IShellItem*) override { return S_OK; }
+    IFACEMETHODIMP PreNewItem(DWORD, IShellItem*, LPCWSTR) override { return S_OK; }
+    IFACEMETHODIMP PostNewItem(DWORD, IShellItem*, LPCWSTR, LPCWSTR, DWORD, HRESULT, IShellItem*) override { return S_OK; }
+    IFACEMETHODIMP UpdateProgress(UINT, UINT) override { return S_OK; }
+    IFACEMETHODIMP ResetTimer() override { return S_OK; }
+    IFACEMETHODIMP PauseTimer() override { return S_OK; }
+    IFACEMETHODIMP ResumeTimer() override { return S_OK; }
+
+    BEGIN_COM_MAP(CMoveJournalProgressSink)
+        COM_INTERFACE_ENTRY(IFileOperationProgressSink)
+    END_COM_MAP()
+
+private:
+    MoveJournal* m_journal = nullptr;
+    unordered_map<wstring_view, size_t> m_indexes;
+};
+
+/// Queues the moves of the content of the folder, leaving in place the files that stay and the folders containing them.
+/// The copy engine needs existing destination folders, so they are created before the operation runs.
+void QueueFolderContentMoves(
+    _In_ IFileOperation& fileOperation,
+    _In_ const wstring& sourceFolderPath,
+    _In_ const wstring& destinationFolderPath,
+    _In_ const unordered_set<wstring>& stayingPaths,
+    _In_ const unordered_set<wstring>& stayingAncestorPaths)
+{
+    if (!CreateDirectory(destinationFolderPath.c_str(), nullptr) && GetLastError() != ERROR_ALREADY_EXISTS)
+    {
+        AtlThrowLastWin32();
+    }
+
+    CComPtr<IShellItem> destinationFolder;
+    auto result = SHCreateItemFromParsingName(destinationFolderPath.c_str(), nullptr, IID_PPV_ARGS(&destinationFolder));
+    ATLENSURE_SUCCEEDED(result);
+
+    WIN32_FIND_DATA findData;
+    const auto findHandle = FindFirstFileEx(
+        (sourceFolderPath + L"\\*").c_str(),
+        FindExInfoBasic,
+        &findData,
+        FindExSearchNameMatch,
+        nullptr,
+        FIND_FIRST_EX_LARGE_FETCH);
+
+    if (findHandle == INVALID_HANDLE_VALUE)
+    {
+        AtlThrowLastWin32();
+    }
+
+    _ATLTRY
+    {
+        do
+        {
+            const auto name = wstring_view(findData.cFileName);
+            if (name == L"." || name == L"..")
+            {
+                continue;
+            }
+
+            const auto path = sourceFolderPath + L'\\' + wstring(name);
+            if (stayingPaths.contains(path))
+            {
+                continue;
+            }
+
+            if (stayingAncestorPaths.contains(path))
+            {
+                QueueFolderContentMoves(fileOperation, path, destinationFolderPath + L'\\' + wstring(name), stayingPaths, stayingAncestorPaths);
+                continue;
+            }
+
+            CComPtr<IShellItem> item;
+            result = SHCreateItemFromParsingName(path.c_str(), nullptr, IID_PPV_ARGS(&item));
+            ATLENSURE_SUCCEEDED(result);
+
+            result = fileOperation.MoveItem(item, destinationFolder, nullptr, nullptr);
+            ATLENSURE_SUCCEEDED(result);
+        } while (FindNextFile(findHandle, &findData));
+    }
+    _ATLCATCHALL()
+    {
+        FindClose(findHandle);
+        throw;
+    }
+
+    FindClose(findHandle);
+}
+
+MovePlanner::MovePlanner(_In_ pmr::memory_resource* memoryResource)
+    : m_memoryResource(memoryResource)
+{
+}
+
+void MovePlanner::Plan(_In_ IShellItemArray& items, _Out_ pmr::vector<PlannedMove>& plan) const
+{
+    plan.clear();
+
+    DWORD numberOfItems;
+    auto result = items.GetCount(&numberOfItems);
+    ATLENSURE_SUCCEEDED(result);
+
+    plan.reserve(numberOfItems);
+
+    for (DWORD i = 0; i < numberOfItems; ++i)
+    {
+        auto& move = plan.emplace_back(PlannedMove { nullptr, pmr::wstring(m_memoryResource) });
+        move.destinationName = pmr::wstring(m_memoryResource);
+
+        result = items.GetItemAt(i, &move.item);
+        ATLENSURE_SUCCEEDED(result);
+
+        CComHeapPtr<WCHAR> sourcePath;
+        if (FAILED(move.item->GetDisplayName(SIGDN_FILESYSPATH, &sourcePath)))
+        {
+            continue;
+        }
+
+        move.sourcePath = sourcePath;
+
+        // The attributes come with the selection, unlike file system queries they do not touch the disk
+        SFGAOF attributes;
+        move.isDirectory = SUCCEEDED(move.item->GetAttributes(SFGAO_FOLDER | SFGAO_STREAM, &attributes))
+            && (attributes & (SFGAO_FOLDER | SFGAO_STREAM)) == SFGAO_FOLDER;
+    }
+}
+
+bool MovePlanner::Execute(_In_ const pmr::vector<PlannedMove>& plan, _In_ IShellItem& destinationFolder, _In_opt_ MoveJournal* journal) const
+{
+    if (plan.empty())
+    {
+        return true;
+    }
+
+    CComPtr<IFileOperation> fileOperation;
+    auto result = CoCreateInstance(__uuidof(FileOperation), nullptr, CLSCTX_ALL, IID_PPV_ARGS(&fileOperation));
+    ATLENSURE_SUCCEEDED(result);
+
+    // The user already chose to replace the conflicting items of the selection, the copy engine must not ask again.
+    // Without replacements, the confirmations are kept for the conflicts that appeared since the selection was checked.
+    if (ranges::any_of(plan, [](const PlannedMove& move) { return move.replaceExisting; }))
+    {
+        result = fileOperation->SetOperationFlags(FOF_ALLOWUNDO | FOF_NOCONFIRMATION);
+        ATLENSURE_SUCCEEDED(result);
+    }
+
+    CComHeapPtr<WCHAR> destinationFolderPath;
+
+    for (const auto& move : plan)
+    {
+        if (!move.duplicateDescendantPaths.empty())
+        {
+            if (!destinationFolderPath)
+            {
+                result = destinationFolder.GetDisplayName(SIGDN_FILESYSPATH, &destinationFolderPath);
+                ATLENSURE_SUCCEEDED(result);
+            }
+
+            unordered_set<wstring> stayingPaths;
+            unordered_set<wstring> stayingAncestorPaths;
+
+            for (const auto& path : move.duplicateDescendantPaths)
+            {
+                stayingPaths.insert(path);
+
+                // The descendants are under the source folder, whose path ends the walk up
+                for (auto separatorPosition = path.find_last_of(L'\\'); separatorPosition > move.sourcePath.size(); separatorPosition = path.find_last_of(L'\\', separatorPosition - 1))
+                {
+                    if (!stayingAncestorPaths.insert(path.substr(0, separatorPosition)).second)
+                    {
+                        break;
+                    }
+                }
+            }
+
+            const auto name = move.destinationName.empty()
+                ? wstring_view(move.sourcePath).substr(move.sourcePath.find_last_of(L'\\') + 1)
+                : wstring_view(move.destinationName);
+
+            QueueFolderContentMoves(*fileOperation, wstring(move.sourcePath), wstring(destinationFolderPath) + L'\\' + wstring(name), stayingPaths, stayingAncestorPaths);
+            continue;
+        }
+
+        result = fileOperation->MoveItem(
+            move.item,
+            &destinationFolder,
+            move.destinationName.empty() ? nullptr : move.destinationName.c_str(),
+            nullptr);
+        ATLENSURE_SUCCEEDED(result);
+    }
+
+    CComPtr<IFileOperationProgressSink> progressSink;
+    DWORD progressSinkCookie = 0;
+
+    if (journal != nullptr)
+    {
+        CComObject<CMoveJournalProgressSink>* progressSinkObject;
+        result = CComObject<CMoveJournalProgressSink>::CreateInstance(&progressSinkObject);
+        ATLENSURE_SUCCEEDED(result);
+
+        progressSink = progressSinkObject;
+        progressSinkObject->Initialize(*journal, plan);
+
+        result = fileOperation->Advise(progressSink, &progressSinkCookie);
+        ATLENSURE_SUCCEEDED(result);
+    }
+
+    result = fileOperation->PerformOperations();
+
+    if (progressSink)
+    {
+        (void)fileOperation->Unadvise(progressSinkCookie);
+    }
+
+    if (result == HRESULT_FROM_WIN32(ERROR_CANCELLED) || result == COPYENGINE_E_USER_CANCELLED || result == E_ABORT)
+    {
+        return false;
+    }
+
+    ATLENSURE_SUCCEEDED(result);
+
+    BOOL anyOperationsAborted;
+    result = fileOperation->GetAnyOperationsAborted(&anyOperationsAborted);
+    return FAILED(result) || !anyOperationsAborted;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "pch.h"
+#include "ContentHasher.h"
+
+class MoveJournal;
+
+struct PlannedMove
+{
+    ATL::CComPtr<IShellItem> item;
+    std::pmr::wstring sourcePath;
+
+    /// Name in the destination folder, empty when it stays the same
+    std::pmr::wstring destinationName;
+    bool isDirectory = false;
+    bool hasConflict = false;
+
+    /// Nothing existed under the destination name when the move was planned
+    bool isDestinationVacant = false;
+
+    /// A file with the same content already exists in Proton Drive
+    bool hasDuplicate = false;
+
+    /// Files inside the folder whose content already exists in Proton Drive. They stay where they are,
+    /// along with the folders containing them, unless the user chose to move them anyway.
+    std::vector<std::wstring> duplicateDescendantPaths;
+
+    /// Hash of the file content, when it was computed to look for duplicates
+    std::optional<ContentHash> contentHash;
+    bool replaceExisting = false;
+};
+
+/// Moves the selected items into a destination folder in a single copy engine operation. The copy engine renames
+/// the items on the same volume as the destination and copies the others, with its progress, conflict user interface and undo.
+/// A folder with files that stay where they are is moved item by item instead, into a destination folder created
+/// ahead of the operation, which undo does not remove.
+/// Neither renaming nor block cloning ahead of the copy engine is worth it: the copy engine already renames within a volume,
+/// and the Proton Drive folder is a cloud files sync root, where the app has to read and upload every byte anyway.
+class MovePlanner
+{
+public:
+    explicit MovePlanner(_In_ std::pmr::memory_resource* memoryResource);
+
+    void Plan(_In_ IShellItemArray& items, _Out_ std::pmr::vector<PlannedMove>& plan) const;
+
+    /// Every item moved is recorded in the journal, if any. Returns false when the user cancelled the move.
+    _Success_(return == true) bool Execute(_In_ const std::pmr::vector<PlannedMove>& plan, _In_ IShellItem& destinationFolder, _In_opt_ MoveJournal* journal = nullptr) const;
+
+private:
+    std::pmr::memory_resource* m_memoryResource;
+};
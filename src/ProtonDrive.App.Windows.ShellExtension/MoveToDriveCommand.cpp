@@ -1,23 +1,25 @@
 #include "pch.h"
 #include "MoveToDriveCommand.h"
 
-#include "ipc.h"
+#include "DegradationController.h"
+#include "MoveConflictPreflight.h"
+#include "MoveDuplicatePreflight.h"
+#include "MoveJournal.h"
+#include "MovePlanner.h"
+#include "PathCanonicalization.h"
+#include "SelectionWalker.h"
+#include "SyncRootRelations.h"
+#include "SyncStateCache.h"
 
 using namespace std;
 using namespace ATL;
 using namespace nlohmann;
 
-enum struct SyncRootType
-{
-    CloudFiles = 1,
-    HostDeviceFolder = 2,
-    ForeignDevice = 3,
-};
-
-struct SyncRootPathsQueryRequest : IpcMessage<vector<SyncRootType>>
-{
-    explicit SyncRootPathsQueryRequest(const vector<SyncRootType>& syncRootTypes) : IpcMessage(L"SyncRootPathsQuery", syncRootTypes) {}
-};
+constexpr DWORD SELECTION_WALK_TIME_BUDGET_MILLISECONDS = 200;
+constexpr uint64_t LARGE_MOVE_MINIMUM_NUMBER_OF_ITEMS = 1000;
+constexpr uint64_t LARGE_MOVE_MINIMUM_SIZE = 1ULL << 30;
+constexpr DWORD LARGE_SELECTION_MINIMUM_NUMBER_OF_ITEMS = 16;
+constexpr size_t MAXIMUM_NUMBER_OF_ITEMS_CHECKED_BY_IDENTITY = 16;
 
 bool TryParsePathAsShellItem(_In_ const wstring& path, _Out_ CComPtr<IShellItem>& shellItem)
 {
@@ -25,33 +27,30 @@ bool TryParsePathAsShellItem(_In_ const wstring& path, _Out_ CComPtr<IShellItem>
     return SUCCEEDED(result);
 }
 
-bool TryParsePathAsItemIdList(_In_ const wstring& path, _Out_ CComHeapPtr<__unaligned ITEMIDLIST_ABSOLUTE>& itemIdList)
+bool TryParsePathAsCanonicalPath(_In_ const wstring& path, _Out_ pmr::wstring& canonicalPath)
 {
-    const auto result = ILCreateFromPath(path.c_str());
-    if (result == nullptr)
-    {
-        return false;
-    }
-
-    itemIdList.Attach(result);
-    return true;
-};
+    CanonicalizePath(path, canonicalPath);
+    return !canonicalPath.empty();
+}
 
-template <typename T>
-bool TryGetSyncRootItems(_In_ const vector<SyncRootType>& syncRootTypes, _In_ auto& parsePath, _Out_ vector<T>& rootItems)
+template <typename TItems>
+bool TryGetSyncRootItems(
+    _In_ const vector<SyncRootType>& syncRootTypes,
+    _In_ auto& parsePath,
+    _In_ pmr::memory_resource* memoryResource,
+    _Out_ TItems& rootItems,
+    _Out_ shared_ptr<const vector<wstring>>& syncRootPathsPointer)
 {
-    const auto request = SyncRootPathsQueryRequest(syncRootTypes);
-
-    vector<wstring> syncRootPaths;
-    if (!TrySendIpcMessage(request, syncRootPaths) || syncRootPaths.empty())
+    if (!SyncStateCache::GetInstance().TryGetSyncRootPaths(syncRootTypes, syncRootPathsPointer, memoryResource) || syncRootPathsPointer->empty())
     {
         return false;
     }
 
-    rootItems = vector<T>(syncRootPaths.size());
+    const auto& syncRootPaths = *syncRootPathsPointer;
+
+    rootItems.resize(syncRootPaths.size());
     for (unsigned int i = 0; i < syncRootPaths.size(); ++i)
     {
-        T rootItem;
         auto result = parsePath(syncRootPaths[i], rootItems[i]);
         if (!result)
         {
@@ -62,6 +61,25 @@ bool TryGetSyncRootItems(_In_ const vector<SyncRootType>& syncRootTypes, _In_ au
     return true;
 }
 
+_Success_(return == true) bool TryCreateShellItemArray(_In_ const vector<wstring>& paths, _Out_ CComPtr<IShellItemArray>& items)
+{
+    vector<CComHeapPtr<ITEMIDLIST_ABSOLUTE>> itemIdLists(paths.size());
+    vector<PCIDLIST_ABSOLUTE> itemIdListPointers;
+    itemIdListPointers.reserve(paths.size());
+
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        if (FAILED(SHParseDisplayName(paths[i].c_str(), nullptr, &itemIdLists[i], 0, nullptr)))
+        {
+            return false;
+        }
+
+        itemIdListPointers.push_back(itemIdLists[i]);
+    }
+
+    return SUCCEEDED(SHCreateShellItemArrayFromIDLists(static_cast<UINT>(itemIdListPointers.size()), itemIdListPointers.data(), &items));
+}
+
 bool CanMove(IShellItem& item)
 {
     SFGAOF attributes;
@@ -74,20 +92,34 @@ bool CanMove(IShellItem& item)
     return (attributes & SFGAO_CANMOVE) != 0;
 }
 
-MoveToDriveCommand::MoveToDriveCommand(_In_ const CComPtr<IShellItemArray>& selectedShellItems)
-    : ContextMenuCommandBase(selectedShellItems)
+MoveToDriveCommand::MoveToDriveCommand(_In_ const CComPtr<IShellItemArray>& selectedShellItems, _In_ pmr::memory_resource* memoryResource)
+    : ContextMenuCommandBase(selectedShellItems, memoryResource)
 {
 }
 
 bool MoveToDriveCommand::CanExecute() const
 {
-    vector<CComHeapPtr<__unaligned ITEMIDLIST_ABSOLUTE>> rootItemIdLists;
-    if (!TryGetSyncRootItems({ SyncRootType::CloudFiles, SyncRootType::HostDeviceFolder, SyncRootType::ForeignDevice }, TryParsePathAsItemIdList, rootItemIdLists))
+    // Every selected item would be checked
+    DWORD numberOfSelectedItems;
+    if (DegradationController::GetInstance().GetMode() >= DegradationMode::SkipLargeSelectionChecks
+        && SUCCEEDED(m_selectedShellItems->GetCount(&numberOfSelectedItems))
+        && numberOfSelectedItems >= LARGE_SELECTION_MINIMUM_NUMBER_OF_ITEMS)
     {
         return false;
     }
 
-    const auto canMoveAndNoRootItemIsRelated = [rootItemIdLists](IShellItem& selectedItem)
+    pmr::vector<pmr::wstring> rootPaths(m_memoryResource);
+    shared_ptr<const vector<wstring>> syncRootPaths;
+    if (!TryGetSyncRootItems({ SyncRootType::CloudFiles, SyncRootType::HostDeviceFolder, SyncRootType::ForeignDevice }, TryParsePathAsCanonicalPath, m_memoryResource, rootPaths, syncRootPaths))
+    {
+        return false;
+    }
+
+    auto& syncRootRelations = SyncRootRelations::GetInstance();
+    pmr::wstring canonicalSelectedItemPath(m_memoryResource);
+    size_t numberOfItemsCheckedByIdentity = 0;
+
+    const auto canMoveAndNoRootItemIsRelated = [this, &rootPaths, &syncRootPaths, &syncRootRelations, &canonicalSelectedItemPath, &numberOfItemsCheckedByIdentity](IShellItem& selectedItem)
     {
         if (!CanMove(selectedItem))
         {
@@ -104,31 +136,33 @@ bool MoveToDriveCommand::CanExecute() const
         const auto result = selectedItem.GetDisplayName(SIGDN_FILESYSPATH, &selectedItemPath);
         ATLENSURE_SUCCEEDED(result);
 
-        CComHeapPtr<__unaligned ITEMIDLIST_ABSOLUTE> selectedItemIdList;
-        if (!TryParsePathAsItemIdList(wstring(selectedItemPath), selectedItemIdList))
+        // The buffer is reused for every selected item
+        CanonicalizePath(static_cast<LPCWSTR>(selectedItemPath), canonicalSelectedItemPath);
+        if (canonicalSelectedItemPath.empty())
         {
             return false;
         }
 
-        const auto isRelated = [&selectedItemIdList](const CComHeapPtr<__unaligned ITEMIDLIST_ABSOLUTE>& rootItemIdList) -> bool
+        // Paths reached through junctions and symbolic links only compare equal by identity. Checking it opens the item
+        // while the menu is being built, so it is skipped for items on network shares, which may wait for the network,
+        // and for the items of a large selection past the first ones.
+        if (numberOfItemsCheckedByIdentity < MAXIMUM_NUMBER_OF_ITEMS_CHECKED_BY_IDENTITY && !IsNetworkCanonicalPath(canonicalSelectedItemPath))
         {
-            const auto isEqual = ILIsEqual(rootItemIdList, selectedItemIdList);
-            if (isEqual)
-            {
-                return true;
-            }
+            ++numberOfItemsCheckedByIdentity;
 
-            const auto isAncestor = ILIsParent(rootItemIdList, selectedItemIdList, false);
-            if (isAncestor)
+            bool isRelatedByIdentity;
+            if (syncRootRelations.TryIsRelatedToAnyRoot(syncRootPaths, static_cast<LPCWSTR>(selectedItemPath), isRelatedByIdentity, m_memoryResource))
             {
-                return true;
+                return !isRelatedByIdentity;
             }
+        }
 
-            const auto isDescendent = ILIsParent(selectedItemIdList, rootItemIdList, false);
-            return isDescendent;
+        const auto isRelated = [&canonicalSelectedItemPath](const pmr::wstring& rootPath) -> bool
+        {
+            return AreRelatedCanonicalPaths(rootPath, canonicalSelectedItemPath);
         };
 
-        const auto noRelatedRootItemFound = !ranges::any_of(rootItemIdLists, isRelated);
+        const auto noRelatedRootItemFound = !ranges::any_of(rootPaths, isRelated);
         return noRelatedRootItemFound;
     };
 
@@ -136,55 +170,139 @@ bool MoveToDriveCommand::CanExecute() const
     return result;
 }
 
-void MoveToDriveCommand::Execute() const
+void MoveToDriveCommand::Execute(_In_opt_ const HWND ownerWindow) const
 {
-    vector<CComPtr<IShellItem>> syncRootItems;
-    if (!TryGetSyncRootItems({ SyncRootType::CloudFiles }, TryParsePathAsShellItem, syncRootItems))
+    shared_ptr<const vector<wstring>> syncRootPathsPointer;
+    if (!SyncStateCache::GetInstance().TryGetSyncRootPaths({ SyncRootType::CloudFiles }, syncRootPathsPointer, m_memoryResource)
+        || syncRootPathsPointer->empty())
     {
         return;
     }
 
-    if (syncRootItems.empty())
+    const auto& cloudFilesRootPath = (*syncRootPathsPointer)[0];
+
+    vector<wstring> selectedPaths;
+    const auto addPath = [&selectedPaths](IShellItem& selectedItem)
     {
+        CComHeapPtr<WCHAR> selectedItemPath;
+        if (SUCCEEDED(selectedItem.GetDisplayName(SIGDN_FILESYSPATH, &selectedItemPath)))
+        {
+            selectedPaths.emplace_back(selectedItemPath);
+        }
+
+        return true;
+    };
+
+    (void)IsTrueForAllSelectedItems(addPath);
+
+    SelectionWalker walker(SELECTION_WALK_TIME_BUDGET_MILLISECONDS);
+    const auto summary = walker.Walk(selectedPaths);
+
+    const auto isLarge = !summary.isComplete
+        || summary.numberOfItems >= LARGE_MOVE_MINIMUM_NUMBER_OF_ITEMS
+        || summary.totalSize >= LARGE_MOVE_MINIMUM_SIZE;
+
+    if (!isLarge)
+    {
+        MoveItems(*m_selectedShellItems, cloudFilesRootPath, ownerWindow, false, m_memoryResource);
         return;
     }
 
-    const auto& cloudFilesRootItem = syncRootItems[0];
+    // Large moves would block the Explorer window that invoked the menu for a long time.
+    // The module is locked before the thread starts, so that it cannot be unloaded under the thread.
+    _pAtlModule->Lock();
 
-    CComPtr<IFileOperation> fileOperation;
-    auto result = CoCreateInstance(__uuidof(FileOperation), nullptr, CLSCTX_ALL, IID_PPV_ARGS(&fileOperation));
-    ATLENSURE_SUCCEEDED(result);
+    try
+    {
+        thread([cloudFilesRootPath, ownerWindow, selectedPaths = std::move(selectedPaths)]
+        {
+            // Low I/O and memory priority, so that the move yields to the user's foreground work and to the sync engine
+            (void)SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
 
-    result = fileOperation->MoveItems(m_selectedShellItems, cloudFilesRootItem);
-    ATLENSURE_SUCCEEDED(result);
+            if (SUCCEEDED(CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED | COINIT_DISABLE_OLE1DDE)))
+            {
+                try
+                {
+                    CComPtr<IShellItemArray> items;
+                    if (TryCreateShellItemArray(selectedPaths, items))
+                    {
+                        MoveItems(*items, cloudFilesRootPath, ownerWindow, true, pmr::get_default_resource());
+                    }
+                }
+                catch (...)
+                {
+                    // Nothing to report the failure to, the copy engine has already shown its errors
+                }
+
+                CoUninitialize();
+            }
 
-    result = fileOperation->PerformOperations();
-    ATLENSURE_SUCCEEDED(result);
+            _pAtlModule->Unlock();
+        }).detach();
+    }
+    catch (...)
+    {
+        _pAtlModule->Unlock();
+        throw;
+    }
 }
 
-bool MoveToDriveCommand::IsTrueForAllSelectedItems(_In_ auto& predicate) const
+void MoveToDriveCommand::MoveItems(
+    _In_ IShellItemArray& items,
+    _In_ const wstring& cloudFilesRootPath,
+    _In_opt_ const HWND ownerWindow,
+    _In_ const bool isLarge,
+    _In_ pmr::memory_resource* memoryResource)
 {
-    CComPtr<IEnumShellItems> shellItemEnumerator;
-    auto result = m_selectedShellItems->EnumItems(&shellItemEnumerator);
-    ATLENSURE_SUCCEEDED(result);
-
-    while (true)
+    CComPtr<IShellItem> cloudFilesRootItem;
+    if (!TryParsePathAsShellItem(cloudFilesRootPath, cloudFilesRootItem))
     {
-        CComPtr<IShellItem> currentSelectedItem;
-        ULONG numberOfItemsFetched;
-        result = shellItemEnumerator->Next(1, &currentSelectedItem, &numberOfItemsFetched);
-        ATLENSURE_SUCCEEDED(result);
+        return;
+    }
+
+    const MovePlanner planner(memoryResource);
+
+    pmr::vector<PlannedMove> plan(memoryResource);
+    planner.Plan(items, plan);
 
-        if (numberOfItemsFetched <= 0)
+    // Skipped duplicates cannot conflict, so they are resolved first.
+    // Hashing and querying the app take seconds, which only large moves running in the background can afford;
+    // small moves are cheap to upload again.
+    if (isLarge)
+    {
+        const auto numberOfDuplicates = MoveDuplicatePreflight::FindDuplicates(plan);
+        if (numberOfDuplicates > 0)
         {
-            break;
+            MoveDuplicatePreflight::Resolve(MoveDuplicatePreflight::AskForResolution(ownerWindow, numberOfDuplicates), plan);
         }
+    }
 
-        if (!predicate(*currentSelectedItem))
+    MoveConflictPreflight preflight(cloudFilesRootPath, memoryResource);
+    const auto numberOfConflicts = preflight.FindConflicts(plan);
+    if (numberOfConflicts > 0)
+    {
+        preflight.Resolve(MoveConflictPreflight::AskForResolution(ownerWindow, numberOfConflicts), plan);
+    }
+
+    // Only large moves are worth resuming after a crash, small ones take no journal writes at all
+    unique_ptr<MoveJournal> journal;
+    if (isLarge && MoveJournal::TryCreate(cloudFilesRootPath, journal))
+    {
+        _ATLTRY
         {
-            return false;
+            for (size_t i = 0; i < plan.size(); ++i)
+            {
+                journal->AppendPlannedItem(i, plan[i]);
+            }
+
+            journal->CommitPlan();
+        }
+        _ATLCATCHALL()
+        {
+            // A move that cannot be journaled is still worth doing, it just cannot be resumed
+            journal.reset();
         }
     }
 
-    return true;
-}
\ No newline at end of file
+    (void)planner.Execute(plan, *cloudFilesRootItem, journal.get());
+}
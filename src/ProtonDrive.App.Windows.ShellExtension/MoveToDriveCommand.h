@@ -4,11 +4,16 @@
 class MoveToDriveCommand : public ContextMenuCommandBase
 {
 public:
-    MoveToDriveCommand(_In_ const ATL::CComPtr<IShellItemArray>& selectedShellItems);
+    MoveToDriveCommand(_In_ const ATL::CComPtr<IShellItemArray>& selectedShellItems, _In_ std::pmr::memory_resource* memoryResource);
     [[nodiscard]] bool CanExecute() const override;
-    void Execute() const override;
+    void Execute(_In_opt_ HWND ownerWindow) const override;
 
 private:
-    [[nodiscard]] bool IsTrueForAllSelectedItems(_In_ auto& predicate) const;
+    static void MoveItems(
+        _In_ IShellItemArray& items,
+        _In_ const std::wstring& cloudFilesRootPath,
+        _In_opt_ HWND ownerWindow,
+        _In_ bool isLarge,
+        _In_ std::pmr::memory_resource* memoryResource);
 };
 
@@ -0,0 +1,287 @@
+#include "pch.h"
+#include "PathCanonicalization.h"
+
+using namespace std;
+
+constexpr wstring_view LOCAL_DEVICE_PREFIX = L"\\\\?\\";
+constexpr wstring_view LOCAL_DEVICE_UNC_PREFIX = L"\\\\?\\UNC\\";
+constexpr wstring_view DEVICE_NAMESPACE_PREFIX = L"\\\\.\\";
+constexpr wstring_view OBJECT_MANAGER_PREFIX = L"\\??\\";
+constexpr wstring_view UNC_PREFIX = L"\\\\";
+constexpr ULONGLONG DRIVE_TARGET_EXPIRATION_MILLISECONDS = 10000;
+
+struct DriveTarget
+{
+    wstring target;
+    ULONGLONG expirationTime = 0;
+};
+
+wstring_view StripPrefix(_In_ wstring_view path, _Out_ bool& isUnc)
+{
+    isUnc = false;
+
+    if (path.starts_with(LOCAL_DEVICE_UNC_PREFIX))
+    {
+        isUnc = true;
+        return path.substr(LOCAL_DEVICE_UNC_PREFIX.size());
+    }
+
+    for (const auto prefix : { LOCAL_DEVICE_PREFIX, DEVICE_NAMESPACE_PREFIX, OBJECT_MANAGER_PREFIX })
+    {
+        if (path.starts_with(prefix))
+        {
+            return path.substr(prefix.size());
+        }
+    }
+
+    if (path.starts_with(UNC_PREFIX))
+    {
+        isUnc = true;
+        return path.substr(UNC_PREFIX.size());
+    }
+
+    return path;
+}
+
+template <typename TString>
+void AppendFoldingSeparators(_In_ const wstring_view path, _Inout_ TString& result)
+{
+    auto previousIsSeparator = !result.empty() && result.back() == L'\\';
+
+    for (const auto character : path)
+    {
+        const auto isSeparator = character == L'\\' || character == L'/';
+        if (isSeparator && previousIsSeparator)
+        {
+            continue;
+        }
+
+        result.push_back(isSeparator ? L'\\' : character);
+        previousIsSeparator = isSeparator;
+    }
+
+    if (!result.empty() && result.back() == L'\\')
+    {
+        result.pop_back();
+    }
+}
+
+bool IsDriveLetterPath(_In_ const wstring_view path)
+{
+    return path.size() >= 2 && path[1] == L':' && iswalpha(path[0]);
+}
+
+wstring ConvertDosDeviceTargetToPath(_In_ const wstring_view dosDeviceTarget)
+{
+    if (dosDeviceTarget.starts_with(OBJECT_MANAGER_PREFIX))
+    {
+        // subst drive, e.g. "\??\C:\Projects"
+        return wstring(dosDeviceTarget.substr(OBJECT_MANAGER_PREFIX.size()));
+    }
+
+    if (const auto connectionStart = dosDeviceTarget.find(L"\\;"); connectionStart != wstring_view::npos)
+    {
+        // Network drive, e.g. "\Device\LanmanRedirector\;Z:000000000001a2b3\server\share"
+        const auto shareStart = dosDeviceTarget.find(L'\\', connectionStart + 2);
+        if (shareStart != wstring_view::npos)
+        {
+            wstring path(UNC_PREFIX);
+            path.append(dosDeviceTarget.substr(shareStart + 1));
+            return path;
+        }
+    }
+
+    return {};
+}
+
+/// Resolves the drive letter of a subst or network drive to the path it points to.
+/// QueryDosDevice is not free, so results are kept for a few seconds.
+wstring GetDriveTarget(_In_ const wchar_t driveLetter)
+{
+    static mutex s_mutex;
+    static array<DriveTarget, 26> s_driveTargets;
+
+    const auto driveIndex = static_cast<int>(towupper(driveLetter)) - 'A';
+    if (driveIndex < 0 || driveIndex >= static_cast<int>(s_driveTargets.size()))
+    {
+        return {};
+    }
+
+    const auto now = GetTickCount64();
+
+    const lock_guard lock(s_mutex);
+
+    auto& driveTarget = s_driveTargets[driveIndex];
+    if (now < driveTarget.expirationTime)
+    {
+        return driveTarget.target;
+    }
+
+    const wchar_t deviceName[] = { static_cast<wchar_t>(L'A' + driveIndex), L':', 0 };
+    wchar_t targetPath[MAX_PATH + 1] = { 0 };
+
+    const auto target = QueryDosDevice(deviceName, targetPath, ARRAYSIZE(targetPath)) != 0
+        ? ConvertDosDeviceTargetToPath(targetPath)
+        : wstring();
+
+    driveTarget = { target, now + DRIVE_TARGET_EXPIRATION_MILLISECONDS };
+
+    return target;
+}
+
+template <typename TString>
+void ExpandShortNames(_Inout_ TString& path)
+{
+    // Short names always contain a tilde, avoid touching the disk otherwise
+    if (path.find(L'~') == TString::npos)
+    {
+        return;
+    }
+
+    const auto length = GetLongPathName(path.c_str(), nullptr, 0);
+    if (length == 0)
+    {
+        return;
+    }
+
+    TString longPath(length, 0, path.get_allocator());
+    const auto resultLength = GetLongPathName(path.c_str(), longPath.data(), length);
+    if (resultLength == 0 || resultLength >= length)
+    {
+        return;
+    }
+
+    longPath.resize(resultLength);
+    path = std::move(longPath);
+}
+
+template <typename TString>
+void ConvertToUpperCase(_Inout_ TString& path)
+{
+    auto isAscii = true;
+
+    for (auto& character : path)
+    {
+        if (character >= L'a' && character <= L'z')
+        {
+            character -= L'a' - L'A';
+        }
+        else if (character >= 0x80)
+        {
+            isAscii = false;
+        }
+    }
+
+    if (isAscii)
+    {
+        return;
+    }
+
+    // The invariant locale upper-casing matches the simple case mapping used by the NTFS upcase table
+    TString upperCasePath(path.size(), 0, path.get_allocator());
+    const auto resultLength = LCMapStringEx(
+        LOCALE_NAME_INVARIANT,
+        LCMAP_UPPERCASE,
+        path.c_str(),
+        static_cast<int>(path.size()),
+        upperCasePath.data(),
+        static_cast<int>(upperCasePath.size()),
+        nullptr,
+        nullptr,
+        0);
+
+    if (resultLength == static_cast<int>(path.size()))
+    {
+        path = std::move(upperCasePath);
+    }
+}
+
+template <typename TString>
+void CanonicalizePath(_In_ const wstring_view path, _Out_ TString& result)
+{
+    bool isUnc;
+    auto remainder = StripPrefix(path, isUnc);
+
+    result.clear();
+    result.reserve(remainder.size() + UNC_PREFIX.size());
+
+    if (isUnc)
+    {
+        result.assign(UNC_PREFIX);
+    }
+    else if (IsDriveLetterPath(remainder))
+    {
+        const auto driveTarget = GetDriveTarget(remainder[0]);
+        if (!driveTarget.empty())
+        {
+            bool isTargetUnc;
+            const auto targetRemainder = StripPrefix(driveTarget, isTargetUnc);
+
+            if (isTargetUnc)
+            {
+                result.assign(UNC_PREFIX);
+            }
+
+            AppendFoldingSeparators(targetRemainder, result);
+            remainder.remove_prefix(2);
+        }
+    }
+
+    AppendFoldingSeparators(remainder, result);
+
+    ExpandShortNames(result);
+    ConvertToUpperCase(result);
+}
+
+template void CanonicalizePath(_In_ wstring_view path, _Out_ wstring& result);
+template void CanonicalizePath(_In_ wstring_view path, _Out_ pmr::wstring& result);
+
+template <typename TString>
+void CanonicalizeName(_In_ const wstring_view name, _Out_ TString& result)
+{
+    result.assign(name);
+    ConvertToUpperCase(result);
+}
+
+template void CanonicalizeName(_In_ wstring_view name, _Out_ pmr::wstring& result);
+
+wstring CanonicalizePath(_In_ const wstring_view path)
+{
+    wstring result;
+    CanonicalizePath(path, result);
+    return result;
+}
+
+bool IsSameCanonicalPath(_In_ const wstring_view first, _In_ const wstring_view second)
+{
+    return first.size() == second.size() && wmemcmp(first.data(), second.data(), first.size()) == 0;
+}
+
+bool IsSameOrAncestorCanonicalPath(_In_ const wstring_view potentialAncestor, _In_ const wstring_view path)
+{
+    if (potentialAncestor.empty() || potentialAncestor.size() > path.size())
+    {
+        return false;
+    }
+
+    // wmemcmp is vectorized by the CRT, canonical paths need no case folding at this point
+    if (wmemcmp(potentialAncestor.data(), path.data(), potentialAncestor.size()) != 0)
+    {
+        return false;
+    }
+
+    return potentialAncestor.size() == path.size() || path[potentialAncestor.size()] == L'\\';
+}
+
+bool AreRelatedCanonicalPaths(_In_ const wstring_view first, _In_ const wstring_view second)
+{
+    return first.size() <= second.size()
+        ? IsSameOrAncestorCanonicalPath(first, second)
+        : IsSameOrAncestorCanonicalPath(second, first);
+}
+
+bool IsNetworkCanonicalPath(_In_ const wstring_view path)
+{
+    // Canonical paths have no device prefix, and network drive letters are replaced with their UNC targets
+    return path.starts_with(UNC_PREFIX);
+}
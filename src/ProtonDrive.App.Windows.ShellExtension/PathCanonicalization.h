@@ -0,0 +1,33 @@
+#pragma once
+
+#include "pch.h"
+
+/// Produces a key identifying a local file system path regardless of its spelling.
+///
+/// The key has no "\\?\" or "\\.\" prefix, uses single backslashes as separators, has no trailing separator,
+/// has 8.3 short names expanded, has subst and network drive letters replaced with their targets, and is
+/// upper-cased the same way NTFS compares names ordinally. Keys can be compared with ordinal comparison.
+template <typename TString>
+void CanonicalizePath(_In_ std::wstring_view path, _Out_ TString& result);
+
+std::wstring CanonicalizePath(_In_ std::wstring_view path);
+
+/// Produces a key identifying a file or folder name within its parent, upper-cased the same way as the path keys.
+template <typename TString>
+void CanonicalizeName(_In_ std::wstring_view name, _Out_ TString& result);
+
+/// Converts the target of a drive letter reported by QueryDosDevice into the path the subst or network drive points to,
+/// or returns an empty string for any other device.
+[[nodiscard]] std::wstring ConvertDosDeviceTargetToPath(_In_ std::wstring_view dosDeviceTarget);
+
+/// Returns true if both canonical paths are equal.
+[[nodiscard]] bool IsSameCanonicalPath(_In_ std::wstring_view first, _In_ std::wstring_view second);
+
+/// Returns true if the first canonical path is equal to or an ancestor of the second one.
+[[nodiscard]] bool IsSameOrAncestorCanonicalPath(_In_ std::wstring_view potentialAncestor, _In_ std::wstring_view path);
+
+/// Returns true if the canonical paths are equal or one is an ancestor of the other.
+[[nodiscard]] bool AreRelatedCanonicalPaths(_In_ std::wstring_view first, _In_ std::wstring_view second);
+
+/// Returns true if the canonical path is on a network share, including paths reached through network drive letters.
+[[nodiscard]] bool IsNetworkCanonicalPath(_In_ std::wstring_view path);
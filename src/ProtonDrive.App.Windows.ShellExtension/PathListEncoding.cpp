@@ -0,0 +1,50 @@
+#include "pch.h"
+#include "PathListEncoding.h"
+
+#include "unicode.h"
+
+using namespace std;
+using namespace nlohmann;
+
+FrontCodedPathList::FrontCodedPathList(vector<wstring> paths)
+    : paths(std::move(paths))
+{
+    ranges::sort(this->paths);
+}
+
+void to_json(json& j, const FrontCodedPathList& list)
+{
+    j = json::array();
+
+    wstring_view previousPath;
+    wstring suffix;
+
+    for (const auto& path : list.paths)
+    {
+        const auto sharedPrefixLength = GetSharedPrefixLength(previousPath, path);
+        if (sharedPrefixLength > 0)
+        {
+            j.push_back(sharedPrefixLength);
+        }
+
+        suffix.assign(path, sharedPrefixLength);
+        j.push_back(ConvertUtf16ToUtf8(suffix.c_str()));
+
+        previousPath = path;
+    }
+}
+
+size_t GetSharedPrefixLength(_In_ const wstring_view previous, _In_ const wstring_view current)
+{
+    const auto [previousEnd, currentEnd] = ranges::mismatch(previous, current);
+
+    auto length = static_cast<size_t>(previousEnd - previous.begin());
+
+    // The suffix would start with a lone low surrogate, which is not valid UTF-16
+    if (length > 0 && IS_HIGH_SURROGATE(previous[length - 1]))
+    {
+        --length;
+    }
+
+    return length;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "pch.h"
+
+/// Path lists are front-coded in IPC messages: a string preceded by a number shares that many leading UTF-16 code units
+/// with the previous string of the list, and carries only the rest. A plain array of strings is a valid front-coded list.
+/// Sorting the paths first makes neighbours share the longest prefixes.
+struct FrontCodedPathList
+{
+    /// Sorts the paths, callers must not depend on their order
+    explicit FrontCodedPathList(std::vector<std::wstring> paths);
+
+    std::vector<std::wstring> paths;
+};
+
+void to_json(nlohmann::json& j, const FrontCodedPathList& list);
+
+/// Number of leading code units the strings share, never splitting a surrogate pair
+[[nodiscard]] size_t GetSharedPrefixLength(_In_ std::wstring_view previous, _In_ std::wstring_view current);
@@ -0,0 +1,238 @@
+#include "pch.h"
+#include "SelectionWalker.h"
+
+using namespace std;
+
+SelectionWalker::SelectionWalker(_In_ const DWORD timeBudgetMilliseconds)
+    : m_timeBudgetMilliseconds(timeBudgetMilliseconds)
+{
+}
+
+SelectionSummary SelectionWalker::Walk(_In_ const vector<wstring>& paths)
+{
+    return WalkAndCollect(paths, nullptr);
+}
+
+SelectionSummary SelectionWalker::Walk(_In_ const vector<wstring>& paths, _In_ const uint64_t minimumFileSize, _Out_ vector<WalkedFile>& files)
+{
+    files.clear();
+    m_minimumFileSize = minimumFileSize;
+
+    return WalkAndCollect(paths, &files);
+}
+
+SelectionSummary SelectionWalker::WalkAndCollect(_In_ const vector<wstring>& paths, _Inout_opt_ vector<WalkedFile>* files)
+{
+    m_files = files;
+    m_deadline = GetTickCount64() + m_timeBudgetMilliseconds;
+
+    for (const auto& path : paths)
+    {
+        WIN32_FILE_ATTRIBUTE_DATA attributeData;
+        if (!GetFileAttributesEx(path.c_str(), GetFileExInfoStandard, &attributeData))
+        {
+            m_isComplete = false;
+            continue;
+        }
+
+        m_numberOfItems.fetch_add(1, memory_order_relaxed);
+
+        const auto isFolder = (attributeData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+        const auto isReparsePoint = (attributeData.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) != 0;
+
+        if (!isFolder)
+        {
+            const auto size = (static_cast<uint64_t>(attributeData.nFileSizeHigh) << 32) | attributeData.nFileSizeLow;
+            m_totalSize.fetch_add(size, memory_order_relaxed);
+
+            if (m_files != nullptr && size >= m_minimumFileSize)
+            {
+                m_files->push_back({ path, size });
+            }
+        }
+        else if (!isReparsePoint)
+        {
+            m_pendingFolders.push_back(path);
+        }
+    }
+
+    if (!m_pendingFolders.empty())
+    {
+        const auto numberOfThreads = clamp(thread::hardware_concurrency(), 1U, MAXIMUM_NUMBER_OF_THREADS);
+
+        vector<thread> threads;
+        threads.reserve(numberOfThreads - 1);
+        for (unsigned int i = 1; i < numberOfThreads; ++i)
+        {
+            try
+            {
+                threads.emplace_back([this] { RunWorker(); });
+            }
+            catch (...)
+            {
+                // Fewer threads only make the walk slower, the started ones are still joined below
+                break;
+            }
+        }
+
+        // The calling thread takes part in the walk as well
+        RunWorker();
+
+        for (auto& workerThread : threads)
+        {
+            workerThread.join();
+        }
+    }
+
+    return { m_numberOfItems, m_totalSize, m_isComplete };
+}
+
+void SelectionWalker::RunWorker()
+{
+    wstring folderPath;
+    while (TryTakeFolder(folderPath))
+    {
+        EnumerateFolder(folderPath);
+
+        const lock_guard lock(m_mutex);
+        --m_numberOfBusyThreads;
+
+        // The last busy thread finding no more work, or any thread giving up, releases the waiting ones
+        if ((m_numberOfBusyThreads == 0 && m_pendingFolders.empty()) || !m_isComplete)
+        {
+            m_workAvailable.notify_all();
+        }
+    }
+}
+
+bool SelectionWalker::TryTakeFolder(_Out_ wstring& folderPath)
+{
+    unique_lock lock(m_mutex);
+
+    m_workAvailable.wait(lock, [this] { return !m_pendingFolders.empty() || m_numberOfBusyThreads == 0 || !m_isComplete; });
+
+    if (m_pendingFolders.empty() || !m_isComplete)
+    {
+        return false;
+    }
+
+    folderPath = std::move(m_pendingFolders.front());
+    m_pendingFolders.pop_front();
+    ++m_numberOfBusyThreads;
+
+    return true;
+}
+
+void SelectionWalker::EnumerateFolder(_In_ const wstring& folderPath)
+{
+    if (IsTimeBudgetExceeded())
+    {
+        m_isComplete = false;
+        return;
+    }
+
+    auto searchPattern = folderPath;
+    if (!searchPattern.empty() && searchPattern.back() != L'\\')
+    {
+        searchPattern += L'\\';
+    }
+
+    const auto folderPathLength = searchPattern.size();
+    searchPattern += L'*';
+
+    WIN32_FIND_DATA findData;
+    const auto findHandle = FindFirstFileEx(
+        searchPattern.c_str(),
+        FindExInfoBasic,
+        &findData,
+        FindExSearchNameMatch,
+        nullptr,
+        FIND_FIRST_EX_LARGE_FETCH);
+
+    if (findHandle == INVALID_HANDLE_VALUE)
+    {
+        if (GetLastError() != ERROR_FILE_NOT_FOUND)
+        {
+            m_isComplete = false;
+        }
+
+        return;
+    }
+
+    uint64_t numberOfItems = 0;
+    uint64_t totalSize = 0;
+
+    // Collected locally and added under the lock once per folder
+    vector<WalkedFile> files;
+
+    while (true)
+    {
+        const auto name = wstring_view(findData.cFileName);
+        if (name != L"." && name != L"..")
+        {
+            ++numberOfItems;
+
+            if ((findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0)
+            {
+                const auto size = (static_cast<uint64_t>(findData.nFileSizeHigh) << 32) | findData.nFileSizeLow;
+                totalSize += size;
+
+                if (m_files != nullptr && size >= m_minimumFileSize)
+                {
+                    auto filePath = wstring(searchPattern, 0, folderPathLength);
+                    filePath += name;
+                    files.push_back({ std::move(filePath), size });
+                }
+            }
+            else if ((findData.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) == 0)
+            {
+                auto subfolderPath = wstring(searchPattern, 0, folderPathLength);
+                subfolderPath += name;
+                AddPendingFolder(std::move(subfolderPath));
+            }
+
+            // Huge folders are checked against the budget while being enumerated
+            if (numberOfItems % 1024 == 0 && IsTimeBudgetExceeded())
+            {
+                m_isComplete = false;
+                break;
+            }
+        }
+
+        if (!FindNextFile(findHandle, &findData))
+        {
+            if (GetLastError() != ERROR_NO_MORE_FILES)
+            {
+                m_isComplete = false;
+            }
+
+            break;
+        }
+    }
+
+    FindClose(findHandle);
+
+    m_numberOfItems.fetch_add(numberOfItems, memory_order_relaxed);
+    m_totalSize.fetch_add(totalSize, memory_order_relaxed);
+
+    if (!files.empty())
+    {
+        const lock_guard lock(m_mutex);
+        m_files->insert(m_files->end(), make_move_iterator(files.begin()), make_move_iterator(files.end()));
+    }
+}
+
+void SelectionWalker::AddPendingFolder(_In_ wstring folderPath)
+{
+    {
+        const lock_guard lock(m_mutex);
+        m_pendingFolders.push_back(std::move(folderPath));
+    }
+
+    m_workAvailable.notify_one();
+}
+
+bool SelectionWalker::IsTimeBudgetExceeded() const
+{
+    return GetTickCount64() >= m_deadline;
+}
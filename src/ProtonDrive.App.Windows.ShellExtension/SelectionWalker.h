@@ -0,0 +1,57 @@
+#pragma once
+
+#include "pch.h"
+
+struct SelectionSummary
+{
+    uint64_t numberOfItems = 0;
+    uint64_t totalSize = 0;
+
+    /// False if the time budget ran out or a folder could not be enumerated, in which case the counts are lower bounds
+    bool isComplete = true;
+};
+
+struct WalkedFile
+{
+    std::wstring path;
+    uint64_t size = 0;
+};
+
+/// Counts the items and bytes under the selected paths with several threads enumerating folders in parallel.
+/// Reparse points are counted but not followed.
+class SelectionWalker
+{
+public:
+    explicit SelectionWalker(_In_ DWORD timeBudgetMilliseconds);
+
+    [[nodiscard]] SelectionSummary Walk(_In_ const std::vector<std::wstring>& paths);
+
+    /// Also collects the files of at least the minimum size, the selected ones and the ones inside the selected folders
+    [[nodiscard]] SelectionSummary Walk(_In_ const std::vector<std::wstring>& paths, _In_ uint64_t minimumFileSize, _Out_ std::vector<WalkedFile>& files);
+
+private:
+    static constexpr unsigned int MAXIMUM_NUMBER_OF_THREADS = 8;
+
+    ULONGLONG m_deadline = 0;
+    DWORD m_timeBudgetMilliseconds;
+
+    std::mutex m_mutex;
+    std::condition_variable m_workAvailable;
+    std::deque<std::wstring> m_pendingFolders;
+    unsigned int m_numberOfBusyThreads = 0;
+
+    std::atomic<uint64_t> m_numberOfItems = 0;
+    std::atomic<uint64_t> m_totalSize = 0;
+    std::atomic<bool> m_isComplete = true;
+
+    /// Guarded by the mutex, null when files are not collected
+    std::vector<WalkedFile>* m_files = nullptr;
+    uint64_t m_minimumFileSize = 0;
+
+    [[nodiscard]] SelectionSummary WalkAndCollect(_In_ const std::vector<std::wstring>& paths, _Inout_opt_ std::vector<WalkedFile>* files);
+    void RunWorker();
+    [[nodiscard]] bool TryTakeFolder(_Out_ std::wstring& folderPath);
+    void EnumerateFolder(_In_ const std::wstring& folderPath);
+    void AddPendingFolder(_In_ std::wstring folderPath);
+    [[nodiscard]] bool IsTimeBudgetExceeded() const;
+};
@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "ShareByUrlCommand.h"
-#include "ipc.h"
+#include "CommandRing.h"
+#include "SyncStateCache.h"
 
 using namespace std;
 using namespace ATL;
@@ -11,30 +12,27 @@ struct ShareByUrlCommandRequest : IpcMessage<wstring>
     ShareByUrlCommandRequest(const wstring& path) : IpcMessage<wstring>(L"ShareByUrlCommand", path) {}
 };
 
-struct RemoteIdsQueryRequest : IpcMessage<wstring>
-{
-    RemoteIdsQueryRequest(const wstring& path) : IpcMessage<wstring>(L"RemoteIdsQuery", path) {}
-};
-
-struct RemoteIdsQueryResponse
+struct PrepareShareHintParameters
 {
     wstring shareId;
     wstring linkId;
 };
 
-void from_json(const json& j, optional<RemoteIdsQueryResponse>& response) {
-    if (j.empty())
-    {
-        return;
-    }
-    
-    response.emplace(
-        j.at(NAMEOF(response.value().shareId)).get<wstring>(),
-        j.at(NAMEOF(response.value().linkId)).get<wstring>());
+void to_json(json& j, const PrepareShareHintParameters& parameters)
+{
+    j = json{
+        {NAMEOF(parameters.shareId), parameters.shareId},
+        {NAMEOF(parameters.linkId), parameters.linkId},
+    };
 }
 
-ShareByUrlCommand::ShareByUrlCommand(const CComPtr<IShellItemArray>& selectedShellItems)
-: ContextMenuCommandBase(selectedShellItems)
+struct PrepareShareHint : IpcMessage<PrepareShareHintParameters>
+{
+    explicit PrepareShareHint(const PrepareShareHintParameters& parameters) : IpcMessage(L"PrepareShareHint", parameters) {}
+};
+
+ShareByUrlCommand::ShareByUrlCommand(const CComPtr<IShellItemArray>& selectedShellItems, pmr::memory_resource* memoryResource)
+: ContextMenuCommandBase(selectedShellItems, memoryResource)
 {
 }
 
@@ -49,7 +47,7 @@ bool ShareByUrlCommand::CanExecute() const
     return HasRemoteCounterpart(path);
 }
 
-void ShareByUrlCommand::Execute() const
+void ShareByUrlCommand::Execute(_In_opt_ HWND) const
 {
     wstring path;
     if (!TryGetSingleSelectedItemPath(path))
@@ -102,9 +100,8 @@ bool ShareByUrlCommand::TryGetSingleSelectedItem(_Out_ CComPtr<IShellItem>& item
 
 bool ShareByUrlCommand::HasRemoteCounterpart(_In_ const std::wstring& path) const
 {
-    const auto request = RemoteIdsQueryRequest(path);
     optional<RemoteIdsQueryResponse> response;
-    if (!TrySendIpcMessage(request, response))
+    if (!SyncStateCache::GetInstance().TryGetRemoteIds(path, response, m_memoryResource))
     {
         return false;
     }
@@ -114,5 +111,16 @@ bool ShareByUrlCommand::HasRemoteCounterpart(_In_ const std::wstring& path) cons
         return false;
     }
 
-    return response.value().linkId.length() > 0;
+    const auto& remoteIds = response.value();
+    if (remoteIds.linkId.empty())
+    {
+        return false;
+    }
+
+    // The user is likely to share the item the command is offered for, the app prepares it meanwhile.
+    // Called while the menu is being built, so the hint is dropped rather than falling back to the pipe.
+    const json hintJsonObject = PrepareShareHint({ remoteIds.shareId, remoteIds.linkId });
+    TryPostCommand(hintJsonObject.dump());
+
+    return true;
 }
@@ -4,9 +4,9 @@
 class ShareByUrlCommand : public ContextMenuCommandBase
 {
 public:
-    ShareByUrlCommand(const ATL::CComPtr<IShellItemArray>& selectedShellItems);
+    ShareByUrlCommand(const ATL::CComPtr<IShellItemArray>& selectedShellItems, std::pmr::memory_resource* memoryResource);
     [[nodiscard]] bool CanExecute() const override;
-    void Execute() const override;
+    void Execute(_In_opt_ HWND ownerWindow) const override;
 
 private:
     _Success_(return == true) bool TryGetSingleSelectedItemPath(_Out_ std::wstring& path) const;
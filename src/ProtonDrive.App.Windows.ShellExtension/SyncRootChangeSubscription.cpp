@@ -0,0 +1,129 @@
+#include "pch.h"
+#include "SyncRootChangeSubscription.h"
+
+#include "ipc.h"
+
+using namespace std;
+using namespace ATL;
+using namespace nlohmann;
+
+constexpr DWORD RECONNECT_INITIAL_DELAY_MILLISECONDS = 1000;
+constexpr DWORD RECONNECT_MAXIMUM_DELAY_MILLISECONDS = 30000;
+
+struct SyncRootChangesSubscriptionRequest : IpcMessage<nullptr_t>
+{
+    SyncRootChangesSubscriptionRequest() : IpcMessage(L"SyncRootChangesSubscription", nullptr) {}
+};
+
+void from_json(const json& j, SyncRootChangeNotification& notification)
+{
+    notification.generation = j.at(NAMEOF(notification.generation)).get<uint64_t>();
+    notification.kind = static_cast<SyncRootChangeKind>(j.at(NAMEOF(notification.kind)).get<int>());
+
+    const auto pathIterator = j.find(NAMEOF(notification.path));
+    notification.path = pathIterator != j.end() && pathIterator->is_string() ? pathIterator->get<wstring>() : wstring();
+}
+
+SyncRootChangeSubscription& SyncRootChangeSubscription::GetInstance()
+{
+    static SyncRootChangeSubscription instance;
+    return instance;
+}
+
+void SyncRootChangeSubscription::AddListener(_In_ Listener listener)
+{
+    const lock_guard lock(m_listenersMutex);
+    m_listeners.push_back(std::move(listener));
+}
+
+void SyncRootChangeSubscription::EnsureStarted()
+{
+    call_once(m_startFlag, [this]
+    {
+        // The thread never exits, so the module must stay loaded for the lifetime of the process
+        _pAtlModule->Lock();
+
+        thread([this] { Run(); }).detach();
+    });
+}
+
+void SyncRootChangeSubscription::Run()
+{
+    auto reconnectDelay = RECONNECT_INITIAL_DELAY_MILLISECONDS;
+
+    while (true)
+    {
+        try
+        {
+            CHandle pipeHandle;
+            if (TryOpenPipe(pipeHandle))
+            {
+                reconnectDelay = RECONNECT_INITIAL_DELAY_MILLISECONDS;
+                ReceiveNotifications(pipeHandle);
+            }
+        }
+        catch (...)
+        {
+            // The connection is re-established below
+        }
+
+        if (m_isLive.exchange(false))
+        {
+            NotifyListeners({ m_generation, SyncRootChangeKind::Resync, {} });
+        }
+
+        Sleep(reconnectDelay);
+        reconnectDelay = min(reconnectDelay * 2, RECONNECT_MAXIMUM_DELAY_MILLISECONDS);
+    }
+}
+
+void SyncRootChangeSubscription::ReceiveNotifications(_In_ const HANDLE pipeHandle)
+{
+    DWORD pipeReadMode = PIPE_READMODE_MESSAGE;
+    if (!SetNamedPipeHandleState(pipeHandle, &pipeReadMode, nullptr, nullptr))
+    {
+        return;
+    }
+
+    const json requestJsonObject = SyncRootChangesSubscriptionRequest();
+    if (!TryWritePipeMessage(pipeHandle, requestJsonObject.dump()))
+    {
+        return;
+    }
+
+    string message;
+    while (TryReadPipeMessage(pipeHandle, message))
+    {
+        OnNotification(json::parse(message).get<SyncRootChangeNotification>());
+    }
+}
+
+void SyncRootChangeSubscription::OnNotification(_In_ const SyncRootChangeNotification& notification)
+{
+    const auto previousGeneration = m_generation.exchange(notification.generation);
+
+    // The first notification after connecting is a baseline, earlier state cannot be trusted
+    if (!m_isLive.exchange(true) || notification.kind == SyncRootChangeKind::Resync)
+    {
+        NotifyListeners({ notification.generation, SyncRootChangeKind::Resync, {} });
+        return;
+    }
+
+    if (notification.generation != previousGeneration + 1)
+    {
+        NotifyListeners({ notification.generation, SyncRootChangeKind::Resync, {} });
+        return;
+    }
+
+    NotifyListeners(notification);
+}
+
+void SyncRootChangeSubscription::NotifyListeners(_In_ const SyncRootChangeNotification& notification)
+{
+    const lock_guard lock(m_listenersMutex);
+
+    for (const auto& listener : m_listeners)
+    {
+        listener(notification);
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "pch.h"
+
+enum struct SyncRootChangeKind
+{
+    Resync = 0,
+    SyncRootsChanged = 1,
+    ItemRenamed = 2,
+    LinkCreated = 3,
+    ItemDeleted = 4,
+};
+
+struct SyncRootChangeNotification
+{
+    uint64_t generation = 0;
+    SyncRootChangeKind kind = SyncRootChangeKind::Resync;
+    std::wstring path;
+};
+
+void from_json(const nlohmann::json& j, SyncRootChangeNotification& notification);
+
+/// Keeps a subscription connection open to the app and dispatches the pushed sync root and mapping
+/// change notifications to the registered listeners on the background thread.
+///
+/// A gap in the generation sequence or a lost connection is reported to the listeners as
+/// SyncRootChangeKind::Resync, after which all state derived from earlier queries must be dropped.
+class SyncRootChangeSubscription
+{
+public:
+    using Listener = std::function<void(const SyncRootChangeNotification&)>;
+
+    static SyncRootChangeSubscription& GetInstance();
+
+    void AddListener(_In_ Listener listener);
+    void EnsureStarted();
+
+    /// True while connected to the app and no notification is known to be missed.
+    [[nodiscard]] bool IsLive() const { return m_isLive; }
+    [[nodiscard]] uint64_t GetGeneration() const { return m_generation; }
+
+private:
+    SyncRootChangeSubscription() = default;
+
+    void Run();
+    void ReceiveNotifications(_In_ HANDLE pipeHandle);
+    void OnNotification(_In_ const SyncRootChangeNotification& notification);
+    void NotifyListeners(_In_ const SyncRootChangeNotification& notification);
+
+    std::once_flag m_startFlag;
+    std::mutex m_listenersMutex;
+    std::vector<Listener> m_listeners;
+    std::atomic<bool> m_isLive = false;
+    std::atomic<uint64_t> m_generation = 0;
+};
@@ -0,0 +1,132 @@
+#include "pch.h"
+#include "SyncRootRelations.h"
+
+#include "PathCanonicalization.h"
+
+using namespace std;
+using namespace ATL;
+
+SyncRootRelations& SyncRootRelations::GetInstance()
+{
+    static SyncRootRelations s_instance;
+    return s_instance;
+}
+
+_Success_(return == true) bool SyncRootRelations::TryIsRelatedToAnyRoot(
+    _In_ const shared_ptr<const vector<wstring>>& syncRootPaths,
+    _In_z_ const LPCWSTR path,
+    _Out_ bool& isRelated,
+    _In_ pmr::memory_resource* memoryResource)
+{
+    isRelated = false;
+
+    const auto roots = GetRoots(syncRootPaths);
+    if (!roots)
+    {
+        return false;
+    }
+
+    // Moving a junction or symbolic link moves the link, not its target
+    CHandle handle;
+    FileIdentity identity;
+    if (!TryOpenForIdentity(path, false, handle) || !TryGetFileIdentity(handle, identity))
+    {
+        return false;
+    }
+
+    if (roots->ancestorIdentities.contains(identity))
+    {
+        isRelated = true;
+        return true;
+    }
+
+    pmr::wstring canonicalFinalPath(memoryResource);
+    if (!TryGetCanonicalFinalPath(handle, canonicalFinalPath))
+    {
+        return false;
+    }
+
+    const auto isRelatedPath = [&canonicalFinalPath](const wstring& rootPath) -> bool
+    {
+        return AreRelatedCanonicalPaths(rootPath, canonicalFinalPath);
+    };
+
+    isRelated = ranges::any_of(roots->canonicalFinalPaths, isRelatedPath);
+    return true;
+}
+
+shared_ptr<const SyncRootRelations::Roots> SyncRootRelations::GetRoots(_In_ const shared_ptr<const vector<wstring>>& syncRootPaths)
+{
+    {
+        const lock_guard lock(m_mutex);
+
+        // Without the change subscription, every query returns a new list with the same paths
+        if (m_roots && (m_roots->syncRootPaths == syncRootPaths
+            || (GetTickCount64() < m_roots->expirationTime && *m_roots->syncRootPaths == *syncRootPaths)))
+        {
+            return m_roots;
+        }
+    }
+
+    auto roots = TryGetRootsIdentities(syncRootPaths);
+    if (!roots)
+    {
+        return nullptr;
+    }
+
+    const lock_guard lock(m_mutex);
+    m_roots = roots;
+
+    return roots;
+}
+
+shared_ptr<const SyncRootRelations::Roots> SyncRootRelations::TryGetRootsIdentities(_In_ const shared_ptr<const vector<wstring>>& syncRootPaths)
+{
+    auto roots = make_shared<Roots>();
+    roots->syncRootPaths = syncRootPaths;
+    roots->canonicalFinalPaths.reserve(syncRootPaths->size());
+
+    wstring ancestorPath;
+
+    for (const auto& rootPath : *syncRootPaths)
+    {
+        CHandle handle;
+        wstring canonicalFinalPath;
+        if (!TryOpenForIdentity(rootPath.c_str(), true, handle) || !TryGetCanonicalFinalPath(handle, canonicalFinalPath))
+        {
+            return nullptr;
+        }
+
+        // The final path has no links left to follow, so its ancestors are the actual containers of the root.
+        // Ancestors that cannot be opened end the chain, the final path comparison still covers them.
+        for (auto ancestor = wstring_view(canonicalFinalPath); !ancestor.empty();)
+        {
+            CHandle ancestorHandle;
+            FileIdentity identity;
+
+            // Without a trailing separator, "C:" is the current folder of the drive and a share root cannot be opened
+            ancestorPath.assign(ancestor);
+            if (ancestor.size() == 2 && ancestor[1] == L':')
+            {
+                ancestorPath.push_back(L'\\');
+            }
+
+            if ((!TryOpenForIdentity(ancestorPath.c_str(), true, ancestorHandle) && !TryOpenForIdentity(ancestorPath.append(L"\\").c_str(), true, ancestorHandle))
+                || !TryGetFileIdentity(ancestorHandle, identity))
+            {
+                break;
+            }
+
+            roots->ancestorIdentities.insert(identity);
+
+            const auto separatorPosition = ancestor.find_last_of(L'\\');
+            ancestor = separatorPosition != wstring_view::npos ? ancestor.substr(0, separatorPosition) : wstring_view();
+        }
+
+        roots->canonicalFinalPaths.push_back(std::move(canonicalFinalPath));
+    }
+
+    roots->expirationTime = GetTickCount64() + ROOTS_EXPIRATION_MILLISECONDS;
+
+    return roots;
+}
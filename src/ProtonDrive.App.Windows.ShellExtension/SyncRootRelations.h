@@ -0,0 +1,45 @@
+#pragma once
+
+#include "pch.h"
+#include "FileIdentity.h"
+
+/// Decides whether items are related to sync roots by file identity, so that junctions, symbolic links,
+/// subst and network drives can neither hide nor fake a relation. The identities of the sync roots and
+/// their ancestors are computed once per list of sync root paths.
+class SyncRootRelations
+{
+public:
+    static SyncRootRelations& GetInstance();
+
+    /// Returns false if the relation cannot be decided by identity, in which case callers fall back to comparing paths.
+    /// The item is opened, callers on the thread building the menu limit how many items they check this way.
+    _Success_(return == true) bool TryIsRelatedToAnyRoot(
+        _In_ const std::shared_ptr<const std::vector<std::wstring>>& syncRootPaths,
+        _In_z_ LPCWSTR path,
+        _Out_ bool& isRelated,
+        _In_ std::pmr::memory_resource* memoryResource = std::pmr::get_default_resource());
+
+private:
+    static constexpr ULONGLONG ROOTS_EXPIRATION_MILLISECONDS = 10000;
+
+    struct Roots
+    {
+        std::shared_ptr<const std::vector<std::wstring>> syncRootPaths;
+        ULONGLONG expirationTime = 0;
+
+        /// The roots and all their ancestors, an item with one of these identities contains a root
+        std::unordered_set<FileIdentity, FileIdentityHash> ancestorIdentities;
+
+        /// An item whose final path is related to one of these is related to a root
+        std::vector<std::wstring> canonicalFinalPaths;
+    };
+
+    SyncRootRelations() = default;
+
+    [[nodiscard]] static std::shared_ptr<const Roots> TryGetRootsIdentities(_In_ const std::shared_ptr<const std::vector<std::wstring>>& syncRootPaths);
+
+    [[nodiscard]] std::shared_ptr<const Roots> GetRoots(_In_ const std::shared_ptr<const std::vector<std::wstring>>& syncRootPaths);
+
+    std::mutex m_mutex;
+    std::shared_ptr<const Roots> m_roots;
+};
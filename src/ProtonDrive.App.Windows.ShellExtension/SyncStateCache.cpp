@@ -0,0 +1,230 @@
+#include "pch.h"
+#include "SyncStateCache.h"
+
+#include "DegradationController.h"
+#include "HostProcessPolicy.h"
+#include "LatencyRecorder.h"
+#include "PathCanonicalization.h"
+
+using namespace std;
+
+SyncStateCache& SyncStateCache::GetInstance()
+{
+    static SyncStateCache instance;
+    return instance;
+}
+
+SyncStateCache::SyncStateCache()
+{
+    auto& subscription = SyncRootChangeSubscription::GetInstance();
+    subscription.AddListener([this](const SyncRootChangeNotification& notification) { OnSyncRootChanged(notification); });
+
+    // Without the subscription nothing is cached, every query goes to the app
+    if (GetHostProcessPolicy() == HostProcessPolicy::Full)
+    {
+        subscription.EnsureStarted();
+    }
+}
+
+_Success_(return == true) bool SyncStateCache::TryGetSyncRootPaths(
+    _In_ const vector<SyncRootType>& syncRootTypes,
+    _Out_ shared_ptr<const vector<wstring>>& syncRootPaths,
+    _In_ pmr::memory_resource* memoryResource)
+{
+    uint64_t invalidationCount;
+    {
+        const lock_guard lock(m_mutex);
+
+        const auto iterator = m_syncRootPaths.find(syncRootTypes);
+        if (iterator != m_syncRootPaths.end())
+        {
+            syncRootPaths = iterator->second;
+            return true;
+        }
+
+        invalidationCount = m_invalidationCount;
+    }
+
+    if (DegradationController::GetInstance().GetMode() >= DegradationMode::CacheOnly)
+    {
+        return false;
+    }
+
+    auto receivedSyncRootPaths = make_shared<vector<wstring>>();
+    {
+        const LatencyScope latencyScope(LatencyPhase::SyncRootPathsQuery);
+
+        if (!TrySendIpcMessage(SyncRootPathsQueryRequest(syncRootTypes), *receivedSyncRootPaths, memoryResource))
+        {
+            return false;
+        }
+    }
+
+    syncRootPaths = std::move(receivedSyncRootPaths);
+
+    const lock_guard lock(m_mutex);
+
+    // A response that raced with a change notification might already be stale
+    if (SyncRootChangeSubscription::GetInstance().IsLive() && invalidationCount == m_invalidationCount)
+    {
+        m_syncRootPaths[syncRootTypes] = syncRootPaths;
+    }
+
+    return true;
+}
+
+void SyncStateCache::Prefetch(_In_ const vector<vector<SyncRootType>>& syncRootTypeSets, _In_ const ULONGLONG deadline)
+{
+    // Prefetched paths could not be kept without the subscription
+    if (!SyncRootChangeSubscription::GetInstance().IsLive() || DegradationController::GetInstance().GetMode() >= DegradationMode::CacheOnly)
+    {
+        return;
+    }
+
+    vector<vector<SyncRootType>> missingSyncRootTypeSets;
+    uint64_t invalidationCount;
+    {
+        const lock_guard lock(m_mutex);
+
+        ranges::copy_if(syncRootTypeSets, back_inserter(missingSyncRootTypeSets), [this](const auto& syncRootTypes) { return !m_syncRootPaths.contains(syncRootTypes); });
+        invalidationCount = m_invalidationCount;
+    }
+
+    if (missingSyncRootTypeSets.size() < 2)
+    {
+        return;
+    }
+
+    const LatencyScope latencyScope(LatencyPhase::SyncRootPathsQuery);
+
+    vector<IpcTask<bool>> tasks;
+    tasks.reserve(missingSyncRootTypeSets.size());
+
+    for (auto& syncRootTypes : missingSyncRootTypeSets)
+    {
+        tasks.push_back(PrefetchSyncRootPaths(std::move(syncRootTypes), invalidationCount, deadline));
+    }
+
+    // Queries not completed by the deadline are cancelled, commands query the app themselves on a cache miss
+    for (auto& task : tasks)
+    {
+        bool succeeded;
+        if (!task.TryWaitUntil(deadline, succeeded))
+        {
+            break;
+        }
+    }
+}
+
+IpcTask<bool> SyncStateCache::PrefetchSyncRootPaths(vector<SyncRootType> syncRootTypes, const uint64_t invalidationCount, const ULONGLONG deadline)
+{
+    auto syncRootPaths = co_await IpcClient::GetInstance().Query<vector<wstring>>(SyncRootPathsQueryRequest(syncRootTypes), deadline);
+    if (!syncRootPaths.has_value())
+    {
+        co_return false;
+    }
+
+    const lock_guard lock(m_mutex);
+
+    if (SyncRootChangeSubscription::GetInstance().IsLive() && invalidationCount == m_invalidationCount)
+    {
+        m_syncRootPaths[syncRootTypes] = make_shared<const vector<wstring>>(std::move(*syncRootPaths));
+    }
+
+    co_return true;
+}
+
+_Success_(return == true) bool SyncStateCache::TryGetRemoteIds(
+    _In_ const wstring& path,
+    _Out_ optional<RemoteIdsQueryResponse>& remoteIds,
+    _In_ pmr::memory_resource* memoryResource)
+{
+    const auto canonicalPath = CanonicalizePath(path);
+
+    uint64_t invalidationCount;
+    {
+        const lock_guard lock(m_mutex);
+
+        const auto iterator = m_remoteIds.find(canonicalPath);
+        if (iterator != m_remoteIds.end())
+        {
+            remoteIds = iterator->second;
+            return true;
+        }
+
+        invalidationCount = m_invalidationCount;
+    }
+
+    if (DegradationController::GetInstance().GetMode() >= DegradationMode::CacheOnly)
+    {
+        return false;
+    }
+
+    remoteIds.reset();
+    {
+        const LatencyScope latencyScope(LatencyPhase::RemoteIdsQuery);
+
+        if (!TrySendIpcMessage(RemoteIdsQueryRequest(path), remoteIds, memoryResource))
+        {
+            return false;
+        }
+    }
+
+    const lock_guard lock(m_mutex);
+
+    if (SyncRootChangeSubscription::GetInstance().IsLive() && invalidationCount == m_invalidationCount)
+    {
+        if (m_remoteIds.size() >= MAXIMUM_NUMBER_OF_REMOTE_IDS)
+        {
+            m_remoteIds.clear();
+        }
+
+        m_remoteIds[canonicalPath] = remoteIds;
+    }
+
+    return true;
+}
+
+void SyncStateCache::OnSyncRootChanged(_In_ const SyncRootChangeNotification& notification)
+{
+    const auto canonicalPath = notification.path.empty() ? wstring() : CanonicalizePath(notification.path);
+
+    const lock_guard lock(m_mutex);
+
+    ++m_invalidationCount;
+
+    switch (notification.kind)
+    {
+    case SyncRootChangeKind::LinkCreated:
+        m_remoteIds.erase(canonicalPath);
+        break;
+
+    case SyncRootChangeKind::ItemDeleted:
+    {
+        m_remoteIds.erase(canonicalPath);
+
+        // The keys of the descendants share the folder path followed by a separator, so they are contiguous.
+        // They do not follow the folder key directly: siblings such as "NAME 2" or "NAME.TXT" sort in between.
+        const auto descendantPrefix = canonicalPath.ends_with(L'\\') ? canonicalPath : canonicalPath + L'\\';
+        const auto begin = m_remoteIds.lower_bound(descendantPrefix);
+        auto end = begin;
+        while (end != m_remoteIds.end() && end->first.starts_with(descendantPrefix))
+        {
+            ++end;
+        }
+
+        m_remoteIds.erase(begin, end);
+        break;
+    }
+
+    case SyncRootChangeKind::ItemRenamed:
+        // The old path of the renamed item is not known
+        m_remoteIds.clear();
+        break;
+
+    default:
+        m_syncRootPaths.clear();
+        m_remoteIds.clear();
+        break;
+    }
+}
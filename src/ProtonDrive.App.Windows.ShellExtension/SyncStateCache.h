@@ -0,0 +1,45 @@
+#pragma once
+
+#include "pch.h"
+#include "AllocationAccounting.h"
+#include "IpcClient.h"
+#include "IpcContracts.h"
+#include "SyncRootChangeSubscription.h"
+
+/// Answers sync root and remote ID queries, keeping the responses while the change subscription
+/// guarantees that they are up to date. Falls back to querying the app on every call otherwise.
+/// In the cache-only degradation mode, queries the cache cannot answer fail without asking the app.
+class SyncStateCache
+{
+public:
+    static SyncStateCache& GetInstance();
+
+    /// The returned paths are shared with the cache and must not be modified
+    _Success_(return == true) bool TryGetSyncRootPaths(
+        _In_ const std::vector<SyncRootType>& syncRootTypes,
+        _Out_ std::shared_ptr<const std::vector<std::wstring>>& syncRootPaths,
+        _In_ std::pmr::memory_resource* memoryResource = AllocationAccounting::GetInstance().GetResource(AllocationSubsystem::Ipc));
+
+    /// Queries the sync root paths of all the given type sets missing from the cache at once, so that commands asking for
+    /// them one after the other find them cached. Waits until the deadline at most, which is in GetTickCount64 time.
+    void Prefetch(_In_ const std::vector<std::vector<SyncRootType>>& syncRootTypeSets, _In_ ULONGLONG deadline);
+
+    _Success_(return == true) bool TryGetRemoteIds(
+        _In_ const std::wstring& path,
+        _Out_ std::optional<RemoteIdsQueryResponse>& remoteIds,
+        _In_ std::pmr::memory_resource* memoryResource = AllocationAccounting::GetInstance().GetResource(AllocationSubsystem::Ipc));
+
+private:
+    static constexpr size_t MAXIMUM_NUMBER_OF_REMOTE_IDS = 256;
+
+    SyncStateCache();
+
+    IpcTask<bool> PrefetchSyncRootPaths(std::vector<SyncRootType> syncRootTypes, uint64_t invalidationCount, ULONGLONG deadline);
+
+    void OnSyncRootChanged(_In_ const SyncRootChangeNotification& notification);
+
+    std::mutex m_mutex;
+    uint64_t m_invalidationCount = 0;
+    std::map<std::vector<SyncRootType>, std::shared_ptr<const std::vector<std::wstring>>> m_syncRootPaths;
+    std::map<std::wstring, std::optional<RemoteIdsQueryResponse>> m_remoteIds;
+};
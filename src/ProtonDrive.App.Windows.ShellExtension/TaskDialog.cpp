@@ -0,0 +1,28 @@
+#include "pch.h"
+#include "TaskDialog.h"
+
+using namespace std;
+
+_Success_(return == true) bool TryShowTaskDialog(_In_ const TASKDIALOGCONFIG& config, _Out_ int& buttonId)
+{
+    buttonId = 0;
+
+    // Resolved in the activation context of the calling thread, which decides the version of the common controls
+    auto moduleHandle = GetModuleHandle(L"comctl32.dll");
+    if (moduleHandle == nullptr)
+    {
+        moduleHandle = LoadLibraryEx(L"comctl32.dll", nullptr, LOAD_LIBRARY_SEARCH_SYSTEM32);
+        if (moduleHandle == nullptr)
+        {
+            return false;
+        }
+    }
+
+    const auto taskDialogIndirect = reinterpret_cast<decltype(&TaskDialogIndirect)>(GetProcAddress(moduleHandle, "TaskDialogIndirect"));
+    if (taskDialogIndirect == nullptr)
+    {
+        return false;
+    }
+
+    return SUCCEEDED(taskDialogIndirect(&config, &buttonId, nullptr, nullptr));
+}
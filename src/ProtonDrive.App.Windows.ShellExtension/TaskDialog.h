@@ -0,0 +1,8 @@
+#pragma once
+
+#include "pch.h"
+
+/// Shows a task dialog if the common controls loaded in the host process provide it.
+/// Task dialogs need version 6 of the common controls, which not every host process activates;
+/// calling the import directly would then fail to resolve and crash the host.
+_Success_(return == true) bool TryShowTaskDialog(_In_ const TASKDIALOGCONFIG& config, _Out_ int& buttonId);
@@ -0,0 +1,129 @@
+#include "pch.h"
+#include "ThumbnailBatcher.h"
+
+#include "PathListEncoding.h"
+
+using namespace std;
+using namespace ATL;
+using namespace nlohmann;
+
+/// The response has the path of a thumbnail image for every path of the list, in the order of the sorted list, or an empty string
+struct ThumbnailQuery : IpcMessage<FrontCodedPathList>
+{
+    explicit ThumbnailQuery(vector<wstring> paths) : IpcMessage(L"ThumbnailQuery", FrontCodedPathList(std::move(paths))) {}
+};
+
+ThumbnailBatcher& ThumbnailBatcher::GetInstance()
+{
+    static ThumbnailBatcher instance;
+    return instance;
+}
+
+_Success_(return == true) bool ThumbnailBatcher::TryGetThumbnailPath(_In_ const wstring& path, _In_ const ULONGLONG deadline, _Out_ wstring& thumbnailPath)
+{
+    const auto request = make_shared<Request>(path);
+
+    unique_lock lock(m_mutex);
+
+    m_pendingRequests.push_back(request);
+
+    // Wakes the collecting thread when the batch is full
+    m_changed.notify_all();
+
+    while (!request->isCompleted)
+    {
+        const auto now = GetTickCount64();
+        if (now >= deadline)
+        {
+            // Not sent yet, nobody else waits for it
+            erase(m_pendingRequests, request);
+            return false;
+        }
+
+        if (!m_isCollecting && !m_pendingRequests.empty())
+        {
+            SendBatch(lock);
+            continue;
+        }
+
+        m_changed.wait_for(lock, chrono::milliseconds(deadline - now));
+    }
+
+    if (!request->succeeded)
+    {
+        return false;
+    }
+
+    thumbnailPath = std::move(request->thumbnailPath);
+    return true;
+}
+
+void ThumbnailBatcher::SendBatch(_Inout_ unique_lock<mutex>& lock)
+{
+    m_isCollecting = true;
+
+    // The shell asks for the thumbnails of the visible items one at a time, on several threads
+    m_changed.wait_for(lock, chrono::milliseconds(BATCHING_WINDOW_MILLISECONDS), [this] { return m_pendingRequests.size() >= MAXIMUM_BATCH_SIZE; });
+
+    const auto batchSize = (min)(m_pendingRequests.size(), MAXIMUM_BATCH_SIZE);
+
+    vector<shared_ptr<Request>> batch(m_pendingRequests.begin(), m_pendingRequests.begin() + static_cast<ptrdiff_t>(batchSize));
+    m_pendingRequests.erase(m_pendingRequests.begin(), m_pendingRequests.begin() + static_cast<ptrdiff_t>(batchSize));
+
+    m_isCollecting = false;
+
+    // Another waiting thread sends the remaining requests
+    m_changed.notify_all();
+
+    if (batch.empty())
+    {
+        return;
+    }
+
+    lock.unlock();
+
+    // Completes the requests on its own, the waiting threads give up at their deadline
+    QueryThumbnails(std::move(batch), GetTickCount64() + QUERY_TIMEOUT_MILLISECONDS);
+
+    lock.lock();
+}
+
+IpcTask<bool> ThumbnailBatcher::QueryThumbnails(vector<shared_ptr<Request>> batch, const ULONGLONG deadline)
+{
+    // The app responds in the order of the sorted paths
+    ranges::sort(batch, {}, [](const shared_ptr<Request>& request) -> const wstring& { return request->path; });
+
+    vector<wstring> paths;
+    paths.reserve(batch.size());
+
+    for (const auto& request : batch)
+    {
+        paths.push_back(request->path);
+    }
+
+    const auto thumbnailPaths = co_await IpcClient::GetInstance().Query<vector<wstring>>(ThumbnailQuery(std::move(paths)), deadline);
+
+    Complete(batch, thumbnailPaths);
+
+    co_return thumbnailPaths.has_value();
+}
+
+void ThumbnailBatcher::Complete(_In_ const vector<shared_ptr<Request>>& batch, _In_ const optional<vector<wstring>>& thumbnailPaths)
+{
+    const auto succeeded = thumbnailPaths.has_value() && thumbnailPaths->size() == batch.size();
+
+    const lock_guard lock(m_mutex);
+
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+        batch[i]->isCompleted = true;
+        batch[i]->succeeded = succeeded;
+
+        if (succeeded)
+        {
+            batch[i]->thumbnailPath = (*thumbnailPaths)[i];
+        }
+    }
+
+    m_changed.notify_all();
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "pch.h"
+#include "IpcClient.h"
+
+/// Gathers the thumbnail requests the shell makes on several threads at once into a single query to the app.
+/// The first waiting thread collects the requests arriving for a short while and sends them, the others wait
+/// for their response. Remaining requests are sent by the next waiting thread.
+class ThumbnailBatcher
+{
+public:
+    static ThumbnailBatcher& GetInstance();
+
+    /// Gets the path of a thumbnail image the app keeps for the file, which is empty if the file has no thumbnail.
+    /// Waits until the deadline at most, which is in GetTickCount64 time.
+    _Success_(return == true) bool TryGetThumbnailPath(_In_ const std::wstring& path, _In_ ULONGLONG deadline, _Out_ std::wstring& thumbnailPath);
+
+private:
+    static constexpr DWORD BATCHING_WINDOW_MILLISECONDS = 30;
+    static constexpr size_t MAXIMUM_BATCH_SIZE = 64;
+    static constexpr ULONGLONG QUERY_TIMEOUT_MILLISECONDS = 5000;
+
+    struct Request
+    {
+        explicit Request(std::wstring path) : path(std::move(path)) {}
+
+        std::wstring path;
+        bool isCompleted = false;
+        bool succeeded = false;
+        std::wstring thumbnailPath;
+    };
+
+    ThumbnailBatcher() = default;
+
+    void SendBatch(_Inout_ std::unique_lock<std::mutex>& lock);
+    IpcTask<bool> QueryThumbnails(std::vector<std::shared_ptr<Request>> batch, ULONGLONG deadline);
+    void Complete(_In_ const std::vector<std::shared_ptr<Request>>& batch, _In_ const std::optional<std::vector<std::wstring>>& thumbnailPaths);
+
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    std::deque<std::shared_ptr<Request>> m_pendingRequests;
+    bool m_isCollecting = false;
+};
@@ -0,0 +1,159 @@
+#include "pch.h"
+#include "ThumbnailProvider.h"
+
+#include <Shlwapi.h>
+
+#include "graphics.h"
+#include "ThumbnailBatcher.h"
+
+using namespace std;
+using namespace ATL;
+
+// The app downloads the thumbnails that are not cached yet before responding
+constexpr ULONGLONG THUMBNAIL_TIMEOUT_MILLISECONDS = 5000;
+
+// The shell extension key under which file types register their thumbnail providers
+constexpr LPCWSTR THUMBNAIL_PROVIDER_SHELL_EXTENSION = L"{e357fccd-a995-4576-b01f-234630154e96}";
+
+/// Online-only files have no local content to render without hydrating them
+bool HasLocalContent(_In_ const wstring& path)
+{
+    const auto attributes = GetFileAttributes(path.c_str());
+
+    return attributes != INVALID_FILE_ATTRIBUTES
+        && (attributes & (FILE_ATTRIBUTE_RECALL_ON_DATA_ACCESS | FILE_ATTRIBUTE_OFFLINE)) == 0;
+}
+
+/// Renders the thumbnail of the local content with the thumbnail provider of the file type, as the shell would outside the sync root
+HRESULT GetLocalThumbnail(_In_ const wstring& path, _In_ const UINT cx, _Out_ HBITMAP* phbmp, _Out_ WTS_ALPHATYPE* pdwAlpha)
+{
+    const auto extension = PathFindExtension(path.c_str());
+    if (*extension == L'\0')
+    {
+        return E_FAIL;
+    }
+
+    wchar_t classIdString[40] = { 0 };
+    DWORD classIdStringLength = ARRAYSIZE(classIdString);
+    auto result = AssocQueryString(ASSOCF_INIT_DEFAULTTOSTAR, ASSOCSTR_SHELLEXTENSION, extension, THUMBNAIL_PROVIDER_SHELL_EXTENSION, classIdString, &classIdStringLength);
+    if (FAILED(result))
+    {
+        return result;
+    }
+
+    CLSID classId;
+    result = CLSIDFromString(classIdString, &classId);
+    if (FAILED(result))
+    {
+        return result;
+    }
+
+    // Delegating to itself would request the server thumbnail again
+    if (classId == CLSID_ThumbnailProvider)
+    {
+        return E_FAIL;
+    }
+
+    CComPtr<IThumbnailProvider> thumbnailProvider;
+    result = thumbnailProvider.CoCreateInstance(classId, nullptr, CLSCTX_INPROC_SERVER);
+    if (FAILED(result))
+    {
+        return result;
+    }
+
+    // Most providers are initialized with a stream, some only support a path
+    if (CComQIPtr<IInitializeWithStream> initializeWithStream = thumbnailProvider)
+    {
+        CComPtr<IStream> stream;
+        result = SHCreateStreamOnFileEx(path.c_str(), STGM_READ | STGM_SHARE_DENY_NONE, FILE_ATTRIBUTE_NORMAL, FALSE, nullptr, &stream);
+        if (SUCCEEDED(result))
+        {
+            result = initializeWithStream->Initialize(stream, STGM_READ);
+        }
+    }
+    else if (CComQIPtr<IInitializeWithFile> initializeWithFile = thumbnailProvider)
+    {
+        result = initializeWithFile->Initialize(path.c_str(), STGM_READ);
+    }
+    else
+    {
+        result = E_NOINTERFACE;
+    }
+
+    if (FAILED(result))
+    {
+        return result;
+    }
+
+    return thumbnailProvider->GetThumbnail(cx, phbmp, pdwAlpha);
+}
+
+IFACEMETHODIMP CThumbnailProvider::Initialize(IShellItem* psi, DWORD /*grfMode*/)
+{
+    if (!psi)
+    {
+        return E_INVALIDARG;
+    }
+
+    // Only the path is kept, binding to the item stream would hydrate the file
+    CComHeapPtr<WCHAR> path;
+    const auto result = psi->GetDisplayName(SIGDN_FILESYSPATH, &path);
+    if (FAILED(result))
+    {
+        return result;
+    }
+
+    _ATLTRY
+    {
+        m_path = static_cast<LPCWSTR>(path);
+    }
+    _ATLCATCHALL() { return E_OUTOFMEMORY; }
+
+    return S_OK;
+}
+
+IFACEMETHODIMP CThumbnailProvider::GetThumbnail(const UINT cx, HBITMAP* phbmp, WTS_ALPHATYPE* pdwAlpha)
+{
+    if (!phbmp || !pdwAlpha)
+    {
+        return E_INVALIDARG;
+    }
+
+    *phbmp = nullptr;
+    *pdwAlpha = WTSAT_UNKNOWN;
+
+    if (m_path.empty())
+    {
+        return E_UNEXPECTED;
+    }
+
+    _ATLTRY
+    {
+        // The local content is more up to date than the server thumbnail, which is only needed for online-only files
+        if (HasLocalContent(m_path))
+        {
+            return GetLocalThumbnail(m_path, cx, phbmp, pdwAlpha);
+        }
+
+        // Without a thumbnail, the shell shows the icon of the file type instead
+        wstring thumbnailPath;
+        if (!ThumbnailBatcher::GetInstance().TryGetThumbnailPath(m_path, GetTickCount64() + THUMBNAIL_TIMEOUT_MILLISECONDS, thumbnailPath)
+            || thumbnailPath.empty())
+        {
+            return E_FAIL;
+        }
+
+        auto bitmapHandle = LoadScaledBitmap(thumbnailPath.c_str(), cx);
+        if (!bitmapHandle)
+        {
+            return E_FAIL;
+        }
+
+        *phbmp = bitmapHandle.release();
+        *pdwAlpha = WTSAT_ARGB;
+
+        return S_OK;
+    }
+    _ATLCATCH(e) { return e; }
+    _ATLCATCHALL() { return E_FAIL; }
+}
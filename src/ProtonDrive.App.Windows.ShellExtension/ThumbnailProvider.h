@@ -0,0 +1,39 @@
+#pragma once
+
+#include "resource.h"
+#include "pch.h"
+
+#include "WindowsShellExtension_i.h"
+
+/// Thumbnail provider of the sync roots. Renders thumbnails of online-only files the app obtains from the server without
+/// ever reading the file, so that browsing them in thumbnail view does not hydrate them. Files with local content are
+/// rendered by the thumbnail provider of their file type.
+class ATL_NO_VTABLE CThumbnailProvider :
+    public ATL::CComObjectRootEx<ATL::CComSingleThreadModel>,
+    public ATL::CComCoClass<CThumbnailProvider, &CLSID_ThumbnailProvider>,
+    public IInitializeWithItem,
+    public IThumbnailProvider
+{
+public:
+    // IInitializeWithItem
+    IFACEMETHODIMP Initialize(IShellItem* psi, DWORD grfMode) override;
+
+    // IThumbnailProvider
+    IFACEMETHODIMP GetThumbnail(UINT cx, HBITMAP* phbmp, WTS_ALPHATYPE* pdwAlpha) override;
+
+    DECLARE_REGISTRY_RESOURCEID(IDR_THUMBNAILPROVIDER)
+
+    DECLARE_NOT_AGGREGATABLE(CThumbnailProvider)
+
+    BEGIN_COM_MAP(CThumbnailProvider)
+        COM_INTERFACE_ENTRY(IInitializeWithItem)
+        COM_INTERFACE_ENTRY(IThumbnailProvider)
+    END_COM_MAP()
+
+    DECLARE_PROTECT_FINAL_CONSTRUCT()
+
+private:
+    std::wstring m_path;
+};
+
+OBJECT_ENTRY_AUTO(__uuidof(ThumbnailProvider), CThumbnailProvider)
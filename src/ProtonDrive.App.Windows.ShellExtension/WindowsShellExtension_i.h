@@ -60,10 +60,23 @@ typedef struct ContextMenuHandler ContextMenuHandler;
 #endif 	/* __ContextMenuHandler_FWD_DEFINED__ */
 
 
+#ifndef __ThumbnailProvider_FWD_DEFINED__
+#define __ThumbnailProvider_FWD_DEFINED__
+
+#ifdef __cplusplus
+typedef class ThumbnailProvider ThumbnailProvider;
+#else
+typedef struct ThumbnailProvider ThumbnailProvider;
+#endif /* __cplusplus */
+
+#endif 	/* __ThumbnailProvider_FWD_DEFINED__ */
+
+
 /* header files for imported files */
 #include "oaidl.h"
 #include "ocidl.h"
 #include "shobjidl.h"
+#include "thumbcache.h"
 
 #ifdef __cplusplus
 extern "C"{
@@ -87,6 +100,14 @@ EXTERN_C const CLSID CLSID_ContextMenuHandler;
 class DECLSPEC_UUID("434CAC7A-CB48-4832-8F85-83ADE7E52DAC")
 ContextMenuHandler;
 #endif
+
+EXTERN_C const CLSID CLSID_ThumbnailProvider;
+
+#ifdef __cplusplus
+
+class DECLSPEC_UUID("0515DDC2-0227-433A-A324-B8DBC012622B")
+ThumbnailProvider;
+#endif
 #endif /* __WindowsShellExtensionLib_LIBRARY_DEFINED__ */
 
 /* Additional Prototypes for ALL interfaces */
@@ -0,0 +1,32 @@
+#include "pch.h"
+#include "checksum.h"
+
+using namespace std;
+
+uint32_t GetFnv1aHash(_In_ const string_view bytes)
+{
+    uint32_t hash = 2166136261U;
+    for (const auto character : bytes)
+    {
+        hash ^= static_cast<uint8_t>(character);
+        hash *= 16777619U;
+    }
+
+    return hash;
+}
+
+string ConvertToHexadecimal(_In_ const span<const byte> bytes)
+{
+    static constexpr char Digits[] = "0123456789abcdef";
+
+    string result;
+    result.reserve(bytes.size() * 2);
+
+    for (const auto value : bytes)
+    {
+        result.push_back(Digits[to_integer<unsigned int>(value) >> 4]);
+        result.push_back(Digits[to_integer<unsigned int>(value) & 0xF]);
+    }
+
+    return result;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "pch.h"
+
+/// FNV-1a hash of the bytes, the checksum of command ring messages and move journal records.
+/// The app computes the same hash to validate them.
+[[nodiscard]] uint32_t GetFnv1aHash(_In_ std::string_view bytes);
+
+/// Lower-case hexadecimal representation of the bytes, as content hashes are exchanged with the app
+[[nodiscard]] std::string ConvertToHexadecimal(_In_ std::span<const std::byte> bytes);
@@ -48,3 +48,75 @@ SharedBitmapHandle ConvertIconToBitmap(_In_ HICON iconHandle, _In_ const int wid
 
     return bitmapHandle;
 }
+
+BitmapHandle LoadScaledBitmap(_In_ LPCWSTR path, _In_ const UINT maximumSize)
+{
+    ATL::CComPtr<IWICImagingFactory> factory;
+    if (FAILED(factory.CoCreateInstance(CLSID_WICImagingFactory)))
+    {
+        return nullptr;
+    }
+
+    ATL::CComPtr<IWICBitmapDecoder> decoder;
+    if (FAILED(factory->CreateDecoderFromFilename(path, nullptr, GENERIC_READ, WICDecodeMetadataCacheOnDemand, &decoder)))
+    {
+        return nullptr;
+    }
+
+    ATL::CComPtr<IWICBitmapFrameDecode> frame;
+    UINT width = 0;
+    UINT height = 0;
+    if (FAILED(decoder->GetFrame(0, &frame)) || FAILED(frame->GetSize(&width, &height)) || width == 0 || height == 0)
+    {
+        return nullptr;
+    }
+
+    ATL::CComPtr<IWICBitmapSource> source = frame;
+
+    if (width > maximumSize || height > maximumSize)
+    {
+        const auto scale = static_cast<double>(maximumSize) / static_cast<double>((std::max)(width, height));
+        width = (std::max)(1U, static_cast<UINT>(width * scale));
+        height = (std::max)(1U, static_cast<UINT>(height * scale));
+
+        ATL::CComPtr<IWICBitmapScaler> scaler;
+        if (FAILED(factory->CreateBitmapScaler(&scaler)) || FAILED(scaler->Initialize(source, width, height, WICBitmapInterpolationModeFant)))
+        {
+            return nullptr;
+        }
+
+        source = scaler;
+    }
+
+    ATL::CComPtr<IWICFormatConverter> converter;
+    if (FAILED(factory->CreateFormatConverter(&converter))
+        || FAILED(converter->Initialize(source, GUID_WICPixelFormat32bppPBGRA, WICBitmapDitherTypeNone, nullptr, 0, WICBitmapPaletteTypeCustom)))
+    {
+        return nullptr;
+    }
+
+    BITMAPINFO bitmapInfo;
+    ZeroMemory(&bitmapInfo, sizeof(BITMAPINFO));
+
+    bitmapInfo.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bitmapInfo.bmiHeader.biWidth = static_cast<LONG>(width);
+    bitmapInfo.bmiHeader.biHeight = -static_cast<LONG>(height);
+    bitmapInfo.bmiHeader.biPlanes = 1;
+    bitmapInfo.bmiHeader.biBitCount = 32;
+    bitmapInfo.bmiHeader.biCompression = BI_RGB;
+
+    void* bitsPointer;
+    auto bitmapHandle = static_cast<BitmapHandle>(CreateDIBSection(nullptr, &bitmapInfo, DIB_RGB_COLORS, &bitsPointer, nullptr, 0));
+    if (!bitmapHandle)
+    {
+        return nullptr;
+    }
+
+    const auto stride = width * 4;
+    if (FAILED(converter->CopyPixels(nullptr, stride, stride * height, static_cast<BYTE*>(bitsPointer))))
+    {
+        return nullptr;
+    }
+
+    return bitmapHandle;
+}
@@ -3,3 +3,6 @@
 #include "pch.h"
 
 SharedBitmapHandle ConvertIconToBitmap(_In_ HICON iconHandle, _In_ int width, _In_ int height);
+
+/// Decodes the image file into a top-down 32-bit premultiplied BGRA bitmap, scaled down to fit a square of the given size
+BitmapHandle LoadScaledBitmap(_In_ LPCWSTR path, _In_ UINT maximumSize);
@@ -3,33 +3,34 @@
 
 // Template implementations have to go in the header file
 
-_Success_(return == true) bool TryOpenPipe(_Out_ ATL::CHandle& handle)
+_Success_(return == true) bool TryOpenPipe(_Out_ ATL::CHandle& handle, _In_ const DWORD flagsAndAttributes)
 {
-    auto pipeHandle = CreateFile(PIPE_NAME, GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0, nullptr);
-
-    if (pipeHandle == INVALID_HANDLE_VALUE)
+    for (auto attempt = 1; ; ++attempt)
     {
-        const auto lastError = GetLastError();
-        if (lastError != ERROR_PIPE_BUSY)
+        const auto pipeHandle = CreateFile(PIPE_NAME, GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, flagsAndAttributes, nullptr);
+
+        if (pipeHandle != INVALID_HANDLE_VALUE)
         {
-            return false;
+            handle.Attach(pipeHandle);
+            return true;
         }
 
-        if (!WaitNamedPipe(PIPE_NAME, PIPE_WAIT_MILLISECONDS))
+        // All listening instances are taken, another client might win the race for the freed one
+        if (GetLastError() != ERROR_PIPE_BUSY || attempt >= PIPE_CONNECT_ATTEMPTS)
         {
             return false;
         }
 
-        pipeHandle = CreateFile(PIPE_NAME, GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0, nullptr);
-    }
-
-    if (pipeHandle == INVALID_HANDLE_VALUE)
-    {
-        return false;
+        if (!WaitNamedPipe(PIPE_NAME, PIPE_WAIT_MILLISECONDS) && GetLastError() != ERROR_SEM_TIMEOUT)
+        {
+            return false;
+        }
     }
+}
 
-    auto safePipeHandle = ATL::CHandle(pipeHandle);
-    handle = safePipeHandle;
-
-    return true;
+_Success_(return == true) bool TryWritePipeMessage(_In_ HANDLE pipeHandle, _In_ const std::string& message)
+{
+    DWORD numberOfBytesWritten;
+    return WriteFile(pipeHandle, message.c_str(), static_cast<DWORD>(message.size()), &numberOfBytesWritten, nullptr)
+        && numberOfBytesWritten == message.size();
 }
@@ -3,11 +3,15 @@
 #include "pch.h"
 #include "unicode.h"
 
+#include "AllocationAccounting.h"
+#include "CommandRing.h"
 #include "IpcMessage.h"
+#include "IpcResponseDecoder.h"
 
 constexpr auto PIPE_NAME = L"\\\\.\\pipe\\ProtonDrive";
 constexpr int RESPONSE_BUFFER_SIZE = 1 << 10;
 constexpr auto PIPE_WAIT_MILLISECONDS = 50;
+constexpr auto PIPE_CONNECT_ATTEMPTS = 3;
 
 template <>
 struct nlohmann::adl_serializer<std::wstring> {
@@ -15,9 +19,11 @@ struct nlohmann::adl_serializer<std::wstring> {
         j = ConvertUtf16ToUtf8(utf16String.c_str());
     }
 
-    static void from_json(const json& j, std::wstring& utf8String) {
-        const auto utf8Str = j.get<std::string>();
-        utf8String = ConvertUtf8ToUtf16(utf8Str.c_str());
+    static void from_json(const json& j, std::wstring& utf16String) {
+        if (!TryConvertUtf8ToUtf16(j.get_ref<const std::string&>(), utf16String))
+        {
+            throw std::invalid_argument("String is not valid UTF-8");
+        }
     }
 };
 
@@ -26,10 +32,50 @@ void to_json(nlohmann::json& j, const IpcMessage<TParameters>& request) {
     j = nlohmann::json{ {"type", request.type}, {"parameters", request.parameters} };
 }
 
-_Success_(return == true) bool TryOpenPipe(_Out_ ATL::CHandle& handle);
+_Success_(return == true) bool TryOpenPipe(_Out_ ATL::CHandle& handle, _In_ DWORD flagsAndAttributes = 0);
+_Success_(return == true) bool TryWritePipeMessage(_In_ HANDLE pipeHandle, _In_ const std::string& message);
+
+/// Reads the rest of the current message from the pipe, after the first messageLength bytes that were already read.
+template <typename TString>
+_Success_(return == true) bool TryReadPipeMessage(_In_ HANDLE pipeHandle, _Inout_ TString& message, _In_ size_t messageLength = 0)
+{
+    if (message.size() <= messageLength)
+    {
+        message.resize(messageLength + RESPONSE_BUFFER_SIZE);
+    }
+
+    while (true)
+    {
+        DWORD numberOfBytesRead = 0;
+        const auto succeeded = ReadFile(
+            pipeHandle,
+            message.data() + messageLength,
+            static_cast<DWORD>(message.size() - messageLength),
+            &numberOfBytesRead,
+            nullptr);
+
+        messageLength += numberOfBytesRead;
+
+        if (succeeded)
+        {
+            message.resize(messageLength);
+            return messageLength > 0;
+        }
+
+        if (GetLastError() != ERROR_MORE_DATA || message.size() >= MAXIMUM_RESPONSE_SIZE)
+        {
+            return false;
+        }
+
+        message.resize((std::min)(message.size() * 2, MAXIMUM_RESPONSE_SIZE));
+    }
+}
 
 template <typename TParameters, typename TResponse>
-_Success_(return == true) bool TrySendIpcMessage(_In_ const IpcMessage<TParameters>& message, _Out_ TResponse& response)
+_Success_(return == true) bool TrySendIpcMessage(
+    _In_ const IpcMessage<TParameters>& message,
+    _Out_ TResponse& response,
+    _In_ std::pmr::memory_resource* memoryResource = AllocationAccounting::GetInstance().GetResource(AllocationSubsystem::Ipc))
 {
     ATL::CHandle pipeHandle;
     if (!TryOpenPipe(pipeHandle))
@@ -47,9 +93,9 @@ _Success_(return == true) bool TrySendIpcMessage(_In_ const IpcMessage<TParamete
 
     const auto messageString = messageJsonObject.dump();
 
-    std::string responseString(RESPONSE_BUFFER_SIZE, 0);
+    std::pmr::string responseString(RESPONSE_BUFFER_SIZE, 0, memoryResource);
 
-    DWORD numberOfBytesRead;
+    DWORD numberOfBytesRead = 0;
 
     if (!TransactNamedPipe(
         pipeHandle,
@@ -60,19 +106,38 @@ _Success_(return == true) bool TrySendIpcMessage(_In_ const IpcMessage<TParamete
         &numberOfBytesRead,
         nullptr))
     {
-        ATL::AtlThrowLastWin32();
+        if (GetLastError() != ERROR_MORE_DATA)
+        {
+            ATL::AtlThrowLastWin32();
+        }
+
+        // Large responses arrive in several reads, oversized ones are rejected before decoding
+        if (!TryReadPipeMessage(pipeHandle, responseString, numberOfBytesRead))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        responseString.resize(numberOfBytesRead);
     }
 
-    const auto parsedResponse = nlohmann::json::parse(responseString);
-
-    response = parsedResponse.get<TResponse>();
-
-    return true;
+    return TryDecodeIpcResponse(responseString, response);
 }
 
 template <typename TMessage>
 bool TrySendIpcMessage(_In_ const TMessage& message)
 {
+    const nlohmann::json messageJsonObject = message;
+
+    const auto messageString = messageJsonObject.dump();
+
+    // Posting to the shared ring does not wait for the app, the pipe is the fallback when the ring is unavailable
+    if (TryPostCommand(messageString))
+    {
+        return true;
+    }
+
     ATL::CHandle pipeHandle;
     if (!TryOpenPipe(pipeHandle))
     {
@@ -85,11 +150,6 @@ bool TrySendIpcMessage(_In_ const TMessage& message)
         ATL::AtlThrowLastWin32();
     }
 
-    const nlohmann::json messageJsonObject = message;
-
-    const auto messageString = messageJsonObject.dump();
-    std::string responseString(RESPONSE_BUFFER_SIZE, 0);
-
     DWORD numberOfBytesWritten;
     if (!WriteFile(pipeHandle, messageString.c_str(), static_cast<DWORD>(messageString.size()), &numberOfBytesWritten, nullptr))
     {
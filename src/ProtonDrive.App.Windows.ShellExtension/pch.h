@@ -13,6 +13,9 @@
 #include <atlstr.h>
 #include <ShlObj.h>
 #include <Shobjidl.h>
+#include <thumbcache.h>
+#include <wincodec.h>
+#include <CommCtrl.h>
 #include <comdef.h>
 
 #include <optional>
@@ -22,7 +25,23 @@
 #include <sstream>
 #include <vector>
 #include <ranges>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <functional>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <deque>
+#include <condition_variable>
+#include <coroutine>
+#include <memory_resource>
+#include <array>
+#include <span>
+#include <bit>
 #include <strsafe.h>
+#include <psapi.h>
+#include <bcrypt.h>
 
 #include <nlohmann/json.hpp>
 #include <nameof.hpp>
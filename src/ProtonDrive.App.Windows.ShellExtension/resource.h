@@ -9,15 +9,30 @@
 #define IDS_MOVE_TO_DRIVE_MENU_ITEM_HEADER 103
 #define IDS_MOVE_TO_DRIVE_DESCRIPTION   104
 #define IDR_CONTEXTMENUHANDLER          106
+#define IDS_KEEP_ON_DEVICE_MENU_ITEM_HEADER 107
+#define IDS_KEEP_ON_DEVICE_DESCRIPTION  108
+#define IDS_FREE_UP_SPACE_MENU_ITEM_HEADER 109
+#define IDS_FREE_UP_SPACE_DESCRIPTION   110
+#define IDS_MOVE_CONFLICT_TITLE         111
+#define IDS_MOVE_CONFLICT_INSTRUCTION   112
+#define IDS_MOVE_CONFLICT_CONTENT       113
+#define IDS_MOVE_CONFLICT_REPLACE       114
+#define IDS_MOVE_CONFLICT_KEEP_BOTH     115
+#define IDS_MOVE_CONFLICT_SKIP          116
+#define IDS_MOVE_DUPLICATE_INSTRUCTION  117
+#define IDS_MOVE_DUPLICATE_CONTENT      118
+#define IDS_MOVE_DUPLICATE_SKIP         119
+#define IDS_MOVE_DUPLICATE_MOVE         120
 #define IDI_ICON                        201
+#define IDR_THUMBNAILPROVIDER           202
 
 // Next default values for new objects
 // 
 #ifdef APSTUDIO_INVOKED
 #ifndef APSTUDIO_READONLY_SYMBOLS
-#define _APS_NEXT_RESOURCE_VALUE        202
+#define _APS_NEXT_RESOURCE_VALUE        203
 #define _APS_NEXT_COMMAND_VALUE         32768
 #define _APS_NEXT_CONTROL_VALUE         201
-#define _APS_NEXT_SYMED_VALUE           107
+#define _APS_NEXT_SYMED_VALUE           121
 #endif
 #endif
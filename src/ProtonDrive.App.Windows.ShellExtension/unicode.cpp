@@ -20,14 +20,28 @@ string ConvertUtf16ToUtf8(_In_ const LPCWSTR utf16String)
 
 wstring ConvertUtf8ToUtf16(_In_ const LPCSTR utf8String)
 {
-    const auto stringLength = MultiByteToWideChar(CP_UTF8, 0, utf8String, -1, nullptr, 0);
-    if (stringLength == 0)
+    wstring result;
+    TryConvertUtf8ToUtf16(utf8String, result);
+    return result;
+}
+
+_Success_(return == true) bool TryConvertUtf8ToUtf16(_In_ const string_view utf8String, _Out_ wstring& utf16String)
+{
+    utf16String.clear();
+
+    const auto utf8Length = static_cast<int>(utf8String.size());
+    if (utf8Length == 0)
     {
-        return {};
+        return true;
     }
 
-    wstring result(stringLength, 0);
+    // The result does not include a terminating null character, as the input length is explicit
+    const auto resultSize = MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, utf8String.data(), utf8Length, nullptr, 0);
+    if (resultSize == 0)
+    {
+        return false;
+    }
 
-    MultiByteToWideChar(CP_UTF8, 0, utf8String, -1, &result[0], stringLength);
-    return result;
+    utf16String.resize(resultSize);
+    return MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, utf8String.data(), utf8Length, utf16String.data(), resultSize) == resultSize;
 }
@@ -3,4 +3,5 @@
 #include "pch.h"
 
 std::string ConvertUtf16ToUtf8(_In_ LPCWSTR utf16String);
-std::wstring ConvertUtf8ToUtf16(_In_ LPCSTR utf8String);
\ No newline at end of file
+std::wstring ConvertUtf8ToUtf16(_In_ LPCSTR utf8String);
+_Success_(return == true) bool TryConvertUtf8ToUtf16(_In_ std::string_view utf8String, _Out_ std::wstring& utf16String);
\ No newline at end of file
@@ -85,6 +85,9 @@ internal static class AppServices
             .AddSingleton<ILocalVolumeInfoProvider, VolumeInfoProvider>()
             .AddSingleton<ILocalFolderService, LocalFolderService>()
             .AddSingleton<IPlaceholderToRegularItemConverter, PlaceholderToRegularItemConverter>()
+            .AddSingleton<IPlaceholderHydrationScheduler, PlaceholderHydrationScheduler>()
+            .AddSingleton<IContentDuplicateFinder, ContentDuplicateFinder>()
+            .AddSingleton<IStartableService, MoveJournalResumer>()
             .AddSingleton<INonSyncablePathProvider, NonSyncablePathProvider>()
             .AddSingleton<INotificationService, SystemToastNotificationService>()
             .AddSingleton<IUrlOpener, UrlOpener>()
@@ -183,6 +186,9 @@ internal static class AppServices
                     provider.GetRequiredService<ILogger<NamedPipeBasedIpcServer>>()))
             .AddSingleton<IStartableService>(provider => provider.GetRequiredService<NamedPipeBasedIpcServer>())
             .AddSingleton<IStoppableService>(provider => provider.GetRequiredService<NamedPipeBasedIpcServer>())
+            .AddSingleton<CommandRingIpcServer>()
+            .AddSingleton<IStartableService>(provider => provider.GetRequiredService<CommandRingIpcServer>())
+            .AddSingleton<IStoppableService>(provider => provider.GetRequiredService<CommandRingIpcServer>())
 
             .AddSingleton<IThumbnailGenerator, Win32ThumbnailGenerator>()
             .AddSingleton<IFileSystemClient<long>>(provider => new ClassicFileSystemClient(provider.GetRequiredService<IThumbnailGenerator>()))
@@ -0,0 +1,368 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO.MemoryMappedFiles;
+using System.Linq;
+using System.Text.Json;
+using System.Threading;
+using System.Threading.Tasks;
+using Microsoft.Extensions.Logging;
+using ProtonDrive.App.InterProcessCommunication;
+using ProtonDrive.App.Services;
+using ProtonDrive.Shared.Extensions;
+using ProtonDrive.Shared.Threading;
+
+namespace ProtonDrive.App.Windows.InterProcessCommunication;
+
+/// <summary>
+/// Drains fire-and-forget IPC messages that shell extension instances post to a shared memory ring,
+/// without each of them having to connect to the named pipe.
+/// </summary>
+/// <remarks>
+/// The layout of the section must match the one declared in CommandRing.h of the shell extension.
+/// The ring is multi-producer, single-consumer: producers claim a position by incrementing the enqueue position,
+/// write the message into the slot and publish it by advancing the slot sequence. The slot at position p is free
+/// when its sequence equals p, holds a complete message when it equals p + 1, and is freed by setting p + number of slots.
+/// </remarks>
+internal sealed unsafe class CommandRingIpcServer : IStartableService, IStoppableService, IDisposable
+{
+    public const string SectionName = @"Local\ProtonDrive.CommandRing";
+    public const string EventName = @"Local\ProtonDrive.CommandRing.Posted";
+
+    private const uint Signature = 0x52434450; // "PDCR"
+    private const uint Version = 1;
+    private const int HeaderSize = 256;
+    private const int NumberOfSlots = 256;
+    private const int SlotSize = 4096;
+    private const int SlotHeaderSize = 16;
+    private const int MaximumMessageSize = SlotSize - SlotHeaderSize;
+    private const int SectionSize = HeaderSize + (NumberOfSlots * SlotSize);
+
+    private const int EnqueuePositionOffset = 64;
+    private const int DequeuePositionOffset = 128;
+    private const int NumberOfOverflowsOffset = 136;
+
+    private const int MaximumBatchSize = 64;
+
+    private static readonly TimeSpan PollingInterval = TimeSpan.FromSeconds(1);
+
+    // A producer holds a claimed slot only for the time of copying a message, a longer stall means it died mid-write
+    private static readonly TimeSpan AbandonmentTimeout = TimeSpan.FromSeconds(2);
+
+    private static readonly JsonSerializerOptions JsonSerializerOptions = new()
+    {
+        PropertyNamingPolicy = JsonNamingPolicy.CamelCase,
+    };
+
+    private readonly Lazy<Dictionary<string, IIpcMessageHandler>> _messageHandlers;
+    private readonly ILogger<CommandRingIpcServer> _logger;
+
+    private readonly CancellationTokenSource _cancellationTokenSource = new();
+
+    private MemoryMappedFile? _section;
+    private MemoryMappedViewAccessor? _view;
+    private EventWaitHandle? _postedEvent;
+    private byte* _basePointer;
+    private Task? _drainingTask;
+
+    private long _dequeuePosition;
+    private long _stalledSince;
+    private long _lastReportedNumberOfOverflows;
+
+    public CommandRingIpcServer(Lazy<IEnumerable<IIpcMessageHandler>> messageHandlers, ILogger<CommandRingIpcServer> logger)
+    {
+        _messageHandlers = new Lazy<Dictionary<string, IIpcMessageHandler>>(() => messageHandlers.Value.ToDictionary(x => x.MessageType));
+        _logger = logger;
+    }
+
+    private ref long EnqueuePosition => ref *(long*)(_basePointer + EnqueuePositionOffset);
+    private ref long DequeuePosition => ref *(long*)(_basePointer + DequeuePositionOffset);
+    private ref long NumberOfOverflows => ref *(long*)(_basePointer + NumberOfOverflowsOffset);
+
+    public Task StartAsync(CancellationToken cancellationToken)
+    {
+        if (_drainingTask is not null)
+        {
+            throw new InvalidOperationException();
+        }
+
+        try
+        {
+            _section = MemoryMappedFile.CreateNew(SectionName, SectionSize, MemoryMappedFileAccess.ReadWrite);
+            _view = _section.CreateViewAccessor(0, SectionSize, MemoryMappedFileAccess.ReadWrite);
+            _view.SafeMemoryMappedViewHandle.AcquirePointer(ref _basePointer);
+            _postedEvent = new EventWaitHandle(false, EventResetMode.AutoReset, EventName);
+        }
+        catch (Exception ex) when (ex.IsFileAccessException())
+        {
+            // The shell extension falls back to the named pipe
+            _logger.LogWarning("Failed to create IPC command ring: {ExceptionType}: {ErrorCode}", ex.GetType().Name, ex.GetRelevantFormattedErrorCode());
+            Dispose();
+            return Task.CompletedTask;
+        }
+
+        InitializeSection();
+
+        _drainingTask = Task.Factory.StartNew(
+            () => Drain(_cancellationTokenSource.Token),
+            _cancellationTokenSource.Token,
+            TaskCreationOptions.LongRunning,
+            TaskScheduler.Default);
+
+        return Task.CompletedTask;
+    }
+
+    public async Task StopAsync(CancellationToken cancellationToken)
+    {
+        if (_drainingTask is null)
+        {
+            return;
+        }
+
+        await _cancellationTokenSource.CancelAsync().ConfigureAwait(false);
+
+        try
+        {
+            await _drainingTask.ConfigureAwait(false);
+        }
+        catch (OperationCanceledException)
+        {
+            // Ignore
+        }
+        catch (Exception ex)
+        {
+            _logger.LogError(ex, "An unexpected exception occurred while stopping the IPC command ring.");
+        }
+
+        _drainingTask = null;
+
+        Dispose();
+    }
+
+    public void Dispose()
+    {
+        if (_basePointer is not null)
+        {
+            _view?.SafeMemoryMappedViewHandle.ReleasePointer();
+            _basePointer = null;
+        }
+
+        _view?.Dispose();
+        _view = null;
+        _section?.Dispose();
+        _section = null;
+        _postedEvent?.Dispose();
+        _postedEvent = null;
+    }
+
+    private void InitializeSection()
+    {
+        var header = (uint*)_basePointer;
+
+        for (var position = 0L; position < NumberOfSlots; ++position)
+        {
+            GetSlotSequence(position) = position;
+        }
+
+        header[1] = Version;
+        header[2] = NumberOfSlots;
+        header[3] = SlotSize;
+
+        // Producers check the signature before using the ring, so it is written last
+        Volatile.Write(ref header[0], Signature);
+    }
+
+    private void Drain(CancellationToken cancellationToken)
+    {
+        var waitHandles = new[] { _postedEvent!, cancellationToken.WaitHandle };
+        var batch = new List<IpcMessage>(MaximumBatchSize);
+
+        while (!cancellationToken.IsCancellationRequested)
+        {
+            // The ring is also drained periodically, in case a producer failed to signal the event
+            WaitHandle.WaitAny(waitHandles, PollingInterval);
+
+            do
+            {
+                batch.Clear();
+                DequeueBatch(batch);
+
+                foreach (var message in batch)
+                {
+                    HandleMessageAsync(message, cancellationToken).Forget();
+                }
+            }
+            while (batch.Count == MaximumBatchSize && !cancellationToken.IsCancellationRequested);
+
+            ReportOverflows();
+        }
+    }
+
+    private void DequeueBatch(List<IpcMessage> batch)
+    {
+        while (batch.Count < MaximumBatchSize)
+        {
+            var position = _dequeuePosition;
+            ref var sequence = ref GetSlotSequence(position);
+            var currentSequence = Volatile.Read(ref sequence);
+
+            if (currentSequence == position + 1)
+            {
+                if (TryReadMessage(position, out var message))
+                {
+                    batch.Add(message);
+                }
+
+                FreeSlot(ref sequence, position);
+                continue;
+            }
+
+            if (currentSequence != position || Volatile.Read(ref EnqueuePosition) <= position)
+            {
+                // The ring is empty
+                _stalledSince = 0;
+                break;
+            }
+
+            // A producer has claimed the slot but not published it yet
+            var now = Stopwatch.GetTimestamp();
+            if (_stalledSince == 0)
+            {
+                _stalledSince = now;
+                break;
+            }
+
+            if (Stopwatch.GetElapsedTime(_stalledSince, now) < AbandonmentTimeout)
+            {
+                break;
+            }
+
+            if (Interlocked.CompareExchange(ref sequence, position + NumberOfSlots, position) != position)
+            {
+                // The producer has published the message in the meantime
+                continue;
+            }
+
+            _logger.LogWarning("IPC: Abandoned command ring slot at position {Position} claimed by an unresponsive producer", position);
+
+            _dequeuePosition = position + 1;
+            Volatile.Write(ref DequeuePosition, _dequeuePosition);
+            _stalledSince = 0;
+        }
+    }
+
+    private bool TryReadMessage(long position, out IpcMessage message)
+    {
+        message = default!;
+
+        var slot = GetSlot(position);
+        var length = *(uint*)(slot + 8);
+        var checksum = *(uint*)(slot + 12);
+
+        if (length > MaximumMessageSize)
+        {
+            _logger.LogWarning("IPC: Command ring slot at position {Position} has invalid length", position);
+            return false;
+        }
+
+        var payload = new ReadOnlySpan<byte>(slot + SlotHeaderSize, (int)length);
+
+        // A producer that was too slow to publish before its slot got abandoned might have overwritten the message
+        if (payload.GetFnv1aHash() != checksum)
+        {
+            _logger.LogWarning("IPC: Command ring slot at position {Position} has invalid checksum", position);
+            return false;
+        }
+
+        try
+        {
+            var deserializedMessage = JsonSerializer.Deserialize<IpcMessage>(payload, JsonSerializerOptions);
+            if (deserializedMessage is null)
+            {
+                return false;
+            }
+
+            message = deserializedMessage;
+            return true;
+        }
+        catch (JsonException)
+        {
+            _logger.LogWarning("IPC: Command ring slot at position {Position} contains malformed message", position);
+            return false;
+        }
+    }
+
+    private async Task HandleMessageAsync(IpcMessage message, CancellationToken cancellationToken)
+    {
+        // Leave the draining thread as soon as possible
+        await Task.Yield();
+
+        _logger.LogDebug("IPC: Received message of type {Type} through command ring, Parameters=\"{Parameters}\"", message.Type, message.Parameters);
+
+        if (message.Type is null)
+        {
+            _logger.LogWarning("IPC: Received message has no type specified");
+            return;
+        }
+
+        if (!_messageHandlers.Value.TryGetValue(message.Type, out var messageHandler))
+        {
+            _logger.LogWarning("IPC: Received message of type {Type} has no dispatcher", message.Type);
+            return;
+        }
+
+        try
+        {
+            await messageHandler.HandleAsync(message.Parameters, default(DiscardingIpcResponder), cancellationToken).ConfigureAwait(false);
+        }
+        catch (Exception e)
+        {
+            _logger.LogError(e, "IPC: Exception occurred on handler for message type {Type}", message.Type);
+        }
+    }
+
+    private void FreeSlot(ref long sequence, long position)
+    {
+        Volatile.Write(ref sequence, position + NumberOfSlots);
+
+        _dequeuePosition = position + 1;
+        Volatile.Write(ref DequeuePosition, _dequeuePosition);
+        _stalledSince = 0;
+    }
+
+    private void ReportOverflows()
+    {
+        var numberOfOverflows = Volatile.Read(ref NumberOfOverflows);
+        if (numberOfOverflows == _lastReportedNumberOfOverflows)
+        {
+            return;
+        }
+
+        _logger.LogWarning(
+            "IPC: Command ring overflowed {Count} times, producers fell back to the named pipe",
+            numberOfOverflows - _lastReportedNumberOfOverflows);
+
+        _lastReportedNumberOfOverflows = numberOfOverflows;
+    }
+
+    private byte* GetSlot(long position)
+    {
+        return _basePointer + HeaderSize + ((position & (NumberOfSlots - 1)) * SlotSize);
+    }
+
+    private ref long GetSlotSequence(long position)
+    {
+        return ref *(long*)GetSlot(position);
+    }
+
+    /// <summary>
+    /// Producers posting to the ring do not wait for a response
+    /// </summary>
+    private readonly struct DiscardingIpcResponder : IIpcResponder
+    {
+        public Task Respond<T>(T value, CancellationToken cancellationToken)
+        {
+            return Task.CompletedTask;
+        }
+    }
+}
@@ -9,6 +9,7 @@ using Microsoft.Extensions.Logging;
 using ProtonDrive.App.InterProcessCommunication;
 using ProtonDrive.App.Services;
 using ProtonDrive.Shared.Extensions;
+using ProtonDrive.Shared.Text.Serialization;
 using ProtonDrive.Shared.Threading;
 
 namespace ProtonDrive.App.Windows.InterProcessCommunication;
@@ -17,9 +18,14 @@ internal sealed partial class NamedPipeBasedIpcServer : IStartableService, IStop
 {
     public const string PipeName = "ProtonDrive";
 
+    // Every Explorer window and file dialog hosting the shell extension connects independently,
+    // keeping several instances listening avoids ERROR_PIPE_BUSY on clients connecting at the same time.
+    private const int NumberOfListeners = 4;
+
     private static readonly JsonSerializerOptions JsonSerializerOptions = new()
     {
         PropertyNamingPolicy = JsonNamingPolicy.CamelCase,
+        Converters = { new FrontCodedStringListJsonConverter() },
     };
 
     private readonly string _name;
@@ -29,6 +35,11 @@ internal sealed partial class NamedPipeBasedIpcServer : IStartableService, IStop
     private readonly CancellationTokenSource _pipeCancellationTokenSource = new();
     private Task? _listeningTask;
 
+    private long _numberOfConnections;
+    private long _numberOfActiveConnections;
+    private long _maximumNumberOfActiveConnections;
+    private long _numberOfFailedMessages;
+
     public NamedPipeBasedIpcServer(string name, Lazy<IEnumerable<IIpcMessageHandler>> messageHandlers, ILogger<NamedPipeBasedIpcServer> logger)
     {
         _name = name;
@@ -43,7 +54,7 @@ internal sealed partial class NamedPipeBasedIpcServer : IStartableService, IStop
             throw new InvalidOperationException();
         }
 
-        _listeningTask = RunAsync(_pipeCancellationTokenSource.Token);
+        _listeningTask = Task.WhenAll(Enumerable.Range(0, NumberOfListeners).Select(_ => RunAsync(_pipeCancellationTokenSource.Token)));
 
         return Task.CompletedTask;
     }
@@ -67,6 +78,27 @@ internal sealed partial class NamedPipeBasedIpcServer : IStartableService, IStop
         }
 
         _listeningTask = null;
+
+        _logger.LogInformation(
+            "IPC server handled {NumberOfConnections} connections, at most {MaximumNumberOfActiveConnections} at once, {NumberOfFailedMessages} failed",
+            Interlocked.Read(ref _numberOfConnections),
+            Interlocked.Read(ref _maximumNumberOfActiveConnections),
+            Interlocked.Read(ref _numberOfFailedMessages));
+    }
+
+    private static void UpdateMaximum(ref long maximum, long value)
+    {
+        var currentMaximum = Interlocked.Read(ref maximum);
+        while (value > currentMaximum)
+        {
+            var previousMaximum = Interlocked.CompareExchange(ref maximum, value, currentMaximum);
+            if (previousMaximum == currentMaximum)
+            {
+                return;
+            }
+
+            currentMaximum = previousMaximum;
+        }
     }
 
     private async Task RunAsync(CancellationToken cancellationToken)
@@ -121,6 +153,10 @@ internal sealed partial class NamedPipeBasedIpcServer : IStartableService, IStop
             return;
         }
 
+        Interlocked.Increment(ref _numberOfConnections);
+        var numberOfActiveConnections = Interlocked.Increment(ref _numberOfActiveConnections);
+        UpdateMaximum(ref _maximumNumberOfActiveConnections, numberOfActiveConnections);
+
         ProcessMessageAsync(serverStream, cancellationToken).Forget();
     }
 
@@ -160,11 +196,13 @@ internal sealed partial class NamedPipeBasedIpcServer : IStartableService, IStop
             }
             catch (Exception e)
             {
+                Interlocked.Increment(ref _numberOfFailedMessages);
                 _logger.LogError(e, "IPC: Exception occurred on handler for message type {Type}", message.Type);
             }
         }
         finally
         {
+            Interlocked.Decrement(ref _numberOfActiveConnections);
             await serverStream.DisposeAsync().ConfigureAwait(false);
         }
     }
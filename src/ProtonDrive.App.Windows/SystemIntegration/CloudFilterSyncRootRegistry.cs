@@ -27,6 +27,10 @@ internal class CloudFilterSyncRootRegistry : IOnDemandSyncRootRegistry, ISession
     private const string SyncRootManagerKeyName = @"Software\Microsoft\Windows\CurrentVersion\Explorer\SyncRootManager";
     private const string DesktopNameSpaceKeyName = @"Software\Microsoft\Windows\CurrentVersion\Explorer\Desktop\NameSpace";
     private const string NamespaceClassIdValueName = "NamespaceCLSID";
+    private const string ThumbnailProviderValueName = "ThumbnailProvider";
+
+    // Thumbnail provider of the shell extension, which never hydrates placeholders
+    private const string ThumbnailProviderClassId = "{0515DDC2-0227-433A-A324-B8DBC012622B}";
     private static readonly Guid ProviderId = Guid.Parse("{87C55815-A77B-4E44-A871-182F19499B54}");
 
     private readonly AppConfig _appConfig;
@@ -166,6 +170,8 @@ internal class CloudFilterSyncRootRegistry : IOnDemandSyncRootRegistry, ISession
 
             AdjustVisibility(rootId, shellFolderVisibility);
 
+            RegisterThumbnailProvider(rootId);
+
             SetInSync(path);
 
             _logger.LogInformation("On-demand sync root \"{RootId}\" registered", rootId);
@@ -231,6 +237,24 @@ internal class CloudFilterSyncRootRegistry : IOnDemandSyncRootRegistry, ISession
         }
     }
 
+    private void RegisterThumbnailProvider(string rootId)
+    {
+        /* Without a thumbnail provider registered for the sync root, the shell renders thumbnails of
+         * placeholders with the default handlers, which read the file content and so hydrate them.
+         */
+        try
+        {
+            var syncRootKey = Registry.LocalMachine.OpenSubKey($"{SyncRootManagerKeyName}\\{rootId}", writable: true)
+                              ?? throw new InvalidOperationException($"Registry key '{rootId}' not found");
+
+            syncRootKey.SetValue(ThumbnailProviderValueName, ThumbnailProviderClassId, RegistryValueKind.String);
+        }
+        catch (Exception ex) when (ex is InvalidOperationException or ObjectDisposedException or SecurityException or UnauthorizedAccessException)
+        {
+            _logger.LogWarning("Failed to register thumbnail provider: {ErrorMessage}", ex.Message);
+        }
+    }
+
     private void HideSyncRoot(string rootId)
     {
         try
@@ -0,0 +1,195 @@
+﻿using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Security.Cryptography;
+using System.Threading;
+using System.Threading.Tasks;
+using Microsoft.Extensions.Logging;
+using ProtonDrive.App.SystemIntegration;
+using ProtonDrive.Shared.Extensions;
+
+namespace ProtonDrive.App.Windows.SystemIntegration;
+
+/// <summary>
+/// Finds files with the requested content by hashing only the files of a requested size.
+/// </summary>
+/// <remarks>
+/// The files under the folders are indexed by size once and the index is reused until it expires, so that queries do not
+/// enumerate the folders again. Files added after indexing are found only once the index is rebuilt.
+/// Online-only placeholders are neither indexed nor hashed, reading them would download them.
+/// Hashes are remembered while the size and last write time of the file stay the same, so that repeated queries do not read the files again.
+/// </remarks>
+internal sealed class ContentDuplicateFinder : IContentDuplicateFinder
+{
+    private const FileAttributes RecallOnDataAccessAttribute = (FileAttributes)0x00400000;
+    private const FileAttributes RecallOnOpenAttribute = (FileAttributes)0x00040000;
+    private const int MaxNumberOfRememberedHashes = 4096;
+    private const int ReadBufferSize = 1 << 20;
+
+    // The shell extension does not ask about smaller files, they are cheap to upload again
+    private const long MinimumIndexedSize = 64 << 10;
+
+    private static readonly TimeSpan IndexLifetime = TimeSpan.FromMinutes(10);
+
+    // Enumerating folders that are not populated yet would make the app fetch their remote content
+    private static readonly EnumerationOptions EnumerationOptions = new()
+    {
+        RecurseSubdirectories = true,
+        IgnoreInaccessible = true,
+        AttributesToSkip = FileAttributes.Offline | RecallOnDataAccessAttribute | RecallOnOpenAttribute,
+    };
+
+    private readonly ILogger<ContentDuplicateFinder> _logger;
+
+    private readonly ConcurrentDictionary<string, RememberedHash> _rememberedHashes = new(StringComparer.OrdinalIgnoreCase);
+    private readonly object _indexLock = new();
+
+    private SizeIndex? _index;
+
+    public ContentDuplicateFinder(ILogger<ContentDuplicateFinder> logger)
+    {
+        _logger = logger;
+    }
+
+    public async Task<IReadOnlyList<string?>> FindAsync(
+        IReadOnlyCollection<string> rootPaths,
+        IReadOnlyList<(long Size, string Sha256)> contents,
+        CancellationToken cancellationToken)
+    {
+        // Cancellation ends the search early, it still returns the duplicates found so far
+        var result = new string?[contents.Count];
+        var numberOfFoundContents = 0;
+        var numberOfHashedFiles = 0;
+
+        try
+        {
+            // Indexing goes on after cancellation, so that the next query can use the index
+            var pathsBySize = await GetIndex(rootPaths).WaitAsync(cancellationToken).ConfigureAwait(false);
+
+            for (var i = 0; i < contents.Count; ++i)
+            {
+                foreach (var path in pathsBySize[contents[i].Size])
+                {
+                    cancellationToken.ThrowIfCancellationRequested();
+
+                    // The index can be stale, files that changed since are skipped
+                    var file = new FileInfo(path);
+                    if (!file.Exists || file.Length != contents[i].Size)
+                    {
+                        continue;
+                    }
+
+                    var (hash, isRemembered) = await TryGetHashAsync(file, cancellationToken).ConfigureAwait(false);
+                    if (!isRemembered && hash is not null)
+                    {
+                        ++numberOfHashedFiles;
+                    }
+
+                    if (string.Equals(contents[i].Sha256, hash, StringComparison.OrdinalIgnoreCase))
+                    {
+                        result[i] = file.FullName;
+                        ++numberOfFoundContents;
+                        break;
+                    }
+                }
+            }
+        }
+        catch (Exception ex) when (ex is OperationCanceledException or IOException or UnauthorizedAccessException)
+        {
+            _logger.LogWarning("Looking for content duplicates stopped early: {ExceptionType} {ErrorCode}", ex.GetType().Name, ex.GetRelevantFormattedErrorCode());
+        }
+
+        _logger.LogInformation(
+            "Found {NumberOfDuplicates} of {NumberOfContents} contents, {NumberOfHashedFiles} files hashed",
+            numberOfFoundContents,
+            contents.Count,
+            numberOfHashedFiles);
+
+        return result;
+    }
+
+    private Task<ILookup<long, string>> GetIndex(IReadOnlyCollection<string> rootPaths)
+    {
+        lock (_indexLock)
+        {
+            if (_index is null
+                || DateTime.UtcNow - _index.CreationTimeUtc >= IndexLifetime
+                || !_index.RootPaths.SequenceEqual(rootPaths, StringComparer.OrdinalIgnoreCase))
+            {
+                var indexedRootPaths = rootPaths.ToList();
+
+                _index = new SizeIndex(indexedRootPaths, DateTime.UtcNow, Task.Run(() => BuildIndex(indexedRootPaths)));
+            }
+
+            return _index.PathsBySize;
+        }
+    }
+
+    private ILookup<long, string> BuildIndex(IReadOnlyCollection<string> rootPaths)
+    {
+        var files = new List<FileInfo>();
+
+        foreach (var rootPath in rootPaths)
+        {
+            try
+            {
+                files.AddRange(new DirectoryInfo(rootPath).EnumerateFiles("*", EnumerationOptions).Where(file => file.Length >= MinimumIndexedSize));
+            }
+            catch (Exception ex) when (ex is IOException or UnauthorizedAccessException)
+            {
+                _logger.LogWarning("Indexing files by size failed: {ExceptionType} {ErrorCode}", ex.GetType().Name, ex.GetRelevantFormattedErrorCode());
+            }
+        }
+
+        _logger.LogInformation("Indexed {NumberOfFiles} files by size", files.Count);
+
+        return files.ToLookup(file => file.Length, file => file.FullName);
+    }
+
+    private async Task<(string? Hash, bool IsRemembered)> TryGetHashAsync(FileInfo file, CancellationToken cancellationToken)
+    {
+        if (_rememberedHashes.TryGetValue(file.FullName, out var rememberedHash)
+            && rememberedHash.Size == file.Length
+            && rememberedHash.LastWriteTimeUtc == file.LastWriteTimeUtc)
+        {
+            return (rememberedHash.Sha256, true);
+        }
+
+        string hash;
+
+        try
+        {
+            var stream = new FileStream(
+                file.FullName,
+                FileMode.Open,
+                FileAccess.Read,
+                FileShare.ReadWrite | FileShare.Delete,
+                ReadBufferSize,
+                FileOptions.SequentialScan | FileOptions.Asynchronous);
+
+            await using (stream.ConfigureAwait(false))
+            {
+                hash = Convert.ToHexString(await SHA256.HashDataAsync(stream, cancellationToken).ConfigureAwait(false));
+            }
+        }
+        catch (Exception ex) when (ex is IOException or UnauthorizedAccessException)
+        {
+            return (null, false);
+        }
+
+        if (_rememberedHashes.Count >= MaxNumberOfRememberedHashes)
+        {
+            _rememberedHashes.Clear();
+        }
+
+        _rememberedHashes[file.FullName] = new RememberedHash(file.Length, file.LastWriteTimeUtc, hash);
+
+        return (hash, false);
+    }
+
+    private sealed record RememberedHash(long Size, DateTime LastWriteTimeUtc, string Sha256);
+
+    private sealed record SizeIndex(IReadOnlyList<string> RootPaths, DateTime CreationTimeUtc, Task<ILookup<long, string>> PathsBySize);
+}
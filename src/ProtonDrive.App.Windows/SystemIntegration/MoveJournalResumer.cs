@@ -0,0 +1,425 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Diagnostics.CodeAnalysis;
+using System.Globalization;
+using System.IO;
+using System.Linq;
+using System.Security.Cryptography;
+using System.Text;
+using System.Text.Json;
+using System.Text.Json.Serialization;
+using System.Threading;
+using System.Threading.Tasks;
+using Microsoft.Extensions.Logging;
+using ProtonDrive.App.Services;
+using ProtonDrive.Shared.Configuration;
+using ProtonDrive.Shared.Extensions;
+using ProtonDrive.Shared.Threading;
+using ProtonDrive.Sync.Windows.FileSystem;
+
+namespace ProtonDrive.App.Windows.SystemIntegration;
+
+/// <summary>
+/// Completes Move to Drive operations that were interrupted by Explorer crashing or the machine restarting.
+/// </summary>
+/// <remarks>
+/// The journal format must match the one written by MoveJournal.cpp of the shell extension.
+/// Completion records are not flushed by the shell extension, so every planned item is checked:
+/// an item whose source no longer exists has been moved, the copy engine deletes the source only after copying.
+/// An item whose source no longer has the recorded identity is left alone, the path has been reused since.
+/// A source is deleted only when the destination has the same content, and the recorded content hash when known.
+/// An existing destination is only replaced when it is the very file the user chose to replace, or when it was created
+/// after the move started at a path that was vacant, otherwise both are kept.
+/// Files inside moved folders the user chose to leave where they are, because Proton Drive already has them, stay skipped.
+/// Journals older than <see cref="MaximumJournalAge"/> are deleted without resuming, the user has likely moved on.
+/// </remarks>
+internal sealed class MoveJournalResumer : IStartableService
+{
+    private const string JournalFolderName = "MoveJournals";
+    private const string JournalSearchPattern = "*.journal";
+    private const int MaximumNumberOfNameAttempts = 1000;
+
+    private static readonly TimeSpan MaximumJournalAge = TimeSpan.FromDays(7);
+
+    private static readonly EnumerationOptions EnumerationOptions = new()
+    {
+        AttributesToSkip = FileAttributes.ReparsePoint, // By default, Hidden and System attributes are skipped
+    };
+
+    private readonly string _journalFolderPath;
+    private readonly ILogger<MoveJournalResumer> _logger;
+
+    public MoveJournalResumer(AppConfig appConfig, ILogger<MoveJournalResumer> logger)
+    {
+        _journalFolderPath = Path.Combine(appConfig.AppDataPath, JournalFolderName);
+        _logger = logger;
+    }
+
+    public Task StartAsync(CancellationToken cancellationToken)
+    {
+        if (!Directory.Exists(_journalFolderPath))
+        {
+            return Task.CompletedTask;
+        }
+
+        // Moving can take long, it should not delay the app start
+        Task.Run(() => ResumeAll(cancellationToken), cancellationToken).Forget();
+
+        return Task.CompletedTask;
+    }
+
+    private static bool TryParseRecord(string line, [NotNullWhen(true)] out MoveJournalRecord? record)
+    {
+        record = null;
+
+        // Torn writes leave a line without a valid checksum
+        var separatorIndex = line.LastIndexOf('\t');
+        if (separatorIndex < 0
+            || !uint.TryParse(line.AsSpan(separatorIndex + 1), NumberStyles.AllowHexSpecifier, CultureInfo.InvariantCulture, out var checksum))
+        {
+            return false;
+        }
+
+        ReadOnlySpan<byte> recordBytes = Encoding.UTF8.GetBytes(line[..separatorIndex]);
+        if (recordBytes.GetFnv1aHash() != checksum)
+        {
+            return false;
+        }
+
+        try
+        {
+            record = JsonSerializer.Deserialize<MoveJournalRecord>(recordBytes);
+            return record is not null;
+        }
+        catch (JsonException)
+        {
+            return false;
+        }
+    }
+
+    private static bool HasIdentity(string path, uint? volumeSerialNumber, long? fileId)
+    {
+        using var fileSystemObject = FileSystemObject.Open(
+            path,
+            FileMode.Open,
+            FileSystemFileAccess.ReadAttributes,
+            FileShare.ReadWrite | FileShare.Delete,
+            FileOptions.None);
+
+        return fileSystemObject.VolumeSerialNumber == volumeSerialNumber && fileSystemObject.ObjectId == fileId;
+    }
+
+    private static string GetContentHash(FileInfo file)
+    {
+        using var stream = file.Open(FileMode.Open, FileAccess.Read, FileShare.Read);
+
+        return Convert.ToHexString(SHA256.HashData(stream));
+    }
+
+    private static bool IsCompleteCopy(FileInfo source, FileInfo destination, long? expectedSize, string? expectedContentHash)
+    {
+        if (destination.Length != source.Length || (expectedSize is not null && destination.Length != expectedSize))
+        {
+            return false;
+        }
+
+        var destinationContentHash = GetContentHash(destination);
+
+        // The copy must hold the content that was planned to move, and the source must not have changed since
+        if (expectedContentHash is not null && !string.Equals(destinationContentHash, expectedContentHash, StringComparison.OrdinalIgnoreCase))
+        {
+            return false;
+        }
+
+        return string.Equals(destinationContentHash, GetContentHash(source), StringComparison.OrdinalIgnoreCase);
+    }
+
+    private static bool TryGetVacantPath(string path, [NotNullWhen(true)] out string? vacantPath)
+    {
+        var folderPath = Path.GetDirectoryName(path) ?? string.Empty;
+        var stem = Path.GetFileNameWithoutExtension(path);
+        var extension = Path.GetExtension(path);
+
+        for (var number = 2; number < MaximumNumberOfNameAttempts; ++number)
+        {
+            vacantPath = Path.Combine(folderPath, $"{stem} ({number}){extension}");
+            if (!Path.Exists(vacantPath))
+            {
+                return true;
+            }
+        }
+
+        vacantPath = null;
+        return false;
+    }
+
+    private void ResumeAll(CancellationToken cancellationToken)
+    {
+        try
+        {
+            foreach (var journalPath in Directory.EnumerateFiles(_journalFolderPath, JournalSearchPattern))
+            {
+                cancellationToken.ThrowIfCancellationRequested();
+
+                try
+                {
+                    Resume(journalPath, cancellationToken);
+                }
+                catch (Exception ex) when (ex.IsFileAccessException())
+                {
+                    // The journal of a move still in progress is not shared for writing
+                    _logger.LogWarning("Failed to resume move: {ExceptionType}: {ErrorCode}", ex.GetType().Name, ex.GetRelevantFormattedErrorCode());
+                }
+            }
+        }
+        catch (OperationCanceledException)
+        {
+            // Ignore
+        }
+    }
+
+    private void Resume(string journalPath, CancellationToken cancellationToken)
+    {
+        // The journal is created when the move starts
+        var moveStartTime = File.GetCreationTimeUtc(journalPath);
+
+        if (DateTime.UtcNow - moveStartTime > MaximumJournalAge)
+        {
+            _logger.LogInformation("Discarding interrupted move journal older than {MaximumAge}", MaximumJournalAge);
+            File.Delete(journalPath);
+            return;
+        }
+
+        string? destinationFolderPath = null;
+        var plannedItems = new SortedDictionary<int, MoveJournalRecord>();
+        var completedItems = new HashSet<int>();
+
+        using (var stream = new FileStream(journalPath, FileMode.Open, FileAccess.ReadWrite, FileShare.None))
+        using (var reader = new StreamReader(stream, Encoding.UTF8))
+        {
+            while (reader.ReadLine() is { } line)
+            {
+                if (!TryParseRecord(line, out var record))
+                {
+                    continue;
+                }
+
+                switch (record.Type)
+                {
+                    case "move":
+                        destinationFolderPath = record.Destination;
+                        break;
+
+                    case "planned" when record is { Source: not null, Name: not null }:
+                        plannedItems[record.Index] = record;
+                        break;
+
+                    case "completed":
+                        completedItems.Add(record.Index);
+                        break;
+                }
+            }
+        }
+
+        var remainingItems = plannedItems.Where(x => !completedItems.Contains(x.Key)).Select(x => x.Value).ToList();
+
+        _logger.LogInformation(
+            "Resuming interrupted move of {NumberOfItems} items, {NumberOfRemainingItems} not recorded as completed",
+            plannedItems.Count,
+            remainingItems.Count);
+
+        if (destinationFolderPath is not null && Directory.Exists(destinationFolderPath))
+        {
+            foreach (var item in remainingItems)
+            {
+                cancellationToken.ThrowIfCancellationRequested();
+
+                TryMove(item, Path.Combine(destinationFolderPath, item.Name!), moveStartTime);
+            }
+        }
+
+        File.Delete(journalPath);
+    }
+
+    private void TryMove(MoveJournalRecord item, string destinationPath, DateTime moveStartTime)
+    {
+        try
+        {
+            var sourcePath = item.Source!;
+            if (!Path.Exists(sourcePath))
+            {
+                // The item was moved before the interruption
+                return;
+            }
+
+            if (!HasIdentity(sourcePath, item.VolumeSerialNumber, item.FileId))
+            {
+                _logger.LogWarning("Skipped resuming moving item: the source is not the item that was planned to move");
+                return;
+            }
+
+            if (File.Exists(sourcePath))
+            {
+                var destination = new DestinationExpectation(
+                    item.IsDestinationVacant,
+                    item.ReplaceExisting ? item.DestinationVolumeSerialNumber : null,
+                    item.ReplaceExisting ? item.DestinationFileId : null,
+                    item.Size,
+                    item.ContentHash,
+                    moveStartTime);
+
+                MoveFile(new FileInfo(sourcePath), destinationPath, destination);
+            }
+            else
+            {
+                var skippedPaths = new HashSet<string>(item.SkippedPaths ?? [], StringComparer.OrdinalIgnoreCase);
+
+                MoveDirectory(new DirectoryInfo(sourcePath), destinationPath, item.IsDestinationVacant || item.ReplaceExisting, moveStartTime, skippedPaths);
+            }
+        }
+        catch (Exception ex) when (ex.IsFileAccessException())
+        {
+            _logger.LogWarning("Failed to resume moving item: {ExceptionType}: {ErrorCode}", ex.GetType().Name, ex.GetRelevantFormattedErrorCode());
+        }
+    }
+
+    private void MoveFile(FileInfo source, string destinationPath, DestinationExpectation expectation)
+    {
+        var destination = new FileInfo(destinationPath);
+
+        if (destination.Exists)
+        {
+            if (IsCompleteCopy(source, destination, expectation.ContentSize, expectation.ContentHash))
+            {
+                source.Delete();
+                return;
+            }
+
+            if (!IsPartialCopy(destination, expectation))
+            {
+                MoveToVacantPath(source, destinationPath);
+                return;
+            }
+        }
+        else if (Directory.Exists(destinationPath))
+        {
+            MoveToVacantPath(source, destinationPath);
+            return;
+        }
+
+        // An existing destination is the partial copy
+        source.MoveTo(destinationPath, overwrite: destination.Exists);
+    }
+
+    private void MoveDirectory(DirectoryInfo source, string destinationPath, bool isDestinationOurs, DateTime moveStartTime, IReadOnlySet<string> skippedPaths)
+    {
+        if ((!isDestinationOurs && Directory.Exists(destinationPath)) || File.Exists(destinationPath))
+        {
+            if (!TryGetVacantPath(destinationPath, out var vacantPath))
+            {
+                _logger.LogWarning("Failed to resume moving folder: no vacant name in the destination folder");
+                return;
+            }
+
+            destinationPath = vacantPath;
+            isDestinationOurs = true;
+        }
+
+        // Moving the folder as a whole would take the skipped files along
+        if (skippedPaths.Count == 0
+            && !Directory.Exists(destinationPath)
+            && string.Equals(Path.GetPathRoot(source.FullName), Path.GetPathRoot(destinationPath), StringComparison.OrdinalIgnoreCase))
+        {
+            source.MoveTo(destinationPath);
+            return;
+        }
+
+        // The remaining items are moved one by one, their data copied when on the other volume.
+        // Nothing is known about the descendants but that their destination was vacant when the folder destination was ours.
+        Directory.CreateDirectory(destinationPath);
+
+        var expectation = new DestinationExpectation(
+            isDestinationOurs,
+            DestinationVolumeSerialNumber: null,
+            DestinationFileId: null,
+            ContentSize: null,
+            ContentHash: null,
+            moveStartTime);
+
+        foreach (var file in source.EnumerateFiles("*", EnumerationOptions))
+        {
+            if (skippedPaths.Contains(file.FullName))
+            {
+                continue;
+            }
+
+            MoveFile(file, Path.Combine(destinationPath, file.Name), expectation);
+        }
+
+        foreach (var directory in source.EnumerateDirectories("*", EnumerationOptions))
+        {
+            MoveDirectory(directory, Path.Combine(destinationPath, directory.Name), isDestinationOurs, moveStartTime, skippedPaths);
+        }
+
+        if (!source.EnumerateFileSystemInfos().Any())
+        {
+            source.Delete();
+        }
+    }
+
+    private bool IsPartialCopy(FileInfo destination, DestinationExpectation expectation)
+    {
+        // The file the user chose to replace, not yet replaced
+        if (expectation.DestinationFileId is not null
+            && HasIdentity(destination.FullName, expectation.DestinationVolumeSerialNumber, expectation.DestinationFileId))
+        {
+            return true;
+        }
+
+        // The copy engine creates the copy, a file at a path that was vacant and created since the move started is the copy
+        var isCreatedByMove = destination.CreationTimeUtc >= expectation.MoveStartTime;
+
+        if (isCreatedByMove && (expectation.IsDestinationVacant || expectation.DestinationFileId is not null))
+        {
+            return true;
+        }
+
+        _logger.LogInformation("Keeping both files: the existing destination is not a copy made by the interrupted move");
+        return false;
+    }
+
+    private void MoveToVacantPath(FileInfo source, string destinationPath)
+    {
+        if (!TryGetVacantPath(destinationPath, out var vacantPath))
+        {
+            _logger.LogWarning("Failed to resume moving file: no vacant name in the destination folder");
+            return;
+        }
+
+        source.MoveTo(vacantPath);
+    }
+
+    private sealed record MoveJournalRecord(
+        [property: JsonPropertyName("type")] string Type,
+        [property: JsonPropertyName("destination")] string? Destination,
+        [property: JsonPropertyName("index")] int Index,
+        [property: JsonPropertyName("source")] string? Source,
+        [property: JsonPropertyName("name")] string? Name,
+        [property: JsonPropertyName("vacant")] bool IsDestinationVacant,
+        [property: JsonPropertyName("replace")] bool ReplaceExisting,
+        [property: JsonPropertyName("volume")] uint? VolumeSerialNumber,
+        [property: JsonPropertyName("fileId")] long? FileId,
+        [property: JsonPropertyName("destinationVolume")] uint? DestinationVolumeSerialNumber,
+        [property: JsonPropertyName("destinationFileId")] long? DestinationFileId,
+        [property: JsonPropertyName("size")] long? Size,
+        [property: JsonPropertyName("sha256")] string? ContentHash,
+        [property: JsonPropertyName("skipped")] IReadOnlyList<string>? SkippedPaths);
+
+    private sealed record DestinationExpectation(
+        bool IsDestinationVacant,
+        uint? DestinationVolumeSerialNumber,
+        long? DestinationFileId,
+        long? ContentSize,
+        string? ContentHash,
+        DateTime MoveStartTime);
+}
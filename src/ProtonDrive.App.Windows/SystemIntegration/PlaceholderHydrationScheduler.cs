@@ -0,0 +1,377 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Diagnostics.CodeAnalysis;
+using System.IO;
+using System.Linq;
+using System.Runtime.InteropServices;
+using System.Threading;
+using System.Threading.RateLimiting;
+using System.Threading.Tasks;
+using Microsoft.Extensions.Logging;
+using ProtonDrive.App.SystemIntegration;
+using ProtonDrive.Shared.Extensions;
+using ProtonDrive.Shared.Threading;
+using ProtonDrive.Sync.Windows.FileSystem;
+using ProtonDrive.Sync.Windows.FileSystem.CloudFiles;
+using static Vanara.PInvoke.CldApi;
+
+namespace ProtonDrive.App.Windows.SystemIntegration;
+
+internal sealed class PlaceholderHydrationScheduler : IPlaceholderHydrationScheduler
+{
+    private const int MaxDegreeOfParallelism = 4;
+
+    // Background jobs never occupy all workers, so that interactive jobs can start immediately
+    private const int MaxBackgroundDegreeOfParallelism = 2;
+
+    // Jobs not larger than this are considered to be waited for by the user
+    private const int MaxNumberOfInteractiveJobFiles = 100;
+    private const long MaxInteractiveJobSize = 100L * 1024 * 1024;
+
+    // Background jobs compete with the sync engine's own transfers, so their rate is limited.
+    // Tokens are admitted before each file hydration starts, bandwidth tokens are in KiB.
+    private const int BackgroundKibibytesPerSecond = 20 * 1024;
+    private const int BackgroundFilesPerSecond = 20;
+
+    // FILE_ATTRIBUTE_RECALL_ON_DATA_ACCESS
+    private const FileAttributes RecallOnDataAccessAttribute = (FileAttributes)0x00400000;
+
+    private static readonly EnumerationOptions EnumerationOptions = new()
+    {
+        RecurseSubdirectories = true,
+        AttributesToSkip = FileAttributes.None, // By default, Hidden and System attributes are skipped
+    };
+
+    private readonly ILogger<PlaceholderHydrationScheduler> _logger;
+
+    private readonly RateLimiter _backgroundBandwidthLimiter = CreateTokenBucketRateLimiter(BackgroundKibibytesPerSecond);
+    private readonly RateLimiter _backgroundFileRateLimiter = CreateTokenBucketRateLimiter(BackgroundFilesPerSecond);
+
+    // Jobs of each priority class, served round-robin one file at a time
+    private readonly object _lock = new();
+    private readonly LinkedList<HydrationJob> _interactiveJobs = new();
+    private readonly LinkedList<HydrationJob> _backgroundJobs = new();
+    private int _numberOfQueuedFiles;
+    private int _numberOfWorkers;
+    private int _numberOfActiveBackgroundHydrations;
+
+    public PlaceholderHydrationScheduler(ILogger<PlaceholderHydrationScheduler> logger)
+    {
+        _logger = logger;
+    }
+
+    private enum PriorityClass
+    {
+        Interactive,
+        Background,
+    }
+
+    public async Task KeepOnDeviceAsync(IReadOnlyCollection<string> paths, CancellationToken cancellationToken)
+    {
+        var files = new List<FileInfo>();
+
+        foreach (var path in paths)
+        {
+            if (!TrySetPinState(path, CF_PIN_STATE.CF_PIN_STATE_PINNED))
+            {
+                continue;
+            }
+
+            files.AddRange(GetDehydratedFiles(path));
+        }
+
+        if (files.Count == 0)
+        {
+            return;
+        }
+
+        // Smaller files first, so that most of the selected items become available offline as soon as possible
+        files.Sort((x, y) => x.Length.CompareTo(y.Length));
+
+        var totalSize = files.Sum(file => file.Length);
+        var priorityClass = files.Count <= MaxNumberOfInteractiveJobFiles && totalSize <= MaxInteractiveJobSize
+            ? PriorityClass.Interactive
+            : PriorityClass.Background;
+
+        var job = new HydrationJob(files, priorityClass, cancellationToken);
+
+        _logger.LogInformation("Hydrating {NumberOfFiles} placeholder files, {Size} bytes, {PriorityClass} priority", files.Count, totalSize, priorityClass);
+
+        Enqueue(job);
+
+        await job.Completion.WaitAsync(cancellationToken).ConfigureAwait(false);
+
+        var elapsed = job.Stopwatch.Elapsed;
+
+        _logger.LogInformation(
+            "Hydrated {NumberOfFiles} placeholder files, {Size} bytes in {Elapsed}, {Throughput} bytes/s, {QueueDepth} files of other jobs queued",
+            job.NumberOfHydratedFiles,
+            job.HydratedSize,
+            elapsed,
+            (long)(job.HydratedSize / Math.Max(elapsed.TotalSeconds, 0.001)),
+            Volatile.Read(ref _numberOfQueuedFiles));
+    }
+
+    public Task FreeUpSpaceAsync(IReadOnlyCollection<string> paths, CancellationToken cancellationToken)
+    {
+        // The sync adapter dehydrates files as soon as it detects they are unpinned
+        foreach (var path in paths)
+        {
+            cancellationToken.ThrowIfCancellationRequested();
+
+            TrySetPinState(path, CF_PIN_STATE.CF_PIN_STATE_UNPINNED);
+        }
+
+        return Task.CompletedTask;
+    }
+
+    private static RateLimiter CreateTokenBucketRateLimiter(int tokensPerSecond)
+    {
+        return new TokenBucketRateLimiter(
+            new TokenBucketRateLimiterOptions
+            {
+                TokenLimit = tokensPerSecond,
+                TokensPerPeriod = Math.Max(tokensPerSecond / 10, 1),
+                ReplenishmentPeriod = TimeSpan.FromMilliseconds(100),
+                QueueLimit = int.MaxValue,
+                QueueProcessingOrder = QueueProcessingOrder.OldestFirst,
+                AutoReplenishment = true,
+            });
+    }
+
+    private static IEnumerable<FileInfo> GetDehydratedFiles(string path)
+    {
+        if (File.Exists(path))
+        {
+            var file = new FileInfo(path);
+
+            return IsDehydrated(file) ? [file] : [];
+        }
+
+        if (!Directory.Exists(path))
+        {
+            return [];
+        }
+
+        return new DirectoryInfo(path).EnumerateFiles("*", EnumerationOptions).Where(IsDehydrated);
+    }
+
+    private static bool IsDehydrated(FileInfo file)
+    {
+        return (file.Attributes & (FileAttributes.Offline | RecallOnDataAccessAttribute)) != 0;
+    }
+
+    private static async Task AcquireAsync(RateLimiter rateLimiter, long numberOfTokens, int tokenLimit, CancellationToken cancellationToken)
+    {
+        // A single acquisition cannot exceed the bucket capacity
+        while (numberOfTokens > 0)
+        {
+            var permitCount = (int)Math.Min(numberOfTokens, tokenLimit);
+
+            using var lease = await rateLimiter.AcquireAsync(permitCount, cancellationToken).ConfigureAwait(false);
+
+            numberOfTokens -= permitCount;
+        }
+    }
+
+    private static bool TryDequeue(LinkedList<HydrationJob> jobs, [NotNullWhen(true)] out HydrationJob? job, [NotNullWhen(true)] out FileInfo? file)
+    {
+        var node = jobs.First;
+        if (node is null)
+        {
+            job = null;
+            file = null;
+            return false;
+        }
+
+        job = node.Value;
+        file = job.DequeueFile();
+
+        // Moving the job to the end, so that jobs of the same priority class share the workers equally
+        jobs.RemoveFirst();
+        if (job.NumberOfRemainingFiles > 0)
+        {
+            jobs.AddLast(node);
+        }
+
+        return true;
+    }
+
+    private void Enqueue(HydrationJob job)
+    {
+        var numberOfWorkersToStart = 0;
+
+        lock (_lock)
+        {
+            GetJobs(job.PriorityClass).AddLast(job);
+            _numberOfQueuedFiles += job.NumberOfRemainingFiles;
+
+            while (_numberOfWorkers < MaxDegreeOfParallelism && numberOfWorkersToStart < job.NumberOfRemainingFiles)
+            {
+                ++_numberOfWorkers;
+                ++numberOfWorkersToStart;
+            }
+        }
+
+        for (var i = 0; i < numberOfWorkersToStart; ++i)
+        {
+            Task.Run(RunWorkerAsync).Forget();
+        }
+    }
+
+    private bool TryDequeue([NotNullWhen(true)] out HydrationJob? job, [NotNullWhen(true)] out FileInfo? file)
+    {
+        lock (_lock)
+        {
+            if (TryDequeue(_interactiveJobs, out job, out file)
+                || (_numberOfActiveBackgroundHydrations < MaxBackgroundDegreeOfParallelism && TryDequeue(_backgroundJobs, out job, out file)))
+            {
+                --_numberOfQueuedFiles;
+
+                if (job.PriorityClass is PriorityClass.Background)
+                {
+                    ++_numberOfActiveBackgroundHydrations;
+                }
+
+                return true;
+            }
+
+            // Exiting under the lock, so that a job enqueued concurrently starts a new worker
+            --_numberOfWorkers;
+
+            return false;
+        }
+    }
+
+    private LinkedList<HydrationJob> GetJobs(PriorityClass priorityClass)
+    {
+        return priorityClass is PriorityClass.Interactive ? _interactiveJobs : _backgroundJobs;
+    }
+
+    private async Task RunWorkerAsync()
+    {
+        while (TryDequeue(out var job, out var file))
+        {
+            var isHydrated = false;
+
+            try
+            {
+                if (job.PriorityClass is PriorityClass.Background)
+                {
+                    await AcquireAsync(_backgroundFileRateLimiter, 1, BackgroundFilesPerSecond, job.CancellationToken).ConfigureAwait(false);
+                    await AcquireAsync(_backgroundBandwidthLimiter, (file.Length + 1023) / 1024, BackgroundKibibytesPerSecond, job.CancellationToken).ConfigureAwait(false);
+                }
+
+                // Files of cancelled jobs are skipped, so that the job completes as soon as possible
+                if (!job.CancellationToken.IsCancellationRequested)
+                {
+                    isHydrated = TryHydrate(file.FullName, job.CancellationToken);
+                }
+            }
+            catch (OperationCanceledException)
+            {
+                // Ignore
+            }
+            finally
+            {
+                if (job.PriorityClass is PriorityClass.Background)
+                {
+                    lock (_lock)
+                    {
+                        --_numberOfActiveBackgroundHydrations;
+                    }
+                }
+
+                job.CompleteFile(file, isHydrated);
+            }
+        }
+    }
+
+    private bool TrySetPinState(string path, CF_PIN_STATE state)
+    {
+        try
+        {
+            using var fileSystemObject = FileSystemObject.Open(path, FileMode.Open, FileSystemFileAccess.WriteAttributes, FileShare.ReadWrite | FileShare.Delete, FileOptions.None);
+
+            fileSystemObject.SetPinState(state, CF_SET_PIN_FLAGS.CF_SET_PIN_FLAG_RECURSE);
+
+            return true;
+        }
+        catch (Exception ex) when (ex.IsFileAccessException() || ex is COMException)
+        {
+            _logger.LogWarning("Failed to set pin state to {State}: {ExceptionType}: {ErrorCode}", state, ex.GetType().Name, ex.GetRelevantFormattedErrorCode());
+
+            return false;
+        }
+    }
+
+    private bool TryHydrate(string path, CancellationToken cancellationToken)
+    {
+        try
+        {
+            using var file = FileSystemFile.Open(path, FileMode.Open, FileSystemFileAccess.ReadAttributes, FileShare.ReadWrite | FileShare.Delete);
+
+            // ReSharper disable once AccessToDisposedClosure
+            using var cancellationRegistration = cancellationToken.Register(() => file.FileHandle.CancelIo());
+
+            file.HydratePlaceholder();
+
+            return true;
+        }
+        catch (Exception ex) when (ex.IsFileAccessException() || ex is COMException)
+        {
+            _logger.LogWarning("Failed to hydrate placeholder file: {ExceptionType}: {ErrorCode}", ex.GetType().Name, ex.GetRelevantFormattedErrorCode());
+
+            return false;
+        }
+    }
+
+    private sealed class HydrationJob
+    {
+        private readonly Queue<FileInfo> _files;
+        private readonly TaskCompletionSource _completionSource = new(TaskCreationOptions.RunContinuationsAsynchronously);
+        private int _numberOfUnfinishedFiles;
+        private int _numberOfHydratedFiles;
+        private long _hydratedSize;
+
+        public HydrationJob(IReadOnlyCollection<FileInfo> files, PriorityClass priorityClass, CancellationToken cancellationToken)
+        {
+            _files = new Queue<FileInfo>(files);
+            _numberOfUnfinishedFiles = files.Count;
+            PriorityClass = priorityClass;
+            CancellationToken = cancellationToken;
+        }
+
+        public PriorityClass PriorityClass { get; }
+        public CancellationToken CancellationToken { get; }
+        public Stopwatch Stopwatch { get; } = Stopwatch.StartNew();
+        public Task Completion => _completionSource.Task;
+
+        /// <remarks>Accessed under the scheduler lock only.</remarks>
+        public int NumberOfRemainingFiles => _files.Count;
+
+        public int NumberOfHydratedFiles => Volatile.Read(ref _numberOfHydratedFiles);
+        public long HydratedSize => Interlocked.Read(ref _hydratedSize);
+
+        public FileInfo DequeueFile()
+        {
+            return _files.Dequeue();
+        }
+
+        public void CompleteFile(FileInfo file, bool isHydrated)
+        {
+            if (isHydrated)
+            {
+                Interlocked.Increment(ref _numberOfHydratedFiles);
+                Interlocked.Add(ref _hydratedSize, file.Length);
+            }
+
+            if (Interlocked.Decrement(ref _numberOfUnfinishedFiles) == 0)
+            {
+                Stopwatch.Stop();
+                _completionSource.SetResult();
+            }
+        }
+    }
+}
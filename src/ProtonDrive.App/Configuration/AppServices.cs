@@ -35,6 +35,7 @@ using ProtonDrive.App.Sanitization;
 using ProtonDrive.App.Services;
 using ProtonDrive.App.Settings;
 using ProtonDrive.App.Settings.Remote;
+using ProtonDrive.App.Sharing;
 using ProtonDrive.App.Sync;
 using ProtonDrive.App.Telemetry;
 using ProtonDrive.App.Update;
@@ -285,6 +286,9 @@ public static class AppServices
                 .AddSingleton<SyncStateClearingService>()
                 .AddSingleton<IAccountSwitchingHandler>(provider => provider.GetRequiredService<SyncStateClearingService>())
 
+                .AddSingleton<ThumbnailCache>()
+                .AddSingleton<IAccountSwitchingHandler>(provider => provider.GetRequiredService<ThumbnailCache>())
+
                 .AddSingleton<ResilientSetup>()
                 .AddSingleton<ISessionStateAware>(provider => provider.GetRequiredService<ResilientSetup>())
                 .AddSingleton<IAccountStateAware>(provider => provider.GetRequiredService<ResilientSetup>())
@@ -310,6 +314,18 @@ public static class AppServices
                 .AddSingleton<IIpcMessageHandler, RemoteIdsQueryHandler>()
                 .AddSingleton<IIpcMessageHandler, AppActivationCommandHandler>()
                 .AddSingleton<IIpcMessageHandler, OpenDocumentCommandHandler>()
+                .AddSingleton<IIpcMessageHandler, SyncRootChangesSubscriptionHandler>()
+                .AddSingleton<IIpcMessageHandler, KeepOnDeviceCommandHandler>()
+                .AddSingleton<IIpcMessageHandler, FreeUpSpaceCommandHandler>()
+                .AddSingleton<IIpcMessageHandler, ShellExtensionStatisticsReportHandler>()
+                .AddSingleton<IIpcMessageHandler, ContentDuplicatesQueryHandler>()
+                .AddSingleton<IIpcMessageHandler, ThumbnailQueryHandler>()
+                .AddSingleton<IIpcMessageHandler, PrepareShareHintHandler>()
+                .AddSingleton<IIpcMessageHandler, ShareByUrlCommandHandler>()
+
+                .AddSingleton<SyncRootChangeNotifier>()
+                .AddSingleton<IMappingsSetupStateAware>(provider => provider.GetRequiredService<SyncRootChangeNotifier>())
+                .AddSingleton<ISyncActivityAware>(provider => provider.GetRequiredService<SyncRootChangeNotifier>())
 
                 .AddSingleton<UpdateService>()
                 .AddSingleton<IUpdateService>(provider => provider.GetRequiredService<UpdateService>())
@@ -372,6 +388,8 @@ public static class AppServices
                 .AddSingleton<IAccountStateAware>(provider => provider.GetRequiredService<ActivityService>())
 
                 .AddSingleton<DocumentOpener>()
+                .AddSingleton<SharePreparer>()
+                .AddSingleton<ShareLinkOpener>()
             ;
     }
 
@@ -0,0 +1,13 @@
+﻿using System.Text.Json.Serialization;
+
+namespace ProtonDrive.App.InterProcessCommunication;
+
+/// <summary>
+/// Memory held by a shell extension subsystem, reported by builds with allocation accounting only.
+/// </summary>
+public sealed record AllocationGauge(
+    [property: JsonPropertyName("subsystem")] string? Subsystem,
+    [property: JsonPropertyName("bytes")] long Bytes,
+    [property: JsonPropertyName("count")] long Count,
+    [property: JsonPropertyName("peakBytes")] long PeakBytes,
+    [property: JsonPropertyName("totalCount")] long TotalCount);
@@ -0,0 +1,58 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Threading;
+using System.Threading.Tasks;
+using ProtonDrive.App.Settings;
+using ProtonDrive.App.Sync;
+using ProtonDrive.App.SystemIntegration;
+
+namespace ProtonDrive.App.InterProcessCommunication;
+
+/// <summary>
+/// Tells the shell extension which of the files being moved into Proton Drive have content that is already there.
+/// </summary>
+/// <remarks>
+/// Responds with the path of an existing file with the same content for every queried item, or an empty string.
+/// Items not found before the time limit are reported as having no duplicate.
+/// </remarks>
+internal sealed class ContentDuplicatesQueryHandler : IpcMessageHandlerBase<IReadOnlyList<ContentDuplicatesQueryItem>>
+{
+    // The shell extension stops waiting after 5 seconds
+    private static readonly TimeSpan TimeLimit = TimeSpan.FromSeconds(4);
+
+    private readonly ISyncRootPathProvider _syncRootPathProvider;
+    private readonly IContentDuplicateFinder _contentDuplicateFinder;
+
+    public ContentDuplicatesQueryHandler(ISyncRootPathProvider syncRootPathProvider, IContentDuplicateFinder contentDuplicateFinder)
+        : base(IpcMessageType.ContentDuplicatesQuery)
+    {
+        _syncRootPathProvider = syncRootPathProvider;
+        _contentDuplicateFinder = contentDuplicateFinder;
+    }
+
+    public override async Task HandleAsync<T>(IReadOnlyList<ContentDuplicatesQueryItem>? items, T responder, CancellationToken cancellationToken)
+    {
+        if (items is null || items.Count == 0)
+        {
+            await responder.Respond<IReadOnlyList<string>>([], cancellationToken).ConfigureAwait(false);
+            return;
+        }
+
+        var syncRootPaths = _syncRootPathProvider.GetOfTypes([MappingType.CloudFiles]);
+
+        using var timeLimitCancellationSource = CancellationTokenSource.CreateLinkedTokenSource(cancellationToken);
+        timeLimitCancellationSource.CancelAfter(TimeLimit);
+
+        var existingPaths = await _contentDuplicateFinder.FindAsync(
+            syncRootPaths,
+            items.Select(item => (item.Size, item.Sha256 ?? string.Empty)).ToList(),
+            timeLimitCancellationSource.Token).ConfigureAwait(false);
+
+        cancellationToken.ThrowIfCancellationRequested();
+
+        IReadOnlyList<string> response = existingPaths.Select(path => path ?? string.Empty).ToList();
+
+        await responder.Respond(response, cancellationToken).ConfigureAwait(false);
+    }
+}
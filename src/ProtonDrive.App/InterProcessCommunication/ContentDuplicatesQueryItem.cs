@@ -0,0 +1,7 @@
+﻿using System.Text.Json.Serialization;
+
+namespace ProtonDrive.App.InterProcessCommunication;
+
+public sealed record ContentDuplicatesQueryItem(
+    [property: JsonPropertyName("size")] long Size,
+    [property: JsonPropertyName("sha256")] string? Sha256);
@@ -0,0 +1,11 @@
+﻿using System.Text.Json.Serialization;
+
+namespace ProtonDrive.App.InterProcessCommunication;
+
+/// <summary>
+/// Switch of a shell extension instance to a cheaper or more complete way of building the context menu.
+/// </summary>
+public sealed record DegradationModeChangeStatistics(
+    [property: JsonPropertyName("previousMode")] string? PreviousMode,
+    [property: JsonPropertyName("mode")] string? Mode,
+    [property: JsonPropertyName("numberOfSlowSamples")] int NumberOfSlowSamples);
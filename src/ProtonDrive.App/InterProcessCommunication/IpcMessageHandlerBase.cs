@@ -2,11 +2,17 @@
 using System.Text.Json.Nodes;
 using System.Threading;
 using System.Threading.Tasks;
+using ProtonDrive.Shared.Text.Serialization;
 
 namespace ProtonDrive.App.InterProcessCommunication;
 
 internal abstract class IpcMessageHandlerBase<TParameters> : IIpcMessageHandler
 {
+    private static readonly JsonSerializerOptions JsonSerializerOptions = new()
+    {
+        Converters = { new FrontCodedStringListJsonConverter() },
+    };
+
     protected IpcMessageHandlerBase(string messageType)
     {
         MessageType = messageType;
@@ -16,7 +22,7 @@ internal abstract class IpcMessageHandlerBase<TParameters> : IIpcMessageHandler
 
     Task IIpcMessageHandler.HandleAsync<T>(JsonNode? parametersNode, T responder, CancellationToken cancellationToken)
     {
-        var parameters = parametersNode.Deserialize<TParameters>();
+        var parameters = parametersNode.Deserialize<TParameters>(JsonSerializerOptions);
 
         return HandleAsync(parameters, responder, cancellationToken);
     }
@@ -6,4 +6,12 @@ public static class IpcMessageType
     public static readonly string RemoteIdsQuery = nameof(RemoteIdsQuery);
     public static readonly string AppActivationCommand = nameof(AppActivationCommand);
     public static readonly string OpenDocumentCommand = nameof(OpenDocumentCommand);
+    public static readonly string SyncRootChangesSubscription = nameof(SyncRootChangesSubscription);
+    public static readonly string KeepOnDeviceCommand = nameof(KeepOnDeviceCommand);
+    public static readonly string FreeUpSpaceCommand = nameof(FreeUpSpaceCommand);
+    public static readonly string ShellExtensionStatisticsReport = nameof(ShellExtensionStatisticsReport);
+    public static readonly string PrepareShareHint = nameof(PrepareShareHint);
+    public static readonly string ShareByUrlCommand = nameof(ShareByUrlCommand);
+    public static readonly string ContentDuplicatesQuery = nameof(ContentDuplicatesQuery);
+    public static readonly string ThumbnailQuery = nameof(ThumbnailQuery);
 }
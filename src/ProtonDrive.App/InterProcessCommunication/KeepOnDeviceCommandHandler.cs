@@ -0,0 +1,43 @@
+﻿using System.Collections.Generic;
+using System.Linq;
+using System.Threading;
+using System.Threading.Tasks;
+using ProtonDrive.App.Settings;
+using ProtonDrive.App.Sync;
+using ProtonDrive.App.SystemIntegration;
+using ProtonDrive.Shared.IO;
+
+namespace ProtonDrive.App.InterProcessCommunication;
+
+/// <summary>
+/// Handles the request to keep on this device the items selected in the shell.
+/// </summary>
+internal sealed class KeepOnDeviceCommandHandler : IpcMessageHandlerBase<IReadOnlyList<string>>
+{
+    private readonly ISyncRootPathProvider _syncRootPathProvider;
+    private readonly IPlaceholderHydrationScheduler _hydrationScheduler;
+
+    public KeepOnDeviceCommandHandler(ISyncRootPathProvider syncRootPathProvider, IPlaceholderHydrationScheduler hydrationScheduler)
+        : base(IpcMessageType.KeepOnDeviceCommand)
+    {
+        _syncRootPathProvider = syncRootPathProvider;
+        _hydrationScheduler = hydrationScheduler;
+    }
+
+    public override async Task HandleAsync<T>(IReadOnlyList<string>? paths, T responder, CancellationToken cancellationToken)
+    {
+        if (paths is null || paths.Count == 0)
+        {
+            return;
+        }
+
+        var syncRootPaths = _syncRootPathProvider.GetOfTypes([MappingType.CloudFiles]);
+
+        // Only items inside Cloud Files sync roots have placeholders
+        var validPaths = paths
+            .Where(path => syncRootPaths.Any(rootPath => PathComparison.IsAncestor(rootPath, path)))
+            .ToList();
+
+        await _hydrationScheduler.KeepOnDeviceAsync(validPaths, cancellationToken).ConfigureAwait(false);
+    }
+}
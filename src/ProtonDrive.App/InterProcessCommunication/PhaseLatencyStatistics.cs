@@ -0,0 +1,14 @@
+﻿using System.Text.Json.Serialization;
+
+namespace ProtonDrive.App.InterProcessCommunication;
+
+/// <summary>
+/// Latency percentiles of a shell extension phase, in microseconds.
+/// </summary>
+public sealed record PhaseLatencyStatistics(
+    [property: JsonPropertyName("phase")] string? Phase,
+    [property: JsonPropertyName("count")] long Count,
+    [property: JsonPropertyName("p50")] long P50,
+    [property: JsonPropertyName("p95")] long P95,
+    [property: JsonPropertyName("p99")] long P99,
+    [property: JsonPropertyName("max")] long Max);
@@ -0,0 +1,7 @@
+﻿using System.Text.Json.Serialization;
+
+namespace ProtonDrive.App.InterProcessCommunication;
+
+public sealed record PrepareShareHint(
+    [property: JsonPropertyName("shareId")] string? ShareId,
+    [property: JsonPropertyName("linkId")] string? LinkId);
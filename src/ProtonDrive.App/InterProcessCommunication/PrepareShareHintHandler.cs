@@ -0,0 +1,31 @@
+﻿using System.Threading;
+using System.Threading.Tasks;
+using ProtonDrive.App.Sharing;
+
+namespace ProtonDrive.App.InterProcessCommunication;
+
+/// <summary>
+/// Handles the hint that the user is likely to share an item, sent by the shell extension when it offers sharing the item.
+/// </summary>
+internal sealed class PrepareShareHintHandler : IpcMessageHandlerBase<PrepareShareHint>
+{
+    private readonly SharePreparer _sharePreparer;
+
+    public PrepareShareHintHandler(SharePreparer sharePreparer)
+        : base(IpcMessageType.PrepareShareHint)
+    {
+        _sharePreparer = sharePreparer;
+    }
+
+    public override Task HandleAsync<T>(PrepareShareHint? hint, T responder, CancellationToken cancellationToken)
+    {
+        if (string.IsNullOrEmpty(hint?.ShareId) || string.IsNullOrEmpty(hint.LinkId))
+        {
+            return Task.CompletedTask;
+        }
+
+        _sharePreparer.PrepareSpeculatively(hint.ShareId, hint.LinkId);
+
+        return Task.CompletedTask;
+    }
+}
@@ -0,0 +1,29 @@
+﻿using System.Threading;
+using System.Threading.Tasks;
+using ProtonDrive.App.Sharing;
+
+namespace ProtonDrive.App.InterProcessCommunication;
+
+/// <summary>
+/// Handles the request to share by link the item selected in the shell.
+/// </summary>
+internal sealed class ShareByUrlCommandHandler : IpcMessageHandlerBase<string>
+{
+    private readonly ShareLinkOpener _shareLinkOpener;
+
+    public ShareByUrlCommandHandler(ShareLinkOpener shareLinkOpener)
+        : base(IpcMessageType.ShareByUrlCommand)
+    {
+        _shareLinkOpener = shareLinkOpener;
+    }
+
+    public override async Task HandleAsync<T>(string? path, T responder, CancellationToken cancellationToken)
+    {
+        if (string.IsNullOrEmpty(path))
+        {
+            return;
+        }
+
+        await _shareLinkOpener.TryOpenAsync(path, CancellationToken.None).ConfigureAwait(false);
+    }
+}
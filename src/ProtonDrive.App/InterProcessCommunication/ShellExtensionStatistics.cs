@@ -0,0 +1,12 @@
+﻿using System.Collections.Generic;
+using System.Text.Json.Serialization;
+
+namespace ProtonDrive.App.InterProcessCommunication;
+
+public sealed record ShellExtensionStatistics(
+    [property: JsonPropertyName("hostProcessPolicy")] string? HostProcessPolicy,
+    [property: JsonPropertyName("firstUseWorkingSetIncrease")] long FirstUseWorkingSetIncrease,
+    [property: JsonPropertyName("latencies")] IReadOnlyList<PhaseLatencyStatistics>? Latencies,
+    [property: JsonPropertyName("degradationMode")] string? DegradationMode,
+    [property: JsonPropertyName("degradationModeChanges")] IReadOnlyList<DegradationModeChangeStatistics>? DegradationModeChanges,
+    [property: JsonPropertyName("allocations")] IReadOnlyList<AllocationGauge>? Allocations);
@@ -0,0 +1,67 @@
+﻿using System.Threading;
+using System.Threading.Tasks;
+using Microsoft.Extensions.Logging;
+
+namespace ProtonDrive.App.InterProcessCommunication;
+
+/// <summary>
+/// Logs the statistics periodically reported by the shell extension instances.
+/// </summary>
+internal sealed class ShellExtensionStatisticsReportHandler : IpcMessageHandlerBase<ShellExtensionStatistics>
+{
+    private readonly ILogger<ShellExtensionStatisticsReportHandler> _logger;
+
+    public ShellExtensionStatisticsReportHandler(ILogger<ShellExtensionStatisticsReportHandler> logger)
+        : base(IpcMessageType.ShellExtensionStatisticsReport)
+    {
+        _logger = logger;
+    }
+
+    public override Task HandleAsync<T>(ShellExtensionStatistics? statistics, T responder, CancellationToken cancellationToken)
+    {
+        if (statistics?.Latencies is null)
+        {
+            return Task.CompletedTask;
+        }
+
+        _logger.LogInformation(
+            "Shell extension statistics: HostProcessPolicy={HostProcessPolicy}, FirstUseWorkingSetIncrease={FirstUseWorkingSetIncrease}, DegradationMode={DegradationMode}",
+            statistics.HostProcessPolicy,
+            statistics.FirstUseWorkingSetIncrease,
+            statistics.DegradationMode);
+
+        foreach (var modeChange in statistics.DegradationModeChanges ?? [])
+        {
+            _logger.LogWarning(
+                "Shell extension degradation mode changed from {PreviousMode} to {Mode}, {NumberOfSlowSamples} slow context menus",
+                modeChange.PreviousMode,
+                modeChange.Mode,
+                modeChange.NumberOfSlowSamples);
+        }
+
+        foreach (var latency in statistics.Latencies)
+        {
+            _logger.LogInformation(
+                "Shell extension latency of {Phase}: Count={Count}, P50={P50}us, P95={P95}us, P99={P99}us, Max={Max}us",
+                latency.Phase,
+                latency.Count,
+                latency.P50,
+                latency.P95,
+                latency.P99,
+                latency.Max);
+        }
+
+        foreach (var allocation in statistics.Allocations ?? [])
+        {
+            _logger.LogInformation(
+                "Shell extension allocations of {Subsystem}: Bytes={Bytes}, Count={Count}, PeakBytes={PeakBytes}, TotalCount={TotalCount}",
+                allocation.Subsystem,
+                allocation.Bytes,
+                allocation.Count,
+                allocation.PeakBytes,
+                allocation.TotalCount);
+        }
+
+        return Task.CompletedTask;
+    }
+}
@@ -0,0 +1,29 @@
+﻿namespace ProtonDrive.App.InterProcessCommunication;
+
+public enum SyncRootChangeKind
+{
+    /// <summary>
+    /// The subscription has started or notifications were lost; all cached state must be refreshed.
+    /// </summary>
+    Resync = 0,
+
+    /// <summary>
+    /// Sync roots were added or removed.
+    /// </summary>
+    SyncRootsChanged = 1,
+
+    /// <summary>
+    /// The item at the specified path was renamed or moved.
+    /// </summary>
+    ItemRenamed = 2,
+
+    /// <summary>
+    /// The item at the specified path got a remote counterpart.
+    /// </summary>
+    LinkCreated = 3,
+
+    /// <summary>
+    /// The item at the specified path was deleted, together with its descendants.
+    /// </summary>
+    ItemDeleted = 4,
+}
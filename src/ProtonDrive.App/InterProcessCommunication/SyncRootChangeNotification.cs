@@ -0,0 +1,3 @@
+﻿namespace ProtonDrive.App.InterProcessCommunication;
+
+public sealed record SyncRootChangeNotification(long Generation, SyncRootChangeKind Kind, string? Path = null);
@@ -0,0 +1,119 @@
+﻿using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Threading;
+using System.Threading.Channels;
+using ProtonDrive.App.Mapping;
+using ProtonDrive.App.Settings;
+using ProtonDrive.App.Sync;
+using ProtonDrive.Sync.Shared;
+using ProtonDrive.Sync.Shared.SyncActivity;
+
+namespace ProtonDrive.App.InterProcessCommunication;
+
+/// <summary>
+/// Publishes sync root and mapping changes to the subscribed IPC clients.
+/// </summary>
+/// <remarks>
+/// Every notification gets the next generation number. Subscribers that cannot keep up lose the oldest
+/// notifications, which the client detects as a gap in the generation sequence.
+/// </remarks>
+internal sealed class SyncRootChangeNotifier : IMappingsSetupStateAware, ISyncActivityAware
+{
+    private const int SubscriberQueueCapacity = 256;
+
+    private readonly object _lock = new();
+    private readonly List<Channel<SyncRootChangeNotification>> _subscribers = [];
+
+    private long _generation;
+    private IReadOnlySet<string> _syncRootPaths = new HashSet<string>();
+
+    public ChannelReader<SyncRootChangeNotification> Subscribe(out long generation)
+    {
+        var channel = Channel.CreateBounded<SyncRootChangeNotification>(
+            new BoundedChannelOptions(SubscriberQueueCapacity)
+            {
+                SingleReader = true,
+                FullMode = BoundedChannelFullMode.DropOldest,
+            });
+
+        lock (_lock)
+        {
+            _subscribers.Add(channel);
+            generation = _generation;
+        }
+
+        return channel.Reader;
+    }
+
+    public void Unsubscribe(ChannelReader<SyncRootChangeNotification> reader)
+    {
+        lock (_lock)
+        {
+            _subscribers.RemoveAll(x => x.Reader == reader);
+        }
+    }
+
+    void IMappingsSetupStateAware.OnMappingsSetupStateChanged(MappingsSetupState value)
+    {
+        var syncRootPaths = value.Mappings
+            .Where(mapping => mapping.Status == MappingStatus.Complete)
+            .Select(mapping => mapping.Local.RootFolderPath)
+            .ToHashSet(StringComparer.OrdinalIgnoreCase);
+
+        lock (_lock)
+        {
+            if (_syncRootPaths.SetEquals(syncRootPaths))
+            {
+                return;
+            }
+
+            _syncRootPaths = syncRootPaths;
+        }
+
+        Publish(SyncRootChangeKind.SyncRootsChanged, path: null);
+    }
+
+    void ISyncActivityAware.OnSyncActivityChanged(SyncActivityItem<long> item)
+    {
+        if (item.Status is not SyncActivityItemStatus.Succeeded)
+        {
+            return;
+        }
+
+        var kind = item switch
+        {
+            { ActivityType: SyncActivityType.Rename or SyncActivityType.Move } => SyncRootChangeKind.ItemRenamed,
+            { ActivityType: SyncActivityType.Create or SyncActivityType.Upload, Replica: Replica.Remote } => SyncRootChangeKind.LinkCreated,
+            { ActivityType: SyncActivityType.Delete } => SyncRootChangeKind.ItemDeleted,
+            _ => default(SyncRootChangeKind?),
+        };
+
+        if (kind is null)
+        {
+            return;
+        }
+
+        Publish(kind.Value, Path.Combine(item.LocalRootPath, item.RelativeParentFolderPath, item.Name));
+    }
+
+    private void Publish(SyncRootChangeKind kind, string? path)
+    {
+        lock (_lock)
+        {
+            if (_subscribers.Count == 0)
+            {
+                // Generation is only meaningful to subscribers, there is nobody to notify
+                return;
+            }
+
+            var notification = new SyncRootChangeNotification(Interlocked.Increment(ref _generation), kind, path);
+
+            foreach (var subscriber in _subscribers)
+            {
+                subscriber.Writer.TryWrite(notification);
+            }
+        }
+    }
+}
@@ -0,0 +1,48 @@
+﻿using System;
+using System.IO;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace ProtonDrive.App.InterProcessCommunication;
+
+/// <summary>
+/// Keeps the connection open and pushes sync root and mapping change notifications to the client.
+/// </summary>
+internal sealed class SyncRootChangesSubscriptionHandler : IpcMessageHandlerBase<object?>
+{
+    private readonly SyncRootChangeNotifier _notifier;
+
+    public SyncRootChangesSubscriptionHandler(SyncRootChangeNotifier notifier)
+        : base(IpcMessageType.SyncRootChangesSubscription)
+    {
+        _notifier = notifier;
+    }
+
+    public override async Task HandleAsync<T>(object? parameters, T responder, CancellationToken cancellationToken)
+    {
+        var notifications = _notifier.Subscribe(out var generation);
+
+        try
+        {
+            // The client treats the first notification as a baseline and refreshes all its cached state
+            await responder.Respond(new SyncRootChangeNotification(generation, SyncRootChangeKind.Resync), cancellationToken).ConfigureAwait(false);
+
+            await foreach (var notification in notifications.ReadAllAsync(cancellationToken).ConfigureAwait(false))
+            {
+                await responder.Respond(notification, cancellationToken).ConfigureAwait(false);
+            }
+        }
+        catch (IOException)
+        {
+            // The client has disconnected
+        }
+        catch (OperationCanceledException)
+        {
+            // The IPC server is stopping
+        }
+        finally
+        {
+            _notifier.Unsubscribe(notifications);
+        }
+    }
+}
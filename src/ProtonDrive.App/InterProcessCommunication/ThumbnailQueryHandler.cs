@@ -0,0 +1,143 @@
+﻿using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.Linq;
+using System.Threading;
+using System.Threading.Tasks;
+using Microsoft.Extensions.Logging;
+using ProtonDrive.App.Sync;
+using ProtonDrive.Client;
+using ProtonDrive.Client.RemoteNodes;
+using ProtonDrive.Shared.Extensions;
+
+namespace ProtonDrive.App.InterProcessCommunication;
+
+/// <summary>
+/// Provides the shell extension with thumbnails of files in Proton Drive without downloading their content,
+/// so that browsing a folder of online-only files in thumbnail view does not hydrate them.
+/// </summary>
+/// <remarks>
+/// Responds with the path of a cached thumbnail image for every queried path, or an empty string if the file has no thumbnail.
+/// Thumbnails not cached yet are downloaded together. Thumbnails not obtained before the time limit are reported as missing.
+/// </remarks>
+internal sealed class ThumbnailQueryHandler : IpcMessageHandlerBase<IReadOnlyList<string>>
+{
+    private const int MaxNumberOfConcurrentLookups = 8;
+
+    // The shell extension stops waiting after 5 seconds
+    private static readonly TimeSpan TimeLimit = TimeSpan.FromSeconds(4);
+
+    private readonly IRemoteIdsFromLocalPathProvider _remoteIdsFromLocalPathProvider;
+    private readonly IRemoteThumbnailClient _remoteThumbnailClient;
+    private readonly ThumbnailCache _thumbnailCache;
+    private readonly ILogger<ThumbnailQueryHandler> _logger;
+
+    public ThumbnailQueryHandler(
+        IRemoteIdsFromLocalPathProvider remoteIdsFromLocalPathProvider,
+        IRemoteThumbnailClient remoteThumbnailClient,
+        ThumbnailCache thumbnailCache,
+        ILogger<ThumbnailQueryHandler> logger)
+        : base(IpcMessageType.ThumbnailQuery)
+    {
+        _remoteIdsFromLocalPathProvider = remoteIdsFromLocalPathProvider;
+        _remoteThumbnailClient = remoteThumbnailClient;
+        _thumbnailCache = thumbnailCache;
+        _logger = logger;
+    }
+
+    public override async Task HandleAsync<T>(IReadOnlyList<string>? paths, T responder, CancellationToken cancellationToken)
+    {
+        if (paths is null || paths.Count == 0)
+        {
+            await responder.Respond<IReadOnlyList<string>>([], cancellationToken).ConfigureAwait(false);
+            return;
+        }
+
+        var thumbnailPaths = Enumerable.Repeat(string.Empty, paths.Count).ToArray();
+        var missingThumbnails = new ConcurrentBag<(int Index, RemoteThumbnailInfo Thumbnail)>();
+
+        using var timeLimitCancellationSource = CancellationTokenSource.CreateLinkedTokenSource(cancellationToken);
+        timeLimitCancellationSource.CancelAfter(TimeLimit);
+
+        try
+        {
+            await Parallel.ForEachAsync(
+                Enumerable.Range(0, paths.Count),
+                new ParallelOptions { MaxDegreeOfParallelism = MaxNumberOfConcurrentLookups, CancellationToken = timeLimitCancellationSource.Token },
+                async (index, ct) =>
+                {
+                    var thumbnail = await GetThumbnailInfoOrDefaultAsync(paths[index], ct).ConfigureAwait(false);
+                    if (thumbnail is null)
+                    {
+                        return;
+                    }
+
+                    if (_thumbnailCache.TryGetPath(thumbnail.LinkId, thumbnail.RevisionId, out var cachedPath))
+                    {
+                        thumbnailPaths[index] = cachedPath;
+                        return;
+                    }
+
+                    missingThumbnails.Add((index, thumbnail));
+                })
+                .ConfigureAwait(false);
+
+            if (!missingThumbnails.IsEmpty)
+            {
+                // The same file can be queried more than once, its thumbnail is downloaded once and shared by all its indexes
+                var missingThumbnailsById = missingThumbnails.GroupBy(x => x.Thumbnail.ThumbnailId).ToList();
+
+                var downloadedThumbnails = await _remoteThumbnailClient.DownloadAsync(
+                    missingThumbnailsById.Select(x => x.First().Thumbnail).ToList(),
+                    timeLimitCancellationSource.Token).ConfigureAwait(false);
+
+                foreach (var thumbnailIndexes in missingThumbnailsById)
+                {
+                    var thumbnail = thumbnailIndexes.First().Thumbnail;
+
+                    if (!downloadedThumbnails.TryGetValue(thumbnail.LinkId, out var content)
+                        || !_thumbnailCache.TryAdd(thumbnail.LinkId, thumbnail.RevisionId, content, out var cachedPath))
+                    {
+                        continue;
+                    }
+
+                    foreach (var (index, _) in thumbnailIndexes)
+                    {
+                        thumbnailPaths[index] = cachedPath;
+                    }
+                }
+            }
+        }
+        catch (Exception ex) when ((ex is OperationCanceledException && !cancellationToken.IsCancellationRequested) || ex.IsDriveClientException())
+        {
+            _logger.LogDebug("Failed to obtain all thumbnails: {ExceptionType} {ErrorCode}", ex.GetType().Name, ex.GetRelevantFormattedErrorCode());
+        }
+
+        cancellationToken.ThrowIfCancellationRequested();
+
+        await responder.Respond<IReadOnlyList<string>>(thumbnailPaths, cancellationToken).ConfigureAwait(false);
+    }
+
+    private async Task<RemoteThumbnailInfo?> GetThumbnailInfoOrDefaultAsync(string path, CancellationToken cancellationToken)
+    {
+        try
+        {
+            var remoteIds = await _remoteIdsFromLocalPathProvider.GetRemoteIdsOrDefaultAsync(path, cancellationToken).ConfigureAwait(false);
+            if (remoteIds is null)
+            {
+                return null;
+            }
+
+            return await _remoteThumbnailClient.GetThumbnailInfoOrDefaultAsync(
+                remoteIds.Value.VolumeId,
+                remoteIds.Value.ShareId,
+                remoteIds.Value.LinkId,
+                cancellationToken).ConfigureAwait(false);
+        }
+        catch (Exception ex) when (ex.IsDriveClientException())
+        {
+            _logger.LogDebug("Failed to get thumbnail information: {ExceptionType} {ErrorCode}", ex.GetType().Name, ex.GetRelevantFormattedErrorCode());
+            return null;
+        }
+    }
+}
@@ -0,0 +1,68 @@
+﻿using System;
+using System.Threading;
+using System.Threading.Tasks;
+using Microsoft.Extensions.Logging;
+using ProtonDrive.App.Sync;
+using ProtonDrive.Client;
+using ProtonDrive.Client.Contracts;
+using ProtonDrive.Shared.Configuration;
+using ProtonDrive.Shared.Diagnostics;
+using ProtonDrive.Shared.Extensions;
+
+namespace ProtonDrive.App.Sharing;
+
+/// <summary>
+/// Opens the item in the web client, where the user creates and manages its share link.
+/// </summary>
+public sealed class ShareLinkOpener
+{
+    private readonly UrlConfig _config;
+    private readonly IRemoteIdsFromLocalPathProvider _remoteIdsFromLocalPathProvider;
+    private readonly SharePreparer _sharePreparer;
+    private readonly IOsProcesses _osProcesses;
+    private readonly ILogger<ShareLinkOpener> _logger;
+
+    public ShareLinkOpener(
+        UrlConfig config,
+        IRemoteIdsFromLocalPathProvider remoteIdsFromLocalPathProvider,
+        SharePreparer sharePreparer,
+        IOsProcesses osProcesses,
+        ILogger<ShareLinkOpener> logger)
+    {
+        _config = config;
+        _remoteIdsFromLocalPathProvider = remoteIdsFromLocalPathProvider;
+        _sharePreparer = sharePreparer;
+        _osProcesses = osProcesses;
+        _logger = logger;
+    }
+
+    public async Task TryOpenAsync(string path, CancellationToken cancellationToken)
+    {
+        try
+        {
+            var remoteIds = await _remoteIdsFromLocalPathProvider.GetRemoteIdsOrDefaultAsync(path, cancellationToken).ConfigureAwait(false);
+
+            if (remoteIds is null)
+            {
+                _logger.LogWarning("Failed to share item: could not get remote identity from local path");
+                return;
+            }
+
+            var (_, shareId, linkId) = remoteIds.Value;
+
+            // Usually prepared while the context menu was shown
+            var linkType = await _sharePreparer.GetPreparedLinkTypeAsync(shareId, linkId, cancellationToken).ConfigureAwait(false);
+
+            var uriBuilder = new UriBuilder(_config.WebClient)
+            {
+                Path = $"{shareId}/{(linkType == LinkType.Folder ? "folder" : "file")}/{linkId}",
+            };
+
+            _osProcesses.Open(uriBuilder.Uri.ToString());
+        }
+        catch (Exception ex) when (ex.IsDriveClientException())
+        {
+            _logger.LogWarning("Failed to share item: {ExceptionType}: {ErrorCode}", ex.GetType().Name, ex.GetRelevantFormattedErrorCode());
+        }
+    }
+}
@@ -0,0 +1,138 @@
+﻿using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.Diagnostics.CodeAnalysis;
+using System.Threading;
+using System.Threading.Tasks;
+using Microsoft.Extensions.Logging;
+using ProtonDrive.Client;
+using ProtonDrive.Client.Contracts;
+using ProtonDrive.Client.RemoteNodes;
+using ProtonDrive.Shared;
+using ProtonDrive.Shared.Extensions;
+using ProtonDrive.Shared.Threading;
+
+namespace ProtonDrive.App.Sharing;
+
+/// <summary>
+/// Retrieves and decrypts the items the user is about to share, so that sharing finds their metadata and keys ready.
+/// </summary>
+/// <remarks>
+/// Speculative preparations, hinted by the shell extension when it offers sharing an item, are dropped rather than queued
+/// when enough of them are running. Each item is prepared at most once within the lifetime of a preparation,
+/// a preparation that failed is forgotten.
+/// </remarks>
+public sealed class SharePreparer
+{
+    private const int MaxNumberOfConcurrentSpeculativePreparations = 2;
+    private const int MaxNumberOfRememberedPreparations = 256;
+
+    private static readonly TimeSpan PreparationLifetime = TimeSpan.FromMinutes(5);
+
+    private readonly IRemoteNodePreloader _remoteNodePreloader;
+    private readonly IClock _clock;
+    private readonly ILogger<SharePreparer> _logger;
+
+    private readonly ConcurrentDictionary<string, Preparation> _preparations = new();
+    private int _numberOfSpeculativePreparations;
+
+    public SharePreparer(IRemoteNodePreloader remoteNodePreloader, IClock clock, ILogger<SharePreparer> logger)
+    {
+        _remoteNodePreloader = remoteNodePreloader;
+        _clock = clock;
+        _logger = logger;
+    }
+
+    public void PrepareSpeculatively(string shareId, string linkId)
+    {
+        var now = _clock.UtcNow;
+
+        // The same item is hinted every time the context menu is shown
+        if (TryGetPreparation(linkId, now, out _))
+        {
+            return;
+        }
+
+        if (_preparations.Count >= MaxNumberOfRememberedPreparations)
+        {
+            RemoveExpiredPreparations(now);
+
+            if (_preparations.Count >= MaxNumberOfRememberedPreparations)
+            {
+                return;
+            }
+        }
+
+        if (Interlocked.Increment(ref _numberOfSpeculativePreparations) > MaxNumberOfConcurrentSpeculativePreparations)
+        {
+            Interlocked.Decrement(ref _numberOfSpeculativePreparations);
+            return;
+        }
+
+        var preparation = new Preparation(PrepareAsync(shareId, linkId), now);
+        _preparations[linkId] = preparation;
+
+        CompleteSpeculativePreparationAsync(linkId, preparation).Forget();
+    }
+
+    /// <summary>
+    /// Gets the type of the item from its preparation, waiting for the preparation in progress or starting a new one when there is none.
+    /// </summary>
+    public Task<LinkType> GetPreparedLinkTypeAsync(string shareId, string linkId, CancellationToken cancellationToken)
+    {
+        var now = _clock.UtcNow;
+
+        if (!TryGetPreparation(linkId, now, out var preparation))
+        {
+            preparation = new Preparation(PrepareAsync(shareId, linkId), now);
+            _preparations[linkId] = preparation;
+        }
+
+        return preparation.Task.WaitAsync(cancellationToken);
+    }
+
+    private bool TryGetPreparation(string linkId, DateTime now, [NotNullWhen(true)] out Preparation? preparation)
+    {
+        return _preparations.TryGetValue(linkId, out preparation)
+            && now - preparation.StartTime < PreparationLifetime
+            && !preparation.Task.IsFaulted
+            && !preparation.Task.IsCanceled;
+    }
+
+    private void RemoveExpiredPreparations(DateTime now)
+    {
+        foreach (var (linkId, preparation) in _preparations)
+        {
+            if (now - preparation.StartTime >= PreparationLifetime)
+            {
+                _preparations.TryRemove(new KeyValuePair<string, Preparation>(linkId, preparation));
+            }
+        }
+    }
+
+    private Task<LinkType> PrepareAsync(string shareId, string linkId)
+    {
+        // Preparations are shared between requests, none of them can cancel it
+        return _remoteNodePreloader.PreloadAsync(shareId, linkId, CancellationToken.None);
+    }
+
+    private async Task CompleteSpeculativePreparationAsync(string linkId, Preparation preparation)
+    {
+        try
+        {
+            await preparation.Task.ConfigureAwait(false);
+        }
+        catch (Exception ex) when (ex.IsDriveClientException())
+        {
+            _logger.LogDebug("Failed to prepare sharing: {ExceptionType}: {ErrorCode}", ex.GetType().Name, ex.GetRelevantFormattedErrorCode());
+
+            _preparations.TryRemove(new KeyValuePair<string, Preparation>(linkId, preparation));
+        }
+        finally
+        {
+            Interlocked.Decrement(ref _numberOfSpeculativePreparations);
+        }
+    }
+
+    private sealed record Preparation(Task<LinkType> Task, DateTime StartTime);
+}
@@ -0,0 +1,120 @@
+﻿using System;
+using System.Diagnostics.CodeAnalysis;
+using System.IO;
+using System.Linq;
+using System.Security.Cryptography;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+using Microsoft.Extensions.Logging;
+using ProtonDrive.App.Account;
+using ProtonDrive.Shared.Configuration;
+
+namespace ProtonDrive.App.Sync;
+
+/// <summary>
+/// Keeps the thumbnails of remote files on disk, so that showing them again downloads nothing.
+/// </summary>
+/// <remarks>
+/// Thumbnails are keyed by link ID and revision ID, a new revision of the file gets a new entry.
+/// The oldest entries are removed when there are too many, all of them on switching user account.
+/// </remarks>
+internal sealed class ThumbnailCache : IAccountSwitchingHandler
+{
+    private const string FolderName = "Thumbnails";
+    private const int MaxNumberOfThumbnails = 10_000;
+    private const int NumberOfAdditionsBetweenTrimmings = 500;
+
+    private readonly ILogger<ThumbnailCache> _logger;
+    private readonly string _folderPath;
+
+    private int _numberOfAdditions;
+
+    public ThumbnailCache(AppConfig appConfig, ILogger<ThumbnailCache> logger)
+    {
+        _logger = logger;
+        _folderPath = Path.Combine(appConfig.AppDataPath, FolderName);
+    }
+
+    public bool TryGetPath(string linkId, string revisionId, [MaybeNullWhen(false)] out string path)
+    {
+        path = GetPath(linkId, revisionId);
+
+        return File.Exists(path);
+    }
+
+    public bool TryAdd(string linkId, string revisionId, byte[] thumbnail, [MaybeNullWhen(false)] out string path)
+    {
+        path = GetPath(linkId, revisionId);
+
+        try
+        {
+            Directory.CreateDirectory(_folderPath);
+
+            // The shell extension reads the file as soon as it gets the path, it must never see a partially written one
+            var temporaryPath = path + ".tmp";
+            File.WriteAllBytes(temporaryPath, thumbnail);
+            File.Move(temporaryPath, path, overwrite: true);
+        }
+        catch (Exception ex) when (ex is IOException or UnauthorizedAccessException)
+        {
+            _logger.LogWarning("Failed to add thumbnail to the cache: {ExceptionType} {ErrorMessage}", ex.GetType().Name, ex.Message);
+            path = null;
+            return false;
+        }
+
+        if (Interlocked.Increment(ref _numberOfAdditions) % NumberOfAdditionsBetweenTrimmings == 0)
+        {
+            Trim();
+        }
+
+        return true;
+    }
+
+    Task<bool> IAccountSwitchingHandler.HandleAccountSwitchingAsync(CancellationToken cancellationToken)
+    {
+        try
+        {
+            if (Directory.Exists(_folderPath))
+            {
+                Directory.Delete(_folderPath, recursive: true);
+            }
+
+            return Task.FromResult(true);
+        }
+        catch (Exception ex) when (ex is IOException or UnauthorizedAccessException)
+        {
+            _logger.LogError("Failed to clear thumbnail cache: {Error}", ex.Message);
+            return Task.FromResult(false);
+        }
+    }
+
+    private string GetPath(string linkId, string revisionId)
+    {
+        // IDs are not guaranteed to be valid file names
+        var key = SHA256.HashData(Encoding.UTF8.GetBytes($"{linkId}/{revisionId}"));
+
+        return Path.Combine(_folderPath, Convert.ToHexString(key));
+    }
+
+    private void Trim()
+    {
+        try
+        {
+            var files = new DirectoryInfo(_folderPath).GetFiles();
+            if (files.Length <= MaxNumberOfThumbnails)
+            {
+                return;
+            }
+
+            foreach (var file in files.OrderBy(x => x.LastWriteTimeUtc).Take(files.Length - MaxNumberOfThumbnails))
+            {
+                file.Delete();
+            }
+        }
+        catch (Exception ex) when (ex is IOException or UnauthorizedAccessException)
+        {
+            _logger.LogWarning("Failed to trim thumbnail cache: {ExceptionType} {ErrorMessage}", ex.GetType().Name, ex.Message);
+        }
+    }
+}
@@ -0,0 +1,17 @@
+﻿using System.Collections.Generic;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace ProtonDrive.App.SystemIntegration;
+
+public interface IContentDuplicateFinder
+{
+    /// <summary>
+    /// Finds files under the specified folders with the same content as each of the specified ones.
+    /// </summary>
+    /// <returns>For every content, the path of a file having it, or null if none was found before cancellation.</returns>
+    Task<IReadOnlyList<string?>> FindAsync(
+        IReadOnlyCollection<string> rootPaths,
+        IReadOnlyList<(long Size, string Sha256)> contents,
+        CancellationToken cancellationToken);
+}
@@ -0,0 +1,18 @@
+﻿using System.Collections.Generic;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace ProtonDrive.App.SystemIntegration;
+
+public interface IPlaceholderHydrationScheduler
+{
+    /// <summary>
+    /// Pins the specified items and hydrates all placeholder files under them.
+    /// </summary>
+    Task KeepOnDeviceAsync(IReadOnlyCollection<string> paths, CancellationToken cancellationToken);
+
+    /// <summary>
+    /// Unpins the specified items, so that all files under them get dehydrated.
+    /// </summary>
+    Task FreeUpSpaceAsync(IReadOnlyCollection<string> paths, CancellationToken cancellationToken);
+}
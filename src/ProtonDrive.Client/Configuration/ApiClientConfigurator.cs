@@ -222,6 +222,8 @@ public static class ApiClientConfigurator
         services.AddSingleton(provider => new Func<IAddressKeyProvider>(provider.GetRequiredService<IAddressKeyProvider>));
         services.AddSingleton<ICryptographyService, CryptographyService>();
         services.AddSingleton<IRemoteNodeService, RemoteNodeService>();
+        services.AddSingleton<IRemoteNodePreloader, RemoteNodePreloader>();
+        services.AddSingleton<IRemoteThumbnailClient, RemoteThumbnailClient>();
 
         services.AddSingleton<IBugReportClient, BugReportClient>();
 
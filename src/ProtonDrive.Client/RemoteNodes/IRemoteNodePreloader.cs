@@ -0,0 +1,15 @@
+﻿using System.Threading;
+using System.Threading.Tasks;
+using ProtonDrive.Client.Contracts;
+
+namespace ProtonDrive.Client.RemoteNodes;
+
+public interface IRemoteNodePreloader
+{
+    /// <summary>
+    /// Retrieves and decrypts the node, its ancestors and their share ahead of time, so that later operations on the node
+    /// find their metadata and keys in the cache.
+    /// </summary>
+    /// <returns>The type of the node.</returns>
+    Task<LinkType> PreloadAsync(string shareId, string linkId, CancellationToken cancellationToken);
+}
@@ -0,0 +1,20 @@
+﻿using System.Collections.Generic;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace ProtonDrive.Client.RemoteNodes;
+
+public interface IRemoteThumbnailClient
+{
+    /// <summary>
+    /// Gets the thumbnail of the active revision of the file from the node metadata, without downloading anything else.
+    /// </summary>
+    /// <returns>Thumbnail information, or null if the file has no thumbnail.</returns>
+    Task<RemoteThumbnailInfo?> GetThumbnailInfoOrDefaultAsync(string volumeId, string shareId, string linkId, CancellationToken cancellationToken);
+
+    /// <summary>
+    /// Downloads and decrypts the thumbnails, listing the thumbnails of the same volume in a single request.
+    /// </summary>
+    /// <returns>Decrypted thumbnails by link ID. Thumbnails that could not be obtained are missing.</returns>
+    Task<IReadOnlyDictionary<string, byte[]>> DownloadAsync(IReadOnlyCollection<RemoteThumbnailInfo> thumbnails, CancellationToken cancellationToken);
+}
@@ -0,0 +1,22 @@
+﻿using System.Threading;
+using System.Threading.Tasks;
+using ProtonDrive.Client.Contracts;
+
+namespace ProtonDrive.Client.RemoteNodes;
+
+internal sealed class RemoteNodePreloader : IRemoteNodePreloader
+{
+    private readonly IRemoteNodeService _remoteNodeService;
+
+    public RemoteNodePreloader(IRemoteNodeService remoteNodeService)
+    {
+        _remoteNodeService = remoteNodeService;
+    }
+
+    public async Task<LinkType> PreloadAsync(string shareId, string linkId, CancellationToken cancellationToken)
+    {
+        var node = await _remoteNodeService.GetRemoteNodeAsync(shareId, linkId, cancellationToken).ConfigureAwait(false);
+
+        return node is RemoteFolder ? LinkType.Folder : LinkType.File;
+    }
+}
@@ -0,0 +1,155 @@
+﻿using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Net.Http;
+using System.Threading;
+using System.Threading.Tasks;
+using CommunityToolkit.HighPerformance;
+using Microsoft.Extensions.Logging;
+using Proton.Security.Cryptography;
+using Proton.Security.Cryptography.Abstractions;
+using ProtonDrive.Client.Configuration;
+using ProtonDrive.Client.Contracts;
+using ProtonDrive.Client.Cryptography;
+using ProtonDrive.Client.Volumes;
+using ProtonDrive.Shared.Extensions;
+
+namespace ProtonDrive.Client.RemoteNodes;
+
+internal sealed class RemoteThumbnailClient : IRemoteThumbnailClient
+{
+    private const int DefaultThumbnailType = 1;
+    private const int MaxNumberOfConcurrentDownloads = 4;
+
+    // The thumbnail listing endpoint accepts a limited number of IDs per request
+    private const int MaxNumberOfThumbnailsPerRequest = 30;
+
+    private readonly IRemoteNodeService _remoteNodeService;
+    private readonly IVolumeApiClient _volumeApiClient;
+    private readonly IHttpClientFactory _httpClientFactory;
+    private readonly ICryptographyService _cryptographyService;
+    private readonly ILogger<RemoteThumbnailClient> _logger;
+
+    public RemoteThumbnailClient(
+        IRemoteNodeService remoteNodeService,
+        IVolumeApiClient volumeApiClient,
+        IHttpClientFactory httpClientFactory,
+        ICryptographyService cryptographyService,
+        ILogger<RemoteThumbnailClient> logger)
+    {
+        _remoteNodeService = remoteNodeService;
+        _volumeApiClient = volumeApiClient;
+        _httpClientFactory = httpClientFactory;
+        _cryptographyService = cryptographyService;
+        _logger = logger;
+    }
+
+    public async Task<RemoteThumbnailInfo?> GetThumbnailInfoOrDefaultAsync(string volumeId, string shareId, string linkId, CancellationToken cancellationToken)
+    {
+        var remoteNode = await _remoteNodeService.GetRemoteNodeAsync(shareId, linkId, cancellationToken).ConfigureAwait(false);
+
+        if (remoteNode is not RemoteFile { ActiveRevision: { } activeRevision })
+        {
+            return null;
+        }
+
+        var thumbnail = activeRevision.Thumbnails.FirstOrDefault(x => x.Type == DefaultThumbnailType);
+
+        return thumbnail is not null
+            ? new RemoteThumbnailInfo(volumeId, shareId, linkId, activeRevision.Id, thumbnail.Id)
+            : null;
+    }
+
+    public async Task<IReadOnlyDictionary<string, byte[]>> DownloadAsync(IReadOnlyCollection<RemoteThumbnailInfo> thumbnails, CancellationToken cancellationToken)
+    {
+        var result = new ConcurrentDictionary<string, byte[]>();
+
+        foreach (var volumeThumbnails in thumbnails.GroupBy(x => x.VolumeId))
+        {
+            // Duplicates would waste room in the requests and break the lookup by ID
+            foreach (var chunk in volumeThumbnails.DistinctBy(x => x.ThumbnailId).Chunk(MaxNumberOfThumbnailsPerRequest))
+            {
+                var thumbnailsByIds = chunk.ToDictionary(x => x.ThumbnailId);
+
+                var parameters = new ThumbnailQueryParameters { ThumbnailIds = thumbnailsByIds.Keys };
+                var thumbnailListResponse = await _volumeApiClient.GetThumbnailsAsync(volumeThumbnails.Key, parameters, cancellationToken)
+                    .ThrowOnFailure()
+                    .ConfigureAwait(false);
+
+                await Parallel.ForEachAsync(
+                    thumbnailListResponse.Thumbnails.Where(x => thumbnailsByIds.ContainsKey(x.Id)),
+                    new ParallelOptions { MaxDegreeOfParallelism = MaxNumberOfConcurrentDownloads, CancellationToken = cancellationToken },
+                    async (thumbnailBlock, ct) =>
+                    {
+                        var thumbnail = thumbnailsByIds[thumbnailBlock.Id];
+
+                        try
+                        {
+                            result[thumbnail.LinkId] = await DownloadAsync(thumbnail, thumbnailBlock, ct).ConfigureAwait(false);
+                        }
+                        catch (Exception ex) when (ex.IsDriveClientException() || ex is HttpRequestException)
+                        {
+                            _logger.LogWarning(
+                                "Failed to download thumbnail for LinkID={LinkId} and RevisionID={RevisionId}: {ExceptionType} {ErrorCode}",
+                                thumbnail.LinkId,
+                                thumbnail.RevisionId,
+                                ex.GetType().Name,
+                                ex.GetRelevantFormattedErrorCode());
+                        }
+                    })
+                    .ConfigureAwait(false);
+            }
+        }
+
+        return result;
+    }
+
+    private async Task<byte[]> DownloadAsync(RemoteThumbnailInfo thumbnail, ThumbnailBlock thumbnailBlock, CancellationToken cancellationToken)
+    {
+        // Served from the node cache, the node was retrieved when getting the thumbnail information
+        var remoteNode = await _remoteNodeService.GetRemoteNodeAsync(thumbnail.ShareId, thumbnail.LinkId, cancellationToken).ConfigureAwait(false);
+
+        if (remoteNode is not RemoteFile { ActiveRevision: { } activeRevision } remoteFile)
+        {
+            throw new ApiException(ResponseCode.InvalidValue, "The specified file has no active revision.");
+        }
+
+        var decrypter = await _cryptographyService.CreateFileContentsBlockDecrypterAsync(
+            remoteFile.PrivateKey,
+            activeRevision.SignatureEmailAddress,
+            cancellationToken).ConfigureAwait(false);
+
+        var httpClient = _httpClientFactory.CreateClient(ApiClientConfigurator.BlocksHttpClientName);
+        var thumbnailUrl = Path.Join(thumbnailBlock.BareUrl, "/", thumbnailBlock.Token);
+        var response = await httpClient.GetAsync(thumbnailUrl, cancellationToken).ThrowOnFailure().ConfigureAwait(false);
+        var encryptedThumbnail = await response.Content.ReadAsByteArrayAsync(cancellationToken).ConfigureAwait(false);
+
+        // Thumbnails are encrypted with the content session key and signed inline
+        var messageStream = new ConcatenatingStream(remoteFile.ContentKeyPacket.AsStream(), encryptedThumbnail.AsMemory().AsStream());
+        var messageSource = new PgpMessageSource(messageStream);
+        await using (messageSource.ConfigureAwait(false))
+        {
+            var (decryptingStream, verificationTask) = decrypter.GetDecryptingAndVerifyingStream(messageSource);
+
+            await using (decryptingStream.ConfigureAwait(false))
+            {
+                var plainThumbnail = new MemoryStream();
+                await decryptingStream.CopyToAsync(plainThumbnail, cancellationToken).ConfigureAwait(false);
+
+                var verificationVerdict = await verificationTask.ConfigureAwait(false);
+                if (verificationVerdict != VerificationVerdict.ValidSignature)
+                {
+                    _logger.LogWarning(
+                        "Signature problem on thumbnail for LinkID={LinkId} and RevisionID={RevisionId}: {VerificationResultCode}",
+                        thumbnail.LinkId,
+                        thumbnail.RevisionId,
+                        verificationVerdict);
+                }
+
+                return plainThumbnail.ToArray();
+            }
+        }
+    }
+}
@@ -0,0 +1,3 @@
+﻿namespace ProtonDrive.Client.RemoteNodes;
+
+public sealed record RemoteThumbnailInfo(string VolumeId, string ShareId, string LinkId, string RevisionId, string ThumbnailId);
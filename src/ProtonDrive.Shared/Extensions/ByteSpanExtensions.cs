@@ -0,0 +1,21 @@
+﻿using System;
+
+namespace ProtonDrive.Shared.Extensions;
+
+public static class ByteSpanExtensions
+{
+    /// <summary>
+    /// Computes the FNV-1a hash, the checksum of the messages and records written by the shell extension.
+    /// </summary>
+    public static uint GetFnv1aHash(this ReadOnlySpan<byte> bytes)
+    {
+        var hash = 2166136261U;
+        foreach (var value in bytes)
+        {
+            hash ^= value;
+            hash *= 16777619U;
+        }
+
+        return hash;
+    }
+}
@@ -0,0 +1,98 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Text.Json;
+using System.Text.Json.Serialization;
+
+namespace ProtonDrive.Shared.Text.Serialization;
+
+/// <summary>
+/// Serializes string lists front-coded: a string preceded by a number shares that many leading UTF-16 code units
+/// with the previous string of the list. A plain array of strings is a valid front-coded list.
+/// </summary>
+/// <remarks>
+/// The order of the list is preserved, callers wanting better compression of unordered lists sort them beforehand.
+/// </remarks>
+public sealed class FrontCodedStringListJsonConverter : JsonConverter<IReadOnlyList<string>>
+{
+    public override IReadOnlyList<string>? Read(ref Utf8JsonReader reader, Type typeToConvert, JsonSerializerOptions options)
+    {
+        if (reader.TokenType == JsonTokenType.Null)
+        {
+            return null;
+        }
+
+        if (reader.TokenType != JsonTokenType.StartArray)
+        {
+            throw new JsonException(
+                $"Unexpected token type '{reader.TokenType}', expected '{nameof(JsonTokenType.StartArray)}'");
+        }
+
+        var items = new List<string>();
+        int? sharedPrefixLength = null;
+
+        while (reader.Read())
+        {
+            switch (reader.TokenType)
+            {
+                case JsonTokenType.EndArray when sharedPrefixLength is null:
+                    return items;
+
+                case JsonTokenType.Number when sharedPrefixLength is null && items.Count > 0:
+                    if (!reader.TryGetInt32(out var length) || length < 0 || length > items[^1].Length)
+                    {
+                        throw new JsonException("Shared prefix length is out of range");
+                    }
+
+                    sharedPrefixLength = length;
+                    break;
+
+                case JsonTokenType.String:
+                    var value = reader.GetString() ?? string.Empty;
+
+                    items.Add(sharedPrefixLength is { } prefixLength ? string.Concat(items[^1].AsSpan(0, prefixLength), value) : value);
+                    sharedPrefixLength = null;
+                    break;
+
+                default:
+                    throw new JsonException($"Unexpected token type '{reader.TokenType}' in front-coded string list");
+            }
+        }
+
+        throw new JsonException("Unexpected end of front-coded string list");
+    }
+
+    public override void Write(Utf8JsonWriter writer, IReadOnlyList<string> value, JsonSerializerOptions options)
+    {
+        writer.WriteStartArray();
+
+        var previous = string.Empty;
+
+        foreach (var item in value)
+        {
+            var sharedPrefixLength = GetSharedPrefixLength(previous, item);
+            if (sharedPrefixLength > 0)
+            {
+                writer.WriteNumberValue(sharedPrefixLength);
+            }
+
+            writer.WriteStringValue(item.AsSpan(sharedPrefixLength));
+
+            previous = item;
+        }
+
+        writer.WriteEndArray();
+    }
+
+    private static int GetSharedPrefixLength(string previous, string current)
+    {
+        var length = previous.AsSpan().CommonPrefixLength(current);
+
+        // The suffix would start with a lone low surrogate, which is not valid UTF-16
+        if (length > 0 && char.IsHighSurrogate(previous[length - 1]))
+        {
+            --length;
+        }
+
+        return length;
+    }
+}
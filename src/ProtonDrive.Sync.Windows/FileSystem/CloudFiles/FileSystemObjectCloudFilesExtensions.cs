@@ -19,6 +19,11 @@ public static class FileSystemObjectCloudFilesExtensions
         CfSetPinState(fsObject.FileHandle, state, flags).ThrowExceptionForHR();
     }
 
+    public static void HydratePlaceholder(this FileSystemObject fsObject)
+    {
+        CfHydratePlaceholder(fsObject.FileHandle).ThrowExceptionForHR();
+    }
+
     public static void RevertPlaceholder(this FileSystemObject fsObject)
     {
         CfRevertPlaceholder(fsObject.FileHandle, CF_REVERT_FLAGS.CF_REVERT_FLAG_NONE, IntPtr.Zero).ThrowExceptionForHR();